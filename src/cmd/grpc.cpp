@@ -1,6 +1,8 @@
 #include "handler/grpc.cpp"
 
 int main() {
-  grpcHandler::RunServer();
+  OrtoolsLib::SolverService solver(
+      OrtoolsLib::SolverService::Options::fromEnvironment());
+  grpcHandler::RunServer(solver);
   return 0;
 }
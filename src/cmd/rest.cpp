@@ -3,6 +3,14 @@
 #include "handler/rest.cpp"
 
 int main() {
+  auto solver = std::make_shared<OrtoolsLib::SolverService>(
+      OrtoolsLib::SolverService::Options::fromEnvironment());
+  drogon::app().registerController(
+      std::make_shared<v1::routing::route>(solver));
+  drogon::app().registerController(
+      std::make_shared<v1::routing::session>(solver));
+  drogon::app().registerController(std::make_shared<v1::routing::job>(solver));
+
   std::cout << "server started at http://127.0.0.1:8848" << std::endl;
   drogon::app().addListener("127.0.0.1", 8848).run();
   return 0;
@@ -0,0 +1,114 @@
+#include "routingDto.h"
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <routing-proto/routing.grpc.pb.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/routing.h"
+
+// DurationMatrix is what allocates over-aligned arrays, so counting them
+// counts matrix buffers
+namespace {
+std::atomic<size_t> g_aligned_allocations{0};
+
+const std::vector<std::vector<int64_t>> g_matrix = {
+    {0, 10, 15, 20, 25},
+    {10, 0, 35, 25, 30},
+    {15, 35, 0, 30, 10},
+    {20, 25, 30, 0, 15},
+    {25, 30, 10, 15, 0},
+};
+
+// as the handlers build it
+OrtoolsLib::Routing build(RoutingDTO::RoutingModel model) {
+  return OrtoolsLib::Routing::builder()
+      .setDurationMatrix(std::move(model.duration_matrix))
+      .setDepotConfig(std::move(model.depot_config))
+      .setNumVehicles(model.num_vehicles)
+      .setTimeLimit(model.time_limit)
+      .withSearchOptions(std::move(model.search_options))
+      .build();
+}
+
+int64_t totalDuration(const std::vector<OrtoolsLib::RoutingResponse> &r) {
+  int64_t total = 0;
+  for (const auto &response : r) {
+    total += response.total_duration;
+  }
+  return total;
+}
+} // namespace
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  ++g_aligned_allocations;
+  return ::operator new(size, alignment);
+}
+
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept {
+  ::operator delete(ptr, alignment);
+}
+
+TEST(MatrixAllocation, JsonMatrixIsAllocatedOnce) {
+  auto json = std::make_shared<Json::Value>();
+  for (const auto &row : g_matrix) {
+    Json::Value values(Json::arrayValue);
+    for (const int64_t value : row) {
+      values.append(Json::Int64(value));
+    }
+    (*json)["durationMatrix"].append(values);
+  }
+  (*json)["routingMode"]["type"] = "depot";
+  (*json)["routingMode"]["payload"]["depot"] = 0;
+
+  const size_t before = g_aligned_allocations;
+  const OrtoolsLib::Routing routing = build(RoutingDTO::parseJSON(json));
+  EXPECT_EQ(g_aligned_allocations - before, 1);
+
+  EXPECT_EQ(totalDuration(routing.solve()), 75);
+}
+
+TEST(MatrixAllocation, FlatProtoMatrixIsNeverCopied) {
+  routing::RoutingRequest request;
+  request.set_numvehicles(1);
+  request.set_depot(0);
+  request.mutable_flatdurationmatrix()->set_n(g_matrix.size());
+  for (const auto &row : g_matrix) {
+    for (const int64_t value : row) {
+      request.mutable_flatdurationmatrix()->add_values(value);
+    }
+  }
+
+  const size_t before = g_aligned_allocations;
+  const OrtoolsLib::Routing routing = build(RoutingDTO::viewEntity(&request));
+  EXPECT_EQ(g_aligned_allocations - before, 0);
+
+  EXPECT_EQ(totalDuration(routing.solve()), 75);
+}
+
+TEST(MatrixAllocation, RaggedMatrixIsRejectedBeforeAllocating) {
+  // many short rows must not size an n * n buffer
+  std::string body = R"({"durationMatrix": [)";
+  auto json = std::make_shared<Json::Value>();
+  routing::RoutingRequest request;
+  for (int i = 0; i < 1000; ++i) {
+    body += i == 0 ? "[]" : ", []";
+    (*json)["durationMatrix"].append(Json::Value(Json::arrayValue));
+    request.add_durationmatrix();
+  }
+  body += "]}";
+
+  const size_t before = g_aligned_allocations;
+  EXPECT_THROW(RoutingDTO::parseJSON(json), RoutingDTO::ParseErrorElement);
+  EXPECT_THROW(RoutingDTO::parseJSONBody(body), RoutingDTO::ParseErrorElement);
+  EXPECT_THROW(RoutingDTO::intoEntity(&request), RoutingDTO::ParseErrorElement);
+  EXPECT_EQ(g_aligned_allocations - before, 0);
+}
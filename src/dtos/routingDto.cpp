@@ -1,23 +1,366 @@
 
 #include "routingDto.h"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <format>
 #include <json/json.h>
 #include <lib/routing.h>
+#include <lib/routingSession.h>
+#include <memory>
 #include <optional>
 #include <routing-proto/routing.grpc.pb.h>
+#include <simdjson.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace RoutingDTO {
-RoutingModel intoEntity(const routing::RoutingRequest *const request) noexcept {
-  std::vector<std::vector<int64_t>> duration_matrix;
-  for (const auto &row : request->durationmatrix()) {
-    std::vector<int64_t> row_vector(row.value().begin(), row.value().end());
-    duration_matrix.push_back(row_vector);
+namespace {
+const std::vector<std::pair<std::string, OrtoolsLib::FirstSolutionStrategy>>
+    kFirstSolutionStrategies{
+        {"AUTOMATIC", OrtoolsLib::FirstSolutionStrategy::AUTOMATIC},
+        {"PATH_CHEAPEST_ARC",
+         OrtoolsLib::FirstSolutionStrategy::PATH_CHEAPEST_ARC},
+        {"PATH_MOST_CONSTRAINED_ARC",
+         OrtoolsLib::FirstSolutionStrategy::PATH_MOST_CONSTRAINED_ARC},
+        {"SAVINGS", OrtoolsLib::FirstSolutionStrategy::SAVINGS},
+        {"SWEEP", OrtoolsLib::FirstSolutionStrategy::SWEEP},
+        {"CHRISTOFIDES", OrtoolsLib::FirstSolutionStrategy::CHRISTOFIDES},
+        {"PARALLEL_CHEAPEST_INSERTION",
+         OrtoolsLib::FirstSolutionStrategy::PARALLEL_CHEAPEST_INSERTION},
+        {"LOCAL_CHEAPEST_INSERTION",
+         OrtoolsLib::FirstSolutionStrategy::LOCAL_CHEAPEST_INSERTION},
+        {"GLOBAL_CHEAPEST_ARC",
+         OrtoolsLib::FirstSolutionStrategy::GLOBAL_CHEAPEST_ARC},
+        {"LOCAL_CHEAPEST_ARC",
+         OrtoolsLib::FirstSolutionStrategy::LOCAL_CHEAPEST_ARC},
+        {"FIRST_UNBOUND_MIN_VALUE",
+         OrtoolsLib::FirstSolutionStrategy::FIRST_UNBOUND_MIN_VALUE},
+    };
+
+const std::vector<std::pair<std::string, OrtoolsLib::LocalSearchMetaheuristic>>
+    kLocalSearchMetaheuristics{
+        {"AUTOMATIC", OrtoolsLib::LocalSearchMetaheuristic::AUTOMATIC},
+        {"GREEDY_DESCENT",
+         OrtoolsLib::LocalSearchMetaheuristic::GREEDY_DESCENT},
+        {"GUIDED_LOCAL_SEARCH",
+         OrtoolsLib::LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH},
+        {"SIMULATED_ANNEALING",
+         OrtoolsLib::LocalSearchMetaheuristic::SIMULATED_ANNEALING},
+        {"TABU_SEARCH", OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH},
+        {"GENERIC_TABU_SEARCH",
+         OrtoolsLib::LocalSearchMetaheuristic::GENERIC_TABU_SEARCH},
+    };
+
+template <class Enum>
+Enum parseEnum(const Json::Value &value, const std::string &key,
+               const std::vector<std::pair<std::string, Enum>> &names) {
+  if (value.isString()) {
+    for (const auto &[name, parsed] : names) {
+      if (name == value.asString()) {
+        return parsed;
+      }
+    }
+  }
+
+  std::string expected = "expected to be enum of";
+  for (size_t i = 0; i < names.size(); ++i) {
+    expected += std::format("{} '{}'", i == 0 ? "" : " |", names[i].first);
+  }
+  throw ParseErrorElement(key, {expected});
+}
+
+OrtoolsLib::FirstSolutionStrategy
+fromProto(routing::FirstSolutionStrategy strategy) {
+  switch (strategy) {
+  case routing::PATH_CHEAPEST_ARC:
+    return OrtoolsLib::FirstSolutionStrategy::PATH_CHEAPEST_ARC;
+  case routing::PATH_MOST_CONSTRAINED_ARC:
+    return OrtoolsLib::FirstSolutionStrategy::PATH_MOST_CONSTRAINED_ARC;
+  case routing::SAVINGS:
+    return OrtoolsLib::FirstSolutionStrategy::SAVINGS;
+  case routing::SWEEP:
+    return OrtoolsLib::FirstSolutionStrategy::SWEEP;
+  case routing::CHRISTOFIDES:
+    return OrtoolsLib::FirstSolutionStrategy::CHRISTOFIDES;
+  case routing::PARALLEL_CHEAPEST_INSERTION:
+    return OrtoolsLib::FirstSolutionStrategy::PARALLEL_CHEAPEST_INSERTION;
+  case routing::LOCAL_CHEAPEST_INSERTION:
+    return OrtoolsLib::FirstSolutionStrategy::LOCAL_CHEAPEST_INSERTION;
+  case routing::GLOBAL_CHEAPEST_ARC:
+    return OrtoolsLib::FirstSolutionStrategy::GLOBAL_CHEAPEST_ARC;
+  case routing::LOCAL_CHEAPEST_ARC:
+    return OrtoolsLib::FirstSolutionStrategy::LOCAL_CHEAPEST_ARC;
+  case routing::FIRST_UNBOUND_MIN_VALUE:
+    return OrtoolsLib::FirstSolutionStrategy::FIRST_UNBOUND_MIN_VALUE;
+  default:
+    return OrtoolsLib::FirstSolutionStrategy::AUTOMATIC;
+  }
+}
+
+std::vector<OrtoolsLib::TimeWindow> fromProto(const routing::timeWindow &tws) {
+  std::vector<OrtoolsLib::TimeWindow> time_windows;
+  time_windows.reserve(tws.pairs_size());
+  for (const auto &tw : tws.pairs()) {
+    time_windows.emplace_back(OrtoolsLib::TimeWindow{
+        .start = tw.a(),
+        .end = tw.b(),
+    });
+  }
+  return time_windows;
+}
+
+int32_t parseInt(const Json::Value &payload, const std::string &name,
+                 const std::string &key) {
+  if (!payload.isMember(name)) {
+    throw ParseErrorElement(key, {"value is required"});
+  }
+  if (!payload[name].isInt()) {
+    throw ParseErrorElement(key, {"value is not integer"});
+  }
+  return payload[name].asInt();
+}
+
+int64_t parseInt64(const Json::Value &payload, const std::string &name,
+                   const std::string &key, int64_t fallback) {
+  if (!payload.isMember(name)) {
+    return fallback;
+  }
+  if (!payload[name].isInt64()) {
+    throw ParseErrorElement(key, {"value is not integer"});
+  }
+  return payload[name].asInt64();
+}
+
+std::vector<int64_t> parseInt64s(const Json::Value &payload,
+                                 const std::string &name,
+                                 const std::string &key) {
+  if (!payload.isMember(name)) {
+    throw ParseErrorElement(key, {"value is required"});
+  }
+  if (!payload[name].isArray()) {
+    throw ParseErrorElement(key, {"value is expected to be an array"});
+  }
+
+  std::vector<int64_t> values;
+  values.reserve(payload[name].size());
+  for (const auto &value : payload[name]) {
+    if (!value.isInt64()) {
+      throw ParseErrorElement(key, {"value is not integer"});
+    }
+    values.push_back(value.asInt64());
+  }
+  return values;
+}
+
+std::vector<OrtoolsLib::TimeWindow> parseTimeWindows(const Json::Value &payload,
+                                                     const std::string &key) {
+  if (!payload.isMember("timeWindows")) {
+    return {};
+  }
+  if (!payload["timeWindows"].isArray()) {
+    throw ParseErrorElement(key, {"value is expected to be an array"});
+  }
+
+  std::vector<OrtoolsLib::TimeWindow> time_windows;
+  for (int i = 0; i < payload["timeWindows"].size(); ++i) {
+    const auto &tw = payload["timeWindows"][i];
+    if (!tw.isMember("start") || !tw["start"].isInt64()) {
+      throw ParseErrorElement(std::format("{}[{}].start", key, i),
+                              {"value is not integer"});
+    }
+    if (!tw.isMember("end") || !tw["end"].isInt64()) {
+      throw ParseErrorElement(std::format("{}[{}].end", key, i),
+                              {"value is not integer"});
+    }
+    time_windows.emplace_back(OrtoolsLib::TimeWindow{
+        .start = tw["start"].asInt64(),
+        .end = tw["end"].asInt64(),
+    });
+  }
+  return time_windows;
+}
+
+// [][]int of request nodes, as initialRoutes and lockedRoutes
+std::vector<std::vector<int32_t>> parseRoutes(const Json::Value &value,
+                                              const std::string &key) {
+  if (!value.isArray()) {
+    throw ParseErrorElement(key, {"expected arrays"});
+  }
+
+  std::vector<std::vector<int32_t>> routes(value.size());
+  for (int i = 0; i < value.size(); ++i) {
+    const auto &route = value[i];
+    if (!route.isArray()) {
+      throw ParseErrorElement(std::format("{}[{}]", key, i),
+                              {"expected arrays"});
+    }
+
+    routes[i].reserve(route.size());
+    for (int j = 0; j < route.size(); ++j) {
+      if (!route[j].isInt()) {
+        throw ParseErrorElement(std::format("{}[{}][{}]", key, i, j),
+                                {"value is not integer"});
+      }
+      routes[i].push_back(route[j].asInt());
+    }
+  }
+  return routes;
+}
+
+// n, once n * n values make up a whole matrix of at most kMaxNodeCount
+// nodes; throws ParseErrorElement for `key` otherwise
+size_t squareSize(const std::string &key, int32_t n, size_t values) {
+  if (n < 0) {
+    throw ParseErrorElement(key + ".n", {"negative"});
+  }
+  if (static_cast<size_t>(n) > kMaxNodeCount) {
+    throw ParseErrorElement(key + ".n", {"too many nodes"});
+  }
+  if (static_cast<uint64_t>(n) * static_cast<uint64_t>(n) != values) {
+    throw ParseErrorElement(key, {std::format("expected n * n = {} values, "
+                                              "got {}",
+                                              static_cast<uint64_t>(n) * n,
+                                              values)});
+  }
+  return static_cast<size_t>(n);
+}
+
+template <class Element>
+void copyLittleEndian(const std::string &data, size_t n,
+                      OrtoolsLib::DurationMatrix &matrix) {
+  const char *source = data.data();
+  for (size_t i = 0; i < n; ++i) {
+    int64_t *row = matrix[i];
+    if constexpr (std::is_same_v<Element, int64_t> &&
+                  std::endian::native == std::endian::little) {
+      // already the layout of a row
+      std::memcpy(row, source, n * sizeof(int64_t));
+      source += n * sizeof(int64_t);
+    } else {
+      using Bits = std::make_unsigned_t<Element>;
+      for (size_t j = 0; j < n; ++j, source += sizeof(Element)) {
+        Bits bits = 0;
+        for (size_t byte = sizeof(Element); byte-- > 0;) {
+          bits = static_cast<Bits>(bits << 8) |
+                 static_cast<unsigned char>(source[byte]);
+        }
+        row[j] = static_cast<Element>(bits);
+      }
+    }
+  }
+}
+
+// From whichever encoding the request uses. Throws ParseErrorElement with
+// the reason when the matrix is not square, too large, or given in more than
+// one encoding. With `view`, a flat matrix is read in place from the request
+// instead of copied; raw bytes have no alignment guarantee and are always
+// copied.
+OrtoolsLib::DurationMatrix
+durationMatrixFromProto(const routing::RoutingRequest &request, bool view) {
+  const bool has_rows = request.durationmatrix_size() > 0;
+  switch (request.DurationMatrixEncoding_case()) {
+  case routing::RoutingRequest::kFlatDurationMatrix: {
+    if (has_rows) {
+      throw ParseErrorElement("flatDurationMatrix",
+                              {"given together with durationMatrix"});
+    }
+    const auto &flat = request.flatdurationmatrix();
+    const size_t n =
+        squareSize("flatDurationMatrix", flat.n(), flat.values_size());
+    if (view) {
+      return OrtoolsLib::DurationMatrix::view(
+          std::span(flat.values().data(), flat.values_size()), n);
+    }
+
+    OrtoolsLib::DurationMatrix matrix(n);
+    for (size_t i = 0; i < n; ++i) {
+      const int64_t *row = flat.values().data() + i * n;
+      std::copy(row, row + n, matrix[i]);
+    }
+    return matrix;
+  }
+  case routing::RoutingRequest::kRawDurationMatrix: {
+    if (has_rows) {
+      throw ParseErrorElement("rawDurationMatrix",
+                              {"given together with durationMatrix"});
+    }
+    const auto &raw = request.rawdurationmatrix();
+    const size_t element_size =
+        raw.elementtype() == routing::MATRIX_INT32 ? sizeof(int32_t)
+                                                   : sizeof(int64_t);
+    if (raw.data().size() % element_size != 0) {
+      throw ParseErrorElement(
+          "rawDurationMatrix.data",
+          {std::format("{} bytes are not a multiple of {}", raw.data().size(),
+                       element_size)});
+    }
+    const size_t n = squareSize("rawDurationMatrix", raw.n(),
+                                raw.data().size() / element_size);
+
+    OrtoolsLib::DurationMatrix matrix(n);
+    if (raw.elementtype() == routing::MATRIX_INT32) {
+      copyLittleEndian<int32_t>(raw.data(), n, matrix);
+    } else {
+      copyLittleEndian<int64_t>(raw.data(), n, matrix);
+    }
+    return matrix;
+  }
+  default:
+    break;
+  }
+
+  const auto node_count = request.durationmatrix_size();
+  if (node_count > kMaxNodeCount) {
+    throw ParseErrorElement("durationMatrix", {"too many nodes"});
+  }
+  // every row is checked before the n * n buffer is allocated
+  for (int i = 0; i < node_count; ++i) {
+    if (request.durationmatrix(i).value_size() != node_count) {
+      throw ParseErrorElement(std::format("durationMatrix[{}]", i),
+                              {"expected square matrix"});
+    }
   }
 
+  OrtoolsLib::DurationMatrix matrix(node_count);
+  for (int i = 0; i < node_count; ++i) {
+    const auto &row = request.durationmatrix(i).value();
+    std::copy(row.begin(), row.end(), matrix[i]);
+  }
+  return matrix;
+}
+
+OrtoolsLib::LocalSearchMetaheuristic
+fromProto(routing::LocalSearchMetaheuristic metaheuristic) {
+  switch (metaheuristic) {
+  case routing::GREEDY_DESCENT:
+    return OrtoolsLib::LocalSearchMetaheuristic::GREEDY_DESCENT;
+  case routing::GUIDED_LOCAL_SEARCH:
+    return OrtoolsLib::LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH;
+  case routing::SIMULATED_ANNEALING:
+    return OrtoolsLib::LocalSearchMetaheuristic::SIMULATED_ANNEALING;
+  case routing::TABU_SEARCH:
+    return OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH;
+  case routing::GENERIC_TABU_SEARCH:
+    return OrtoolsLib::LocalSearchMetaheuristic::GENERIC_TABU_SEARCH;
+  default:
+    return OrtoolsLib::LocalSearchMetaheuristic::AUTOMATIC;
+  }
+}
+
+RoutingModel modelFromProto(const routing::RoutingRequest *const request,
+                            bool view) {
+  OrtoolsLib::DurationMatrix duration_matrix =
+      durationMatrixFromProto(*request, view);
+
   std::variant<OrtoolsLib::SingleDepot, OrtoolsLib::startEndPair> depot_config;
   if (request->has_depot()) {
     depot_config.emplace<OrtoolsLib::SingleDepot>(
@@ -128,19 +471,124 @@ RoutingModel intoEntity(const routing::RoutingRequest *const request) noexcept {
         });
   }
 
+  std::optional<OrtoolsLib::RoutingOptionWithPortfolio> with_portfolio;
+  if (request->has_withportfolio()) {
+    std::vector<OrtoolsLib::SearchStrategy> strategies;
+    for (const auto &strategy : request->withportfolio().strategies()) {
+      strategies.emplace_back(OrtoolsLib::SearchStrategy{
+          .first_solution = fromProto(strategy.firstsolutionstrategy()),
+          .metaheuristic = fromProto(strategy.localsearchmetaheuristic()),
+      });
+    }
+
+    with_portfolio.emplace(OrtoolsLib::RoutingOptionWithPortfolio{
+        .num_workers = request->withportfolio().numworkers(),
+        .strategies = std::move(strategies),
+        .share_incumbent = request->withportfolio().shareincumbent(),
+    });
+  }
+
+  std::optional<OrtoolsLib::SearchOptions> search_options;
+  if (request->has_searchoptions()) {
+    const auto &options = request->searchoptions();
+    OrtoolsLib::SearchOptions parsed{
+        .use_full_propagation = options.usefullpropagation(),
+        .log_search = options.logsearch(),
+    };
+    if (options.has_timelimitms()) {
+      parsed.time_limit_ms = options.timelimitms();
+    }
+    if (options.has_lnstimelimitms()) {
+      parsed.lns_time_limit_ms = options.lnstimelimitms();
+    }
+    if (options.has_solutionlimit()) {
+      parsed.solution_limit = options.solutionlimit();
+    }
+    if (options.has_firstsolutionstrategy()) {
+      parsed.first_solution = fromProto(options.firstsolutionstrategy());
+    }
+    if (options.has_localsearchmetaheuristic()) {
+      parsed.metaheuristic = fromProto(options.localsearchmetaheuristic());
+    }
+    if (options.has_stagnationms()) {
+      parsed.stagnation_ms = options.stagnationms();
+    }
+    if (options.has_improvementwindowms()) {
+      parsed.improvement_window_ms = options.improvementwindowms();
+    }
+    if (options.has_minrelativeimprovement()) {
+      parsed.min_relative_improvement = options.minrelativeimprovement();
+    }
+    if (options.has_targetobjective()) {
+      parsed.target_objective = options.targetobjective();
+    }
+
+    search_options.emplace(std::move(parsed));
+  }
+
+  std::optional<OrtoolsLib::RoutingOptionWithInitialRoutes> with_initial_routes;
+  if (request->initialroutes_size() > 0) {
+    std::vector<std::vector<int32_t>> routes;
+    routes.reserve(request->initialroutes_size());
+    for (const auto &route : request->initialroutes()) {
+      routes.emplace_back(route.value().begin(), route.value().end());
+    }
+
+    with_initial_routes.emplace(OrtoolsLib::RoutingOptionWithInitialRoutes{
+        .routes = std::move(routes),
+    });
+  }
+
+  std::optional<OrtoolsLib::RoutingOptionWithLockedRoutes> with_locked_routes;
+  if (request->lockedroutes_size() > 0) {
+    std::vector<std::vector<int32_t>> routes;
+    routes.reserve(request->lockedroutes_size());
+    for (const auto &route : request->lockedroutes()) {
+      routes.emplace_back(route.value().begin(), route.value().end());
+    }
+
+    with_locked_routes.emplace(OrtoolsLib::RoutingOptionWithLockedRoutes{
+        .routes = std::move(routes),
+    });
+  }
+
+  std::optional<int64_t> time_limit;
+  if (request->has_apitimelimit()) {
+    time_limit = request->apitimelimit();
+  }
+
   return RoutingModel{
       .duration_matrix = std::move(duration_matrix),
       .depot_config = std::move(depot_config),
       .num_vehicles = request->numvehicles(),
-      .time_limit = request->apitimelimit(),
+      .time_limit = time_limit,
       .with_capacity = std::move(with_capacity),
       .with_pickup_delivery = std::move(with_pickup_delivery),
       .with_time_window = std::move(with_time_window),
       .with_service_time = std::move(with_service_time),
       .with_drop_penalties = std::move(with_drop_penalties),
       .with_vehicle_break_time = std::move(with_vehicle_break_time),
+      .with_portfolio = std::move(with_portfolio),
+      .search_options = std::move(search_options),
+      .with_initial_routes = std::move(with_initial_routes),
+      .with_locked_routes = std::move(with_locked_routes),
   };
 }
+} // namespace
+
+RoutingModel intoEntity(const routing::RoutingRequest *const request) {
+  return modelFromProto(request, false);
+}
+
+RoutingModel viewEntity(const routing::RoutingRequest *const request) {
+  return modelFromProto(request, true);
+}
+
+namespace {
+// everything but the durationMatrix, which both parsers read their own way
+RoutingModel modelFromJSON(std::shared_ptr<Json::Value> json,
+                           OrtoolsLib::DurationMatrix duration_matrix);
+} // namespace
 
 RoutingModel parseJSON(std::shared_ptr<Json::Value> json) {
   if (!json) {
@@ -152,29 +600,45 @@ RoutingModel parseJSON(std::shared_ptr<Json::Value> json) {
     throw ParseErrorElement("durationMatrix", {"expected arrays"});
   }
 
-  std::vector<std::vector<int64_t>> duration_matrix;
-  duration_matrix.reserve((*json)["durationMatrix"].size());
+  const auto node_count = (*json)["durationMatrix"].size();
+  if (node_count > kMaxNodeCount) {
+    throw ParseErrorElement("durationMatrix", {"too many nodes"});
+  }
 
-  for (int i = 0; i < (*json)["durationMatrix"].size(); ++i) {
+  // every row is checked before the n * n buffer is allocated
+  for (int i = 0; i < node_count; ++i) {
     const auto &row = (*json)["durationMatrix"][i];
     if (!row.isArray()) {
       throw ParseErrorElement(std::format("durationMatrix[{}]", i),
                               {"expected arrays"});
     }
 
-    std::vector<int64_t> row_vector;
-    row_vector.reserve(row.size());
+    if (row.size() != node_count) {
+      throw ParseErrorElement(std::format("durationMatrix[{}]", i),
+                              {"expected square matrix"});
+    }
+  }
+
+  OrtoolsLib::DurationMatrix duration_matrix(node_count);
+  for (int i = 0; i < node_count; ++i) {
+    const auto &row = (*json)["durationMatrix"][i];
+    int64_t *row_values = duration_matrix[i];
     for (const auto &value : row) {
       if (!value.isInt64()) {
         throw ParseErrorElement(std::format("durationMatrix[{}]", i),
                                 {"value is not integer"});
       }
 
-      row_vector.push_back(value.asInt64());
+      *row_values++ = value.asInt64();
     }
-
-    duration_matrix.push_back(row_vector);
   }
+
+  return modelFromJSON(std::move(json), std::move(duration_matrix));
+}
+
+namespace {
+RoutingModel modelFromJSON(std::shared_ptr<Json::Value> json,
+                           OrtoolsLib::DurationMatrix duration_matrix) {
   int32_t num_vehicles = 1;
   if ((*json).isMember("numVehicles")) {
     if (!(*json)["numVehicles"].isInt()) {
@@ -280,11 +744,13 @@ RoutingModel parseJSON(std::shared_ptr<Json::Value> json) {
                             {"expected to be enum of 'depot' | 'startEnd'"});
   }
 
-  int64_t apiTimeLimit = 1;
+  std::optional<int64_t> apiTimeLimit;
   if ((*json).isMember("apiTimeLimit")) {
     if (!(*json)["apiTimeLimit"].isInt64()) {
-      apiTimeLimit = (*json)["apiTimeLimit"].asInt64();
+      throw ParseErrorElement("apiTimeLimit", {"value is not integer"});
     }
+
+    apiTimeLimit = (*json)["apiTimeLimit"].asInt64();
   }
 
   std::optional<OrtoolsLib::RoutingOptionWithCapacity> with_capacity;
@@ -562,6 +1028,163 @@ RoutingModel parseJSON(std::shared_ptr<Json::Value> json) {
         });
   }
 
+  std::optional<OrtoolsLib::RoutingOptionWithPortfolio> with_portfolio;
+  if ((*json).isMember("withPortfolio")) {
+    if (!(*json)["withPortfolio"].isObject()) {
+      throw ParseErrorElement("withPortfolio",
+                              {"value is expected to be an object"});
+    }
+
+    int32_t num_workers = 0;
+    if ((*json)["withPortfolio"].isMember("numWorkers")) {
+      if (!(*json)["withPortfolio"]["numWorkers"].isInt()) {
+        throw ParseErrorElement("withPortfolio.numWorkers",
+                                {"value is not integer"});
+      }
+
+      num_workers = (*json)["withPortfolio"]["numWorkers"].asInt();
+    }
+
+    std::vector<OrtoolsLib::SearchStrategy> strategies;
+    if ((*json)["withPortfolio"].isMember("strategies")) {
+      if (!(*json)["withPortfolio"]["strategies"].isArray()) {
+        throw ParseErrorElement("withPortfolio.strategies",
+                                {"value is expected to be an array"});
+      }
+
+      strategies.reserve((*json)["withPortfolio"]["strategies"].size());
+      for (int i = 0; i < (*json)["withPortfolio"]["strategies"].size(); ++i) {
+        const auto &value = (*json)["withPortfolio"]["strategies"][i];
+        if (!value.isMember("firstSolutionStrategy")) {
+          throw ParseErrorElement(
+              std::format("withPortfolio.strategies[{}].firstSolutionStrategy",
+                          i),
+              {"value is required"});
+        }
+        if (!value.isMember("localSearchMetaheuristic")) {
+          throw ParseErrorElement(
+              std::format(
+                  "withPortfolio.strategies[{}].localSearchMetaheuristic", i),
+              {"value is required"});
+        }
+
+        strategies.emplace_back(OrtoolsLib::SearchStrategy{
+            .first_solution = parseEnum(
+                value["firstSolutionStrategy"],
+                std::format(
+                    "withPortfolio.strategies[{}].firstSolutionStrategy", i),
+                kFirstSolutionStrategies),
+            .metaheuristic = parseEnum(
+                value["localSearchMetaheuristic"],
+                std::format(
+                    "withPortfolio.strategies[{}].localSearchMetaheuristic",
+                    i),
+                kLocalSearchMetaheuristics),
+        });
+      }
+    }
+
+    bool share_incumbent = false;
+    if ((*json)["withPortfolio"].isMember("shareIncumbent")) {
+      if (!(*json)["withPortfolio"]["shareIncumbent"].isBool()) {
+        throw ParseErrorElement("withPortfolio.shareIncumbent",
+                                {"value is not boolean"});
+      }
+
+      share_incumbent = (*json)["withPortfolio"]["shareIncumbent"].asBool();
+    }
+
+    with_portfolio.emplace(OrtoolsLib::RoutingOptionWithPortfolio{
+        .num_workers = num_workers,
+        .strategies = std::move(strategies),
+        .share_incumbent = share_incumbent,
+    });
+  }
+
+  std::optional<OrtoolsLib::SearchOptions> search_options;
+  if ((*json).isMember("searchOptions")) {
+    const auto &options = (*json)["searchOptions"];
+    if (!options.isObject()) {
+      throw ParseErrorElement("searchOptions",
+                              {"value is expected to be an object"});
+    }
+
+    OrtoolsLib::SearchOptions parsed;
+    const auto parseInt64 = [&options](const char *key,
+                                       std::optional<int64_t> &field) {
+      if (!options.isMember(key)) {
+        return;
+      }
+      if (!options[key].isInt64()) {
+        throw ParseErrorElement(std::format("searchOptions.{}", key),
+                                {"value is not integer"});
+      }
+
+      field = options[key].asInt64();
+    };
+    const auto parseBool = [&options](const char *key, bool &field) {
+      if (!options.isMember(key)) {
+        return;
+      }
+      if (!options[key].isBool()) {
+        throw ParseErrorElement(std::format("searchOptions.{}", key),
+                                {"value is not boolean"});
+      }
+
+      field = options[key].asBool();
+    };
+    const auto parseDouble = [&options](const char *key,
+                                        std::optional<double> &field) {
+      if (!options.isMember(key)) {
+        return;
+      }
+      if (!options[key].isNumeric()) {
+        throw ParseErrorElement(std::format("searchOptions.{}", key),
+                                {"value is not a number"});
+      }
+
+      field = options[key].asDouble();
+    };
+
+    parseInt64("timeLimitMs", parsed.time_limit_ms);
+    parseInt64("lnsTimeLimitMs", parsed.lns_time_limit_ms);
+    parseInt64("solutionLimit", parsed.solution_limit);
+    parseBool("useFullPropagation", parsed.use_full_propagation);
+    parseBool("logSearch", parsed.log_search);
+    parseInt64("stagnationMs", parsed.stagnation_ms);
+    parseInt64("improvementWindowMs", parsed.improvement_window_ms);
+    parseDouble("minRelativeImprovement", parsed.min_relative_improvement);
+    parseInt64("targetObjective", parsed.target_objective);
+    if (options.isMember("firstSolutionStrategy")) {
+      parsed.first_solution =
+          parseEnum(options["firstSolutionStrategy"],
+                    "searchOptions.firstSolutionStrategy",
+                    kFirstSolutionStrategies);
+    }
+    if (options.isMember("localSearchMetaheuristic")) {
+      parsed.metaheuristic =
+          parseEnum(options["localSearchMetaheuristic"],
+                    "searchOptions.localSearchMetaheuristic",
+                    kLocalSearchMetaheuristics);
+    }
+
+    search_options.emplace(std::move(parsed));
+  }
+
+  std::optional<OrtoolsLib::RoutingOptionWithInitialRoutes> with_initial_routes;
+  if ((*json).isMember("initialRoutes")) {
+    with_initial_routes.emplace(OrtoolsLib::RoutingOptionWithInitialRoutes{
+        .routes = parseRoutes((*json)["initialRoutes"], "initialRoutes"),
+    });
+  }
+
+  std::optional<OrtoolsLib::RoutingOptionWithLockedRoutes> with_locked_routes;
+  if ((*json).isMember("lockedRoutes")) {
+    with_locked_routes.emplace(OrtoolsLib::RoutingOptionWithLockedRoutes{
+        .routes = parseRoutes((*json)["lockedRoutes"], "lockedRoutes"),
+    });
+  }
+
   return RoutingModel{
       .duration_matrix = std::move(duration_matrix),
       .depot_config = std::move(depot_config),
@@ -573,6 +1196,234 @@ RoutingModel parseJSON(std::shared_ptr<Json::Value> json) {
       .with_service_time = std::move(with_service_time),
       .with_drop_penalties = std::move(with_drop_penalties),
       .with_vehicle_break_time = std::move(with_vehicle_break_time),
+      .with_portfolio = std::move(with_portfolio),
+      .search_options = std::move(search_options),
+      .with_initial_routes = std::move(with_initial_routes),
+      .with_locked_routes = std::move(with_locked_routes),
   };
 }
+
+// What Json::Value::isInt64() accepts: integers in range, and whole doubles.
+// get_int64 leaves the value unread when it fails, so it can be retried.
+bool readInt64(simdjson::ondemand::value value, int64_t &out) {
+  if (value.get_int64().get(out) == simdjson::SUCCESS) {
+    return true;
+  }
+
+  double real;
+  if (value.get_double().get(real) != simdjson::SUCCESS ||
+      real != std::trunc(real) || real < -0x1p63 || real >= 0x1p63) {
+    return false;
+  }
+  out = static_cast<int64_t>(real);
+  return true;
+}
+
+// Streams the rows straight into the matrix, with the diagnostics of
+// parseJSON. Only malformed JSON gives other errors.
+OrtoolsLib::DurationMatrix
+durationMatrixFromJSON(simdjson::ondemand::value value) {
+  simdjson::ondemand::array rows;
+  if (value.get_array().get(rows) != simdjson::SUCCESS) {
+    throw ParseErrorElement("durationMatrix", {"expected arrays"});
+  }
+  size_t node_count = 0;
+  if (rows.count_elements().get(node_count) != simdjson::SUCCESS) {
+    throw ParseErrorElement("json is null");
+  }
+  if (node_count > kMaxNodeCount) {
+    throw ParseErrorElement("durationMatrix", {"too many nodes"});
+  }
+
+  // A first pass checks the shape of every row before the n * n buffer is
+  // allocated; the second one reads the values.
+  size_t i = 0;
+  for (auto row_value : rows) {
+    simdjson::ondemand::array row;
+    if (row_value.error() != simdjson::SUCCESS) {
+      throw ParseErrorElement("json is null");
+    }
+    if (row_value.get_array().get(row) != simdjson::SUCCESS) {
+      throw ParseErrorElement(std::format("durationMatrix[{}]", i),
+                              {"expected arrays"});
+    }
+
+    size_t size = 0;
+    if (row.count_elements().get(size) != simdjson::SUCCESS) {
+      throw ParseErrorElement("json is null");
+    }
+    if (size != node_count) {
+      throw ParseErrorElement(std::format("durationMatrix[{}]", i),
+                              {"expected square matrix"});
+    }
+    ++i;
+  }
+  bool rewound = false;
+  if (rows.reset().get(rewound) != simdjson::SUCCESS) {
+    throw ParseErrorElement("json is null");
+  }
+
+  OrtoolsLib::DurationMatrix duration_matrix(node_count);
+  i = 0;
+  for (auto row_value : rows) {
+    simdjson::ondemand::array row;
+    if (row_value.get_array().get(row) != simdjson::SUCCESS) {
+      throw ParseErrorElement("json is null");
+    }
+
+    int64_t *row_values = duration_matrix[i];
+    for (auto element : row) {
+      simdjson::ondemand::value element_value;
+      if (element.get(element_value) != simdjson::SUCCESS) {
+        throw ParseErrorElement("json is null");
+      }
+      if (!readInt64(element_value, *row_values++)) {
+        throw ParseErrorElement(std::format("durationMatrix[{}]", i),
+                                {"value is not integer"});
+      }
+    }
+    ++i;
+  }
+
+  return duration_matrix;
+}
+} // namespace
+
+RoutingModel parseJSONBody(std::string_view body) {
+  // parsers keep their buffers between calls
+  thread_local simdjson::ondemand::parser parser;
+  const simdjson::padded_string padded(body);
+  simdjson::ondemand::document document;
+  simdjson::ondemand::object object;
+  if (parser.iterate(padded).get(document) != simdjson::SUCCESS ||
+      document.get_object().get(object) != simdjson::SUCCESS) {
+    throw ParseErrorElement("json is null");
+  }
+
+  // The matrix is by far the largest field and skips the DOM altogether. The
+  // others are small: each goes through jsoncpp so that modelFromJSON checks
+  // them exactly like parseJSON does.
+  std::optional<OrtoolsLib::DurationMatrix> duration_matrix;
+  auto rest = std::make_shared<Json::Value>(Json::objectValue);
+  const std::unique_ptr<Json::CharReader> reader(
+      Json::CharReaderBuilder().newCharReader());
+  for (auto field : object) {
+    std::string_view key;
+    simdjson::ondemand::value value;
+    if (field.unescaped_key().get(key) != simdjson::SUCCESS ||
+        field.value().get(value) != simdjson::SUCCESS) {
+      throw ParseErrorElement("json is null");
+    }
+    if (key == "durationMatrix") {
+      duration_matrix = durationMatrixFromJSON(value);
+      continue;
+    }
+
+    std::string_view raw;
+    Json::Value parsed;
+    if (value.raw_json().get(raw) != simdjson::SUCCESS ||
+        !reader->parse(raw.data(), raw.data() + raw.size(), &parsed,
+                       nullptr)) {
+      throw ParseErrorElement("json is null");
+    }
+    (*rest)[std::string(key)] = std::move(parsed);
+  }
+  if (!document.at_end()) {
+    throw ParseErrorElement("json is null");
+  }
+
+  if (!duration_matrix.has_value()) {
+    throw ParseErrorElement("durationMatrix", {"expected arrays"});
+  }
+  return modelFromJSON(std::move(rest), std::move(duration_matrix).value());
+}
+
+OrtoolsLib::SessionDelta
+intoSessionDelta(const routing::SessionDeltaRequest *const request) {
+  switch (request->Delta_case()) {
+  case routing::SessionDeltaRequest::kAddOrder: {
+    const auto &add_order = request->addorder();
+    std::optional<int64_t> penalty;
+    if (add_order.has_penalty()) {
+      penalty = add_order.penalty();
+    }
+    return OrtoolsLib::AddOrder{
+        .durations_to = std::vector<int64_t>(add_order.durationsto().begin(),
+                                             add_order.durationsto().end()),
+        .durations_from = std::vector<int64_t>(
+            add_order.durationsfrom().begin(), add_order.durationsfrom().end()),
+        .service_time = add_order.servicetime(),
+        .demand = add_order.demand(),
+        .time_windows = fromProto(add_order.timewindows()),
+        .penalty = penalty,
+    };
+  }
+  case routing::SessionDeltaRequest::kCancelOrder:
+    return OrtoolsLib::CancelOrder{.node = request->cancelorder().node()};
+  case routing::SessionDeltaRequest::kChangeTimeWindow:
+    return OrtoolsLib::ChangeTimeWindow{
+        .node = request->changetimewindow().node(),
+        .time_windows = fromProto(request->changetimewindow().timewindows()),
+    };
+  case routing::SessionDeltaRequest::kVehicleBreakdown:
+    return OrtoolsLib::VehicleBreakdown{
+        .vehicle = request->vehiclebreakdown().vehicle()};
+  default:
+    throw ParseErrorElement("delta", {"value is required"});
+  }
+}
+
+OrtoolsLib::SessionDelta parseSessionDelta(std::shared_ptr<Json::Value> json) {
+  if (!json) {
+    throw ParseErrorElement("json is null");
+  }
+
+  if (!(*json).isMember("type")) {
+    throw ParseErrorElement("type", {"value is required"});
+  }
+  if (!(*json)["type"].isString()) {
+    throw ParseErrorElement("type", {"value is expected to be string"});
+  }
+  if (!(*json).isMember("payload") || !(*json)["payload"].isObject()) {
+    throw ParseErrorElement("payload", {"value is required"});
+  }
+
+  const auto &payload = (*json)["payload"];
+  const auto type = (*json)["type"].asString();
+  if (type == "addOrder") {
+    std::optional<int64_t> penalty;
+    if (payload.isMember("penalty")) {
+      penalty = parseInt64(payload, "penalty", "payload.penalty", 0);
+    }
+    return OrtoolsLib::AddOrder{
+        .durations_to =
+            parseInt64s(payload, "durationsTo", "payload.durationsTo"),
+        .durations_from =
+            parseInt64s(payload, "durationsFrom", "payload.durationsFrom"),
+        .service_time =
+            parseInt64(payload, "serviceTime", "payload.serviceTime", 0),
+        .demand = parseInt64(payload, "demand", "payload.demand", 0),
+        .time_windows = parseTimeWindows(payload, "payload.timeWindows"),
+        .penalty = penalty,
+    };
+  }
+  if (type == "cancelOrder") {
+    return OrtoolsLib::CancelOrder{
+        .node = parseInt(payload, "node", "payload.node")};
+  }
+  if (type == "changeTimeWindow") {
+    return OrtoolsLib::ChangeTimeWindow{
+        .node = parseInt(payload, "node", "payload.node"),
+        .time_windows = parseTimeWindows(payload, "payload.timeWindows"),
+    };
+  }
+  if (type == "vehicleBreakdown") {
+    return OrtoolsLib::VehicleBreakdown{
+        .vehicle = parseInt(payload, "vehicle", "payload.vehicle")};
+  }
+
+  throw ParseErrorElement("type",
+                          {"expected to be enum of 'addOrder' | 'cancelOrder' "
+                           "| 'changeTimeWindow' | 'vehicleBreakdown'"});
+}
 } // namespace RoutingDTO
@@ -2,16 +2,24 @@
 #define routingDto_h
 
 #include <lib/routing.h>
+#include <lib/routingSession.h>
 #include <routing-proto/routing.grpc.pb.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <json/json.h>
 #include <exception>
 
 namespace RoutingDTO {
 
+// Largest durationMatrix accepted, checked before the matrix is allocated:
+// 5000 nodes already take 200 MB.
+inline constexpr size_t kMaxNodeCount = 5000;
+
 class ParseErrorElement: public std::exception {
     std::string code = "PARSE_ERROR";
     std::string key;
@@ -46,6 +54,18 @@ public:
         return json;
     }
 
+    // "key: value, value", or the key alone; for gRPC status messages
+    std::string message() const {
+        std::string message = key;
+        if (values.has_value()) {
+            for (size_t i = 0; i < values->size(); ++i) {
+                message += i == 0 ? ": " : ", ";
+                message += (*values)[i];
+            }
+        }
+        return message;
+    }
+
     const char* what() const noexcept override {
         return "ParseErrorElement";
     }
@@ -53,10 +73,10 @@ public:
 
 
 struct RoutingModel {
-  std::vector<std::vector<int64_t>> duration_matrix;
+  OrtoolsLib::DurationMatrix duration_matrix;
   std::variant<OrtoolsLib::SingleDepot, OrtoolsLib::startEndPair> depot_config;
   int32_t num_vehicles = 1;
-  int64_t time_limit;
+  std::optional<int64_t> time_limit;
   std::optional<OrtoolsLib::RoutingOptionWithCapacity> with_capacity;
   std::optional<OrtoolsLib::RoutingOptionWithPickupDelivery>
       with_pickup_delivery;
@@ -65,10 +85,30 @@ struct RoutingModel {
   std::optional<OrtoolsLib::RoutingOptionWithPenalties> with_drop_penalties;
   std::optional<OrtoolsLib::RoutingOptionWithVehicleBreakTime>
       with_vehicle_break_time;
+  std::optional<OrtoolsLib::RoutingOptionWithPortfolio> with_portfolio;
+  std::optional<OrtoolsLib::SearchOptions> search_options;
+  std::optional<OrtoolsLib::RoutingOptionWithInitialRoutes>
+      with_initial_routes;
+  std::optional<OrtoolsLib::RoutingOptionWithLockedRoutes> with_locked_routes;
 };
 
-RoutingModel intoEntity(const routing::RoutingRequest *const request) noexcept;
+// throws ParseErrorElement when the duration matrix is malformed
+RoutingModel intoEntity(const routing::RoutingRequest *const request);
+// Like intoEntity, but a flatDurationMatrix is read in place rather than
+// copied: `request` must outlive the model and every Routing built from it.
+RoutingModel viewEntity(const routing::RoutingRequest *const request);
 RoutingModel parseJSON(std::shared_ptr<Json::Value> json);
+// Same model and ParseErrorElement diagnostics as parseJSON, read from the
+// raw request body with an on-demand SIMD parser: durationMatrix goes
+// straight into the matrix buffer without building a DOM.
+RoutingModel parseJSONBody(std::string_view body);
+
+// both throw ParseErrorElement, e.g. when no delta is set
+OrtoolsLib::SessionDelta
+intoSessionDelta(const routing::SessionDeltaRequest *const request);
+// {"type": "addOrder" | "cancelOrder" | "changeTimeWindow" |
+// "vehicleBreakdown", "payload": {...}}
+OrtoolsLib::SessionDelta parseSessionDelta(std::shared_ptr<Json::Value> json);
 }  // namespace RoutingDTO
 
 #endif
@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 #include <routing-proto/routing.grpc.pb.h>
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include "lib/routing.h"
@@ -116,7 +118,7 @@ TEST(RoutingDTO, TestIntoRoutingModel) {
   };
 
   RoutingDTO::RoutingModel expected{
-      .duration_matrix = duration_matrix,
+      .duration_matrix = OrtoolsLib::DurationMatrix::fromRows(duration_matrix),
       .depot_config = depot_config,
       .with_capacity = cap,
       .with_pickup_delivery = pd,
@@ -147,6 +149,76 @@ TEST(RoutingDTO, TestIntoRoutingModel) {
             expected.with_vehicle_break_time.value().break_time);
 }
 
+TEST(RoutingDTO, TestIntoRoutingModelWithCompactMatrix) {
+  const auto expected = OrtoolsLib::DurationMatrix::fromRows({
+      {0, -1, 2},
+      {1, 0, 300000},
+      {2, 4, 0},
+  });
+  const std::vector<int64_t> values{0, -1, 2, 1, 0, 300000, 2, 4, 0};
+
+  routing::RoutingRequest flat;
+  flat.mutable_flatdurationmatrix()->set_n(3);
+  for (const int64_t value : values) {
+    flat.mutable_flatdurationmatrix()->add_values(value);
+  }
+  EXPECT_EQ(RoutingDTO::intoEntity(&flat).duration_matrix, expected);
+  // viewed in place rather than copied
+  const auto viewed = RoutingDTO::viewEntity(&flat).duration_matrix;
+  EXPECT_EQ(viewed, expected);
+  EXPECT_EQ(viewed.data(), flat.flatdurationmatrix().values().data());
+
+  routing::RoutingRequest raw32;
+  std::string data32;
+  for (const int64_t value : values) {
+    const auto bits = static_cast<uint32_t>(static_cast<int32_t>(value));
+    for (int byte = 0; byte < 4; ++byte) {
+      data32.push_back(static_cast<char>(bits >> (8 * byte)));
+    }
+  }
+  raw32.mutable_rawdurationmatrix()->set_n(3);
+  raw32.mutable_rawdurationmatrix()->set_elementtype(routing::MATRIX_INT32);
+  raw32.mutable_rawdurationmatrix()->set_data(data32);
+  EXPECT_EQ(RoutingDTO::intoEntity(&raw32).duration_matrix, expected);
+
+  routing::RoutingRequest raw64;
+  std::string data64;
+  for (const int64_t value : values) {
+    const auto bits = static_cast<uint64_t>(value);
+    for (int byte = 0; byte < 8; ++byte) {
+      data64.push_back(static_cast<char>(bits >> (8 * byte)));
+    }
+  }
+  raw64.mutable_rawdurationmatrix()->set_n(3);
+  raw64.mutable_rawdurationmatrix()->set_data(data64);
+  EXPECT_EQ(RoutingDTO::intoEntity(&raw64).duration_matrix, expected);
+
+  // not square, cut short, or given twice: rejected with the reason
+  const auto reason = [](const routing::RoutingRequest &request) {
+    try {
+      RoutingDTO::intoEntity(&request);
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      return e.message();
+    }
+    return std::string();
+  };
+  raw64.mutable_rawdurationmatrix()->set_n(2);
+  EXPECT_EQ(reason(raw64),
+            "rawDurationMatrix: expected n * n = 4 values, got 9");
+  raw64.mutable_rawdurationmatrix()->set_n(3);
+  raw64.mutable_rawdurationmatrix()->mutable_data()->pop_back();
+  EXPECT_EQ(reason(raw64),
+            "rawDurationMatrix.data: 71 bytes are not a multiple of 8");
+  flat.add_durationmatrix()->add_value(0);
+  EXPECT_EQ(reason(flat),
+            "flatDurationMatrix: given together with durationMatrix");
+
+  routing::RoutingRequest ragged;
+  ragged.add_durationmatrix()->add_value(0);
+  ragged.add_durationmatrix();
+  EXPECT_EQ(reason(ragged), "durationMatrix[0]: expected square matrix");
+}
+
 TEST(RoutingDTO, TestParsingJSON) {
   const std::string rawJson{R"(
       {
@@ -245,11 +317,11 @@ TEST(RoutingDTO, TestParsingJSON) {
   ASSERT_TRUE(err.empty());
   auto routing_model =
       RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
-  std::vector<std::vector<int64_t>> expected_duration_matrix{
+  const auto expected_duration_matrix = OrtoolsLib::DurationMatrix::fromRows({
       {1, 2, 3},
       {1, 2, 3},
       {1, 2, 3},
-  };
+  });
   ASSERT_EQ(routing_model.duration_matrix, expected_duration_matrix);
   ASSERT_EQ(routing_model.num_vehicles, 2);
   ASSERT_EQ(routing_model.time_limit, 1);
@@ -310,4 +382,307 @@ TEST(RoutingDTO, TestParsingJSON) {
   ASSERT_TRUE(routing_model.with_vehicle_break_time.has_value());
   ASSERT_EQ(routing_model.with_vehicle_break_time.value().break_time,
             expected_with_vehicle_break_time.break_time);
-}
\ No newline at end of file
+}
+
+TEST(RoutingDTO, TestParsingJSONNonSquareMatrix) {
+  Json::Value root;
+  Json::Value row;
+  row.append(0);
+  row.append(1);
+  root["durationMatrix"].append(row);
+
+  EXPECT_THROW(RoutingDTO::parseJSON(std::make_shared<Json::Value>(root)),
+               RoutingDTO::ParseErrorElement);
+}
+
+
+TEST(RoutingDTO, TestParsingJSONTooManyNodes) {
+  auto root = std::make_shared<Json::Value>();
+  std::string body = R"({"durationMatrix": [)";
+  for (size_t i = 0; i <= RoutingDTO::kMaxNodeCount; ++i) {
+    (*root)["durationMatrix"].append(Json::Value(Json::arrayValue));
+    body += i == 0 ? "[]" : ",[]";
+  }
+  body += "]}";
+
+  EXPECT_THROW(RoutingDTO::parseJSON(root), RoutingDTO::ParseErrorElement);
+  EXPECT_THROW(RoutingDTO::parseJSONBody(body), RoutingDTO::ParseErrorElement);
+}
+
+TEST(RoutingDTO, TestParsingJSONWithPortfolio) {
+  const std::string rawJson{R"(
+      {
+        "durationMatrix": [[0, 1], [1, 0]],
+        "routingMode": {
+          "type": "depot",
+          "payload": {
+            "depot": 0
+          }
+        },
+        "withPortfolio": {
+          "numWorkers": 2,
+          "shareIncumbent": true,
+          "strategies": [
+            {
+              "firstSolutionStrategy": "SAVINGS",
+              "localSearchMetaheuristic": "TABU_SEARCH"
+            }
+          ]
+        }
+      }
+    )"};
+
+  Json::CharReaderBuilder builder;
+  const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  Json::Value root;
+  Json::String err;
+  ASSERT_TRUE(reader->parse(rawJson.c_str(), rawJson.c_str() + rawJson.length(),
+                            &root, &err));
+  auto routing_model =
+      RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
+
+  ASSERT_TRUE(routing_model.with_portfolio.has_value());
+  ASSERT_EQ(routing_model.with_portfolio.value().num_workers, 2);
+  ASSERT_TRUE(routing_model.with_portfolio.value().share_incumbent);
+  const std::vector<OrtoolsLib::SearchStrategy> expected_strategies{{
+      .first_solution = OrtoolsLib::FirstSolutionStrategy::SAVINGS,
+      .metaheuristic = OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH,
+  }};
+  ASSERT_EQ(routing_model.with_portfolio.value().strategies,
+            expected_strategies);
+
+  root["withPortfolio"]["strategies"][0]["firstSolutionStrategy"] = "UNKNOWN";
+  EXPECT_THROW(RoutingDTO::parseJSON(std::make_shared<Json::Value>(root)),
+               RoutingDTO::ParseErrorElement);
+}
+
+
+TEST(RoutingDTO, TestParsingJSONWithSearchOptions) {
+  Json::Value root;
+  for (int i = 0; i < 2; ++i) {
+    Json::Value row;
+    row.append(i);
+    row.append(1 - i);
+    root["durationMatrix"].append(row);
+  }
+  root["routingMode"]["type"] = "depot";
+  root["routingMode"]["payload"]["depot"] = 0;
+  root["searchOptions"]["timeLimitMs"] = 150;
+  root["searchOptions"]["solutionLimit"] = 10;
+  root["searchOptions"]["firstSolutionStrategy"] = "CHRISTOFIDES";
+  root["searchOptions"]["logSearch"] = true;
+  root["searchOptions"]["improvementWindowMs"] = 200;
+  root["searchOptions"]["minRelativeImprovement"] = 0.01;
+
+  auto routing_model =
+      RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
+
+  ASSERT_FALSE(routing_model.time_limit.has_value());
+  ASSERT_TRUE(routing_model.search_options.has_value());
+  const auto &search_options = routing_model.search_options.value();
+  EXPECT_EQ(search_options.time_limit_ms, 150);
+  EXPECT_FALSE(search_options.lns_time_limit_ms.has_value());
+  EXPECT_EQ(search_options.solution_limit, 10);
+  EXPECT_EQ(search_options.first_solution,
+            OrtoolsLib::FirstSolutionStrategy::CHRISTOFIDES);
+  EXPECT_FALSE(search_options.metaheuristic.has_value());
+  EXPECT_TRUE(search_options.log_search);
+  EXPECT_FALSE(search_options.use_full_propagation);
+  EXPECT_FALSE(search_options.stagnation_ms.has_value());
+  EXPECT_EQ(search_options.improvement_window_ms, 200);
+  EXPECT_EQ(search_options.min_relative_improvement, 0.01);
+  EXPECT_FALSE(search_options.target_objective.has_value());
+
+  root["apiTimeLimit"] = "1";
+  EXPECT_THROW(RoutingDTO::parseJSON(std::make_shared<Json::Value>(root)),
+               RoutingDTO::ParseErrorElement);
+}
+
+
+TEST(RoutingDTO, TestParsingJSONWithInitialRoutes) {
+  Json::Value root;
+  for (int i = 0; i < 3; ++i) {
+    Json::Value row;
+    for (int j = 0; j < 3; ++j) {
+      row.append(i == j ? 0 : 1);
+    }
+    root["durationMatrix"].append(row);
+  }
+  root["routingMode"]["type"] = "depot";
+  root["routingMode"]["payload"]["depot"] = 0;
+  Json::Value route;
+  route.append(0);
+  route.append(2);
+  route.append(1);
+  route.append(0);
+  root["initialRoutes"].append(route);
+
+  auto routing_model =
+      RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
+
+  ASSERT_TRUE(routing_model.with_initial_routes.has_value());
+  const std::vector<std::vector<int32_t>> expected_routes{{0, 2, 1, 0}};
+  ASSERT_EQ(routing_model.with_initial_routes.value().routes, expected_routes);
+
+  root["initialRoutes"][0][1] = "2";
+  EXPECT_THROW(RoutingDTO::parseJSON(std::make_shared<Json::Value>(root)),
+               RoutingDTO::ParseErrorElement);
+}
+
+TEST(RoutingDTO, TestParsingSessionDelta) {
+  Json::Value root;
+  root["type"] = "addOrder";
+  root["payload"]["durationsTo"].append(5);
+  root["payload"]["durationsTo"].append(6);
+  root["payload"]["durationsFrom"].append(7);
+  root["payload"]["durationsFrom"].append(8);
+  root["payload"]["serviceTime"] = 3;
+  Json::Value tw;
+  tw["start"] = 10;
+  tw["end"] = 20;
+  root["payload"]["timeWindows"].append(tw);
+
+  auto delta =
+      RoutingDTO::parseSessionDelta(std::make_shared<Json::Value>(root));
+  const auto *add_order = std::get_if<OrtoolsLib::AddOrder>(&delta);
+  ASSERT_NE(add_order, nullptr);
+  EXPECT_EQ(add_order->durations_to, (std::vector<int64_t>{5, 6}));
+  EXPECT_EQ(add_order->durations_from, (std::vector<int64_t>{7, 8}));
+  EXPECT_EQ(add_order->service_time, 3);
+  EXPECT_EQ(add_order->demand, 0);
+  EXPECT_EQ(add_order->time_windows,
+            (std::vector<OrtoolsLib::TimeWindow>{{.start = 10, .end = 20}}));
+  EXPECT_FALSE(add_order->penalty.has_value());
+
+  Json::Value breakdown;
+  breakdown["type"] = "vehicleBreakdown";
+  breakdown["payload"]["vehicle"] = 1;
+  delta =
+      RoutingDTO::parseSessionDelta(std::make_shared<Json::Value>(breakdown));
+  ASSERT_TRUE(std::holds_alternative<OrtoolsLib::VehicleBreakdown>(delta));
+  EXPECT_EQ(std::get<OrtoolsLib::VehicleBreakdown>(delta).vehicle, 1);
+
+  breakdown["type"] = "reroute";
+  EXPECT_THROW(
+      RoutingDTO::parseSessionDelta(std::make_shared<Json::Value>(breakdown)),
+      RoutingDTO::ParseErrorElement);
+
+  Json::Value cancel;
+  cancel["type"] = "cancelOrder";
+  cancel["payload"]["node"] = "2";
+  EXPECT_THROW(
+      RoutingDTO::parseSessionDelta(std::make_shared<Json::Value>(cancel)),
+      RoutingDTO::ParseErrorElement);
+
+  const routing::SessionDeltaRequest empty;
+  try {
+    RoutingDTO::intoSessionDelta(&empty);
+    FAIL();
+  } catch (const RoutingDTO::ParseErrorElement &e) {
+    EXPECT_EQ(e.message(), "delta: value is required");
+  }
+}
+
+TEST(RoutingDTO, TestParsingJSONWithLockedRoutes) {
+  Json::Value root;
+  for (int i = 0; i < 3; ++i) {
+    Json::Value row;
+    for (int j = 0; j < 3; ++j) {
+      row.append(i == j ? 0 : 1);
+    }
+    root["durationMatrix"].append(row);
+  }
+  root["routingMode"]["type"] = "depot";
+  root["routingMode"]["payload"]["depot"] = 0;
+  Json::Value route;
+  route.append(0);
+  route.append(2);
+  root["lockedRoutes"].append(route);
+
+  auto routing_model =
+      RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
+
+  ASSERT_TRUE(routing_model.with_locked_routes.has_value());
+  const std::vector<std::vector<int32_t>> expected_routes{{0, 2}};
+  ASSERT_EQ(routing_model.with_locked_routes.value().routes, expected_routes);
+  EXPECT_FALSE(routing_model.with_initial_routes.has_value());
+
+  root["lockedRoutes"][0] = 2;
+  EXPECT_THROW(RoutingDTO::parseJSON(std::make_shared<Json::Value>(root)),
+               RoutingDTO::ParseErrorElement);
+}
+
+TEST(RoutingDTO, TestParsingJSONBodyMatchesParseJSON) {
+  const std::string body{R"(
+      {
+        "numVehicles": 2,
+        "durationMatrix": [[0, 7, 2.0], [1, 0, -3], [4, 5, 0]],
+        "routingMode": {
+          "type": "startEnd",
+          "payload": {"starts": [0, 1], "ends": [2, 2]}
+        },
+        "withServiceTime": {"serviceTime": [1, 2, 3]}
+      }
+    )"};
+
+  Json::CharReaderBuilder builder;
+  const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  Json::Value root;
+  ASSERT_TRUE(reader->parse(body.data(), body.data() + body.size(), &root,
+                            nullptr));
+  const auto expected =
+      RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
+  const auto routing_model = RoutingDTO::parseJSONBody(body);
+
+  EXPECT_EQ(routing_model.duration_matrix, expected.duration_matrix);
+  EXPECT_EQ(routing_model.duration_matrix(0, 2), 2);
+  EXPECT_EQ(routing_model.num_vehicles, 2);
+  ASSERT_TRUE(std::holds_alternative<OrtoolsLib::startEndPair>(
+      routing_model.depot_config));
+  EXPECT_EQ(std::get<OrtoolsLib::startEndPair>(routing_model.depot_config).ends,
+            (std::vector<int32_t>{2, 2}));
+  ASSERT_TRUE(routing_model.with_service_time.has_value());
+  EXPECT_EQ(routing_model.with_service_time.value().service_time,
+            expected.with_service_time.value().service_time);
+}
+
+TEST(RoutingDTO, TestParsingJSONBodyReportsLikeParseJSON) {
+  const std::string mode{
+      R"("routingMode": {"type": "depot", "payload": {"depot": 0}})"};
+  const std::vector<std::string> bodies{
+      R"({"durationMatrix": [[0, 1], [1]], )" + mode + "}",
+      R"({"durationMatrix": [[0, 1], [1, "a"]], )" + mode + "}",
+      R"({"durationMatrix": [[0, 1], [1, 0.5]], )" + mode + "}",
+      R"({"durationMatrix": [[0, 1], 2], )" + mode + "}",
+      R"({"durationMatrix": {}, )" + mode + "}",
+      R"({)" + mode + "}",
+      R"({"durationMatrix": [[0]]})",
+      R"({"durationMatrix": [[0]], "numVehicles": "2", )" + mode + "}",
+  };
+
+  Json::CharReaderBuilder builder;
+  const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  for (const std::string &body : bodies) {
+    Json::Value root;
+    ASSERT_TRUE(reader->parse(body.data(), body.data() + body.size(), &root,
+                              nullptr))
+        << body;
+
+    Json::Value expected;
+    try {
+      RoutingDTO::parseJSON(std::make_shared<Json::Value>(root));
+      FAIL() << body;
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      expected = e.toJson();
+    }
+    try {
+      RoutingDTO::parseJSONBody(body);
+      FAIL() << body;
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      EXPECT_EQ(e.toJson(), expected) << body;
+    }
+  }
+
+  EXPECT_THROW(RoutingDTO::parseJSONBody(R"({"durationMatrix": [[0]})"),
+               RoutingDTO::ParseErrorElement);
+}
@@ -1,53 +1,722 @@
 
+#include <google/protobuf/arena.h>
 #include <grpc/grpc.h>
 #include <grpcpp/server_builder.h>
+#include <grpcpp/support/message_allocator.h>
 #include <routing-proto/routing.grpc.pb.h>
 
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "dtos/routingDto.h"
+#include "lib/jobStore.h"
 #include "lib/routing.h"
+#include "lib/routingSession.h"
+#include "lib/solveContext.h"
+#include "lib/solverExecutor.h"
+#include "lib/solverService.h"
 
 namespace grpcHandler {
-class OrtoolsImpl final : public routing::OrtoolsService::Service {
-  grpc::Status Routing(grpc::ServerContext *context,
-                       const routing::RoutingRequest *const request,
-                       routing::RoutingResponse *const response) override {
-    const RoutingDTO::RoutingModel routing_model =
-        RoutingDTO::intoEntity(request);
-
-    const std::vector<OrtoolsLib::RoutingResponse> resp =
-        OrtoolsLib::Routing::builder()
-            .setDurationMatrix(std::move(routing_model.duration_matrix))
-            .setDepotConfig(std::move(routing_model.depot_config))
-            .setNumVehicles(routing_model.num_vehicles)
-            .setTimeLimit(routing_model.time_limit)
-            .withCapacity(std::move(routing_model.with_capacity))
-            .withPickupDelivery(std::move(routing_model.with_pickup_delivery))
-            .withTimeWindow(std::move(routing_model.with_time_window))
-            .withServiceTime(std::move(routing_model.with_service_time))
-            .withDropPenalties(std::move(routing_model.with_drop_penalties))
-            .withVehicleBreakTime(
-                std::move(routing_model.with_vehicle_break_time))
-            .build()
-            .solve();
-
-    for (const auto &r : resp) {
-      auto *routes = response->add_routes();
+namespace {
+// solves stop this long before the client deadline so the answer still
+// reaches the client in time
+constexpr std::chrono::milliseconds kDeadlineMargin{100};
+
+OrtoolsLib::Deadline deadlineOf(const grpc::ServerContextBase &context) {
+  const auto deadline = context.deadline();
+  if (deadline == std::chrono::system_clock::time_point::max()) {
+    return std::nullopt;
+  }
+
+  return std::chrono::steady_clock::now() +
+         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+             deadline - std::chrono::system_clock::now() - kDeadlineMargin);
+}
+
+grpc::Status saturated(grpc::CallbackServerContext *context,
+                       const OrtoolsLib::ExecutorSaturated &e) {
+  context->AddTrailingMetadata("grpc-retry-pushback-ms",
+                               std::to_string(e.retry_after.count()));
+  return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, e.what());
+}
+
+// the answer for a batch item that cannot be built into a routing
+routing::RoutingBatchResponse invalidItem(int index, const std::string &error) {
+  routing::RoutingBatchResponse response;
+  response.set_index(index);
+  response.set_status("INVALID_ARGUMENT");
+  response.set_error(error);
+  return response;
+}
+
+// Puts the request and response of each unary call on an arena of their own,
+// so their nested messages (units, pairs, time windows, ...) are allocated
+// from a few blocks and freed in one step once the call is done.
+template <typename Request, typename Response>
+class ArenaMessageAllocator final
+    : public grpc::MessageAllocator<Request, Response> {
+public:
+  grpc::MessageHolder<Request, Response> *AllocateMessages() override {
+    return new Holder();
+  }
+
+private:
+  class Holder final : public grpc::MessageHolder<Request, Response> {
+  public:
+    Holder() {
+      this->set_request(
+          google::protobuf::Arena::CreateMessage<Request>(&_arena));
+      this->set_response(
+          google::protobuf::Arena::CreateMessage<Response>(&_arena));
+    }
+
+    void Release() override { delete this; }
+
+  private:
+    google::protobuf::Arena _arena;
+  };
+};
+} // namespace
+
+// Callback API: a call holds no thread while it waits for or runs its solve.
+// Requests are parsed on gRPC's threads and solved on the SolverService's
+// executor, which finishes the reactor, so open calls are bounded by the
+// executor queue rather than by gRPC's thread count.
+//
+// gRPC keeps a request alive until its call finishes, and calls finish only
+// once their solves are done, so Routing, RoutingStream and RoutingBatch read
+// a flat duration matrix in place (RoutingDTO::viewEntity). Sessions and jobs
+// outlive their call and copy it.
+class OrtoolsImpl final : public routing::OrtoolsService::CallbackService {
+public:
+  explicit OrtoolsImpl(OrtoolsLib::SolverService &solver) : _solver(solver) {
+    SetMessageAllocatorFor_Routing(&_routing_messages);
+    SetMessageAllocatorFor_CreateSession(&_session_messages);
+    SetMessageAllocatorFor_UpdateSession(&_delta_messages);
+    SetMessageAllocatorFor_SubmitJob(&_job_messages);
+  }
+
+private:
+  grpc::ServerUnaryReactor *
+  Routing(grpc::CallbackServerContext *context,
+          const routing::RoutingRequest *const request,
+          routing::RoutingResponse *const response) override {
+    std::shared_ptr<const OrtoolsLib::Routing> routing;
+    try {
+      routing = std::make_shared<const OrtoolsLib::Routing>(
+          _build(RoutingDTO::viewEntity(request)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.what()));
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.message()));
+    }
+
+    return _onWorker(context, [this, context, response, routing]() {
+      const OrtoolsLib::CancellationToken token(
+          [context]() { return context->IsCancelled(); });
+      OrtoolsLib::SharedResponses resp;
+      try {
+        resp = _solver.solve(*routing, OrtoolsLib::SolveContext{
+                                           .cancellation = &token,
+                                           .deadline = deadlineOf(*context),
+                                       });
+      } catch (const std::runtime_error &) {
+        // cancelled before the first solution
+        if (token.cancelled()) {
+          return grpc::Status::CANCELLED;
+        }
+        // an answer, as from RoutingStream, RoutingBatch and REST's
+        // "no_solution", not a failed call
+        response->set_status("NO_SOLUTION");
+        return grpc::Status::OK;
+      }
+      if (token.cancelled()) {
+        return grpc::Status::CANCELLED;
+      }
+
+      response->set_status("OK");
+      _addRoutes(*resp, response->mutable_routes());
+      response->set_engine(
+          OrtoolsLib::solverEngineName(routing->enginePlan().engine));
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::ServerWriteReactor<routing::RoutingResponse> *
+  RoutingStream(grpc::CallbackServerContext *context,
+                const routing::RoutingRequest *const request) override {
+    auto *reactor = new RoutingStreamReactor(_solver, context);
+    try {
+      reactor->start(std::make_shared<const OrtoolsLib::Routing>(
+          _build(RoutingDTO::viewEntity(request))));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      reactor->Finish(
+          grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what()));
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      reactor->Finish(
+          grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.message()));
+    }
+    return reactor;
+  }
+
+  grpc::ServerWriteReactor<routing::RoutingBatchResponse> *
+  RoutingBatch(grpc::CallbackServerContext *context,
+               const routing::RoutingBatchRequest *const request) override {
+    if (static_cast<size_t>(request->requests_size()) >
+        OrtoolsLib::SolverService::kMaxBatchItems) {
+      auto *reactor = new RoutingBatchReactor();
+      reactor->close(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                  "requests: too many"));
+      return reactor;
+    }
+    if (request->itemtimelimitms() > OrtoolsLib::Routing::kMaxTimeLimitMs) {
+      auto *reactor = new RoutingBatchReactor();
+      reactor->close(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                  "itemTimeLimitMs: too large"));
+      return reactor;
+    }
+
+    std::vector<OrtoolsLib::Routing> routings;
+    // request index of every routing, the others are invalid
+    std::vector<size_t> indices;
+    std::vector<routing::RoutingBatchResponse> invalid;
+    for (int index = 0; index < request->requests_size(); ++index) {
+      try {
+        routings.push_back(
+            _build(RoutingDTO::viewEntity(&request->requests(index))));
+        indices.push_back(index);
+      } catch (const OrtoolsLib::InvalidConfiguration &e) {
+        invalid.push_back(invalidItem(index, e.what()));
+      } catch (const RoutingDTO::ParseErrorElement &e) {
+        invalid.push_back(invalidItem(index, e.message()));
+      }
+    }
+
+    auto *reactor = new RoutingBatchReactor();
+    std::optional<int64_t> item_time_limit_ms;
+    if (request->itemtimelimitms() > 0) {
+      item_time_limit_ms = request->itemtimelimitms();
+    }
+    for (auto &response : invalid) {
+      reactor->write(std::move(response));
+    }
+    try {
+      _solver.solveBatch(
+          std::move(routings), item_time_limit_ms,
+          [reactor, indices = std::move(indices)](
+              const OrtoolsLib::SolverService::BatchItem &item) {
+            routing::RoutingBatchResponse response;
+            response.set_index(static_cast<int32_t>(indices[item.index]));
+            response.set_engine(OrtoolsLib::solverEngineName(item.engine));
+            if (item.responses) {
+              response.set_status("OK");
+              _addRoutes(*item.responses, response.mutable_routes());
+            } else {
+              response.set_status("NO_SOLUTION");
+              response.set_error(item.error);
+            }
+            reactor->write(std::move(response));
+          },
+          [reactor]() { reactor->close(grpc::Status::OK); }, reactor->token());
+    } catch (const OrtoolsLib::ExecutorSaturated &e) {
+      reactor->close(saturated(context, e));
+    }
+    return reactor;
+  }
+
+  grpc::ServerUnaryReactor *
+  CreateSession(grpc::CallbackServerContext *context,
+                const routing::RoutingRequest *const request,
+                routing::SessionResponse *const response) override {
+    OrtoolsLib::SessionStore::Created created;
+    try {
+      created = _solver.sessions().create(
+          _build(RoutingDTO::intoEntity(request)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.what()));
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.message()));
+    } catch (const OrtoolsLib::SessionLimitReached &e) {
+      return _finish(context,
+                     grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                  e.what()));
+    }
+
+    // the session stays open when its first solve is turned away, the
+    // client retries with UpdateSession or closes it
+    response->set_sessionid(created.id);
+    return _onWorker(context, [session = created.session, response]() {
+      _solveSession(*session, response);
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  UpdateSession(grpc::CallbackServerContext *context,
+                const routing::SessionDeltaRequest *const request,
+                routing::SessionResponse *const response) override {
+    const auto session = _solver.sessions().find(request->sessionid());
+    if (!session) {
+      return _finish(context, grpc::Status(grpc::StatusCode::NOT_FOUND,
+                                           "no such session"));
+    }
+
+    OrtoolsLib::SessionDelta delta;
+    try {
+      delta = RoutingDTO::intoSessionDelta(request);
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.message()));
+    }
+
+    response->set_sessionid(request->sessionid());
+    return _onWorker(context, [session, delta, response]() {
+      try {
+        _addRoutes(session->update(delta), response->mutable_routes());
+        response->set_status("OK");
+      } catch (const OrtoolsLib::InvalidConfiguration &e) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+      } catch (const std::runtime_error &) {
+        // the delta stays applied, the next one may make it feasible again
+        response->set_status("NO_SOLUTION");
+      }
+
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  CloseSession(grpc::CallbackServerContext *context,
+               const routing::SessionRequest *const request,
+               routing::SessionResponse *const response) override {
+    if (!_solver.sessions().close(request->sessionid())) {
+      return _finish(context, grpc::Status(grpc::StatusCode::NOT_FOUND,
+                                           "no such session"));
+    }
+
+    response->set_sessionid(request->sessionid());
+    response->set_status("CLOSED");
+    return _finish(context, grpc::Status::OK);
+  }
+
+  grpc::ServerUnaryReactor *
+  SubmitJob(grpc::CallbackServerContext *context,
+            const routing::RoutingRequest *const request,
+            routing::JobResponse *const response) override {
+    std::string id;
+    try {
+      id = _solver.submitJob(_build(RoutingDTO::intoEntity(request)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.what()));
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      return _finish(context, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                           e.message()));
+    } catch (const OrtoolsLib::ExecutorSaturated &e) {
+      return _finish(context, saturated(context, e));
+    }
+
+    _setJob(*_solver.jobs().find(id), response, false);
+    return _finish(context, grpc::Status::OK);
+  }
+
+  grpc::ServerUnaryReactor *
+  GetJob(grpc::CallbackServerContext *context,
+         const routing::JobRequest *const request,
+         routing::JobResponse *const response) override {
+    const auto job = _solver.jobs().find(request->jobid());
+    if (!job) {
+      return _finish(context,
+                     grpc::Status(grpc::StatusCode::NOT_FOUND, "no such job"));
+    }
+
+    _setJob(*job, response, false);
+    return _finish(context, grpc::Status::OK);
+  }
+
+  grpc::ServerUnaryReactor *
+  GetJobResult(grpc::CallbackServerContext *context,
+               const routing::JobRequest *const request,
+               routing::JobResponse *const response) override {
+    const auto job = _solver.jobs().find(request->jobid());
+    if (!job) {
+      return _finish(context,
+                     grpc::Status(grpc::StatusCode::NOT_FOUND, "no such job"));
+    }
+    if (!job->finished()) {
+      return _finish(context,
+                     grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                  "job has not finished"));
+    }
+
+    _setJob(*job, response, true);
+    return _finish(context, grpc::Status::OK);
+  }
+
+  grpc::ServerUnaryReactor *
+  CancelJob(grpc::CallbackServerContext *context,
+            const routing::JobRequest *const request,
+            routing::JobResponse *const response) override {
+    const bool cancelled = _solver.jobs().cancel(request->jobid());
+    const auto job = _solver.jobs().find(request->jobid());
+    if (!job) {
+      return _finish(context,
+                     grpc::Status(grpc::StatusCode::NOT_FOUND, "no such job"));
+    }
+    if (!cancelled) {
+      return _finish(context,
+                     grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                  "job has already finished"));
+    }
+
+    // a running job stays RUNNING until the solve notices
+    _setJob(*job, response, false);
+    return _finish(context, grpc::Status::OK);
+  }
+
+  // Writes the improving solutions of one RoutingStream call, then the final
+  // one. gRPC allows one write in flight, so an improvement arriving
+  // meanwhile replaces the one still waiting: a slow client skips
+  // intermediate solutions but always gets the newest and the final answer.
+  class RoutingStreamReactor
+      : public grpc::ServerWriteReactor<routing::RoutingResponse> {
+  public:
+    RoutingStreamReactor(OrtoolsLib::SolverService &solver,
+                         grpc::CallbackServerContext *context)
+        : _solver(solver), _context(context) {}
+
+    void start(std::shared_ptr<const OrtoolsLib::Routing> routing) {
+      try {
+        _solver.executor().submit(
+            [this, routing](std::chrono::milliseconds queue_wait) {
+              _run(*routing, queue_wait);
+            });
+      } catch (const OrtoolsLib::ExecutorSaturated &e) {
+        Finish(saturated(_context, e));
+      }
+    }
+
+    void OnWriteDone(bool ok) override {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (!ok) {
+        // the client is gone, the solve stops at its next check
+        _broken = true;
+        _pending.reset();
+        _token.cancel();
+      }
+      if (_pending) {
+        _writing = std::move(*_pending);
+        _pending.reset();
+        lock.unlock();
+        StartWrite(&_writing);
+      } else if (_final_status) {
+        lock.unlock();
+        _finishWithFinal();
+      } else {
+        _idle = true;
+      }
+    }
+
+    void OnCancel() override { _token.cancel(); }
+    void OnDone() override { delete this; }
+
+  private:
+    void _run(const OrtoolsLib::Routing &routing,
+              std::chrono::milliseconds queue_wait) {
+      _context->AddInitialMetadata("x-queue-wait-ms",
+                                   std::to_string(queue_wait.count()));
+      const char *engine =
+          OrtoolsLib::solverEngineName(routing.enginePlan().engine);
+      OrtoolsLib::SolutionStream stream(
+          [this, engine](const OrtoolsLib::SolutionUpdate &update) {
+            routing::RoutingResponse response;
+            response.set_status("IMPROVED");
+            response.set_engine(engine);
+            response.set_objective(update.objective);
+            response.set_elapsedms(update.elapsed_ms);
+            _addRoutes(update.responses, response.mutable_routes());
+            _write(std::move(response));
+          });
+
+      routing::RoutingResponse response;
+      response.set_engine(engine);
+      grpc::Status status = grpc::Status::OK;
+      try {
+        const OrtoolsLib::SharedResponses resp =
+            _solver.solve(routing, OrtoolsLib::SolveContext{
+                                       .solutions = &stream,
+                                       .cancellation = &_token,
+                                       .deadline = deadlineOf(*_context),
+                                   });
+        response.set_status("OK");
+        _addRoutes(*resp, response.mutable_routes());
+      } catch (const OrtoolsLib::InvalidConfiguration &e) {
+        status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+      } catch (const std::runtime_error &) {
+        response.set_status("NO_SOLUTION");
+      }
+      if (_token.cancelled()) {
+        status = grpc::Status::CANCELLED;
+      }
+
+      // the reactor may be gone once this returns
+      _complete(std::move(response), std::move(status));
+    }
+
+    void _write(routing::RoutingResponse response) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (_broken) {
+        return;
+      }
+      if (!_idle) {
+        _pending = std::move(response);
+        return;
+      }
+
+      _idle = false;
+      _writing = std::move(response);
+      lock.unlock();
+      StartWrite(&_writing);
+    }
+
+    void _complete(routing::RoutingResponse response, grpc::Status status) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _final = std::move(response);
+      _final_status = std::move(status);
+      if (!_idle) {
+        // OnWriteDone finishes once the write in flight is done
+        return;
+      }
+
+      lock.unlock();
+      _finishWithFinal();
+    }
+
+    void _finishWithFinal() {
+      if (_final_status->ok() && !_broken) {
+        StartWriteAndFinish(&_final, grpc::WriteOptions(), *_final_status);
+      } else {
+        Finish(*_final_status);
+      }
+    }
+
+    OrtoolsLib::SolverService &_solver;
+    grpc::CallbackServerContext *const _context;
+    OrtoolsLib::CancellationToken _token;
+    std::mutex _mutex;
+    // no write in flight
+    bool _idle = true;
+    bool _broken = false;
+    routing::RoutingResponse _writing;
+    std::optional<routing::RoutingResponse> _pending;
+    routing::RoutingResponse _final;
+    std::optional<grpc::Status> _final_status;
+  };
+
+  // Writes every item of one RoutingBatch call as it finishes, then ends the
+  // call once the batch is done. Unlike RoutingStreamReactor nothing is
+  // skipped: items waiting for the write in flight are queued.
+  class RoutingBatchReactor
+      : public grpc::ServerWriteReactor<routing::RoutingBatchResponse> {
+  public:
+    std::shared_ptr<const OrtoolsLib::CancellationToken> token() const {
+      return _token;
+    }
+
+    void write(routing::RoutingBatchResponse response) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (_broken) {
+        return;
+      }
+      _queue.push_back(std::move(response));
+      if (_writing) {
+        return;
+      }
+
+      _writing = true;
+      lock.unlock();
+      StartWrite(&_queue.front());
+    }
+
+    // no more writes follow, the call ends with `status` once they are sent
+    void close(grpc::Status status) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _status = std::move(status);
+      _closed = true;
+      if (_writing) {
+        // OnWriteDone finishes once the queue is drained
+        return;
+      }
+
+      lock.unlock();
+      _finish();
+    }
+
+    void OnWriteDone(bool ok) override {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _queue.pop_front();
+      if (!ok) {
+        // the client is gone, lanes stop before their next item
+        _broken = true;
+        _queue.clear();
+        _token->cancel();
+      }
+      if (!_queue.empty()) {
+        lock.unlock();
+        StartWrite(&_queue.front());
+        return;
+      }
+
+      _writing = false;
+      if (_closed) {
+        lock.unlock();
+        _finish();
+      }
+    }
+
+    void OnCancel() override { _token->cancel(); }
+    void OnDone() override { delete this; }
+
+  private:
+    void _finish() {
+      Finish(_token->cancelled() ? grpc::Status::CANCELLED : _status);
+    }
+
+    const std::shared_ptr<OrtoolsLib::CancellationToken> _token =
+        std::make_shared<OrtoolsLib::CancellationToken>();
+    std::mutex _mutex;
+    // front is the write in flight while _writing
+    std::deque<routing::RoutingBatchResponse> _queue;
+    bool _writing = false;
+    bool _closed = false;
+    bool _broken = false;
+    grpc::Status _status;
+  };
+
+  static grpc::ServerUnaryReactor *_finish(grpc::CallbackServerContext *context,
+                                           grpc::Status status) {
+    grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+    reactor->Finish(std::move(status));
+    return reactor;
+  }
+
+  // Runs `work` on a solver worker, which then finishes the call with the
+  // status it returns, INVALID_ARGUMENT when it throws InvalidConfiguration,
+  // and reports the time spent queued as x-queue-wait-ms initial metadata. A
+  // full queue finishes the call at once with RESOURCE_EXHAUSTED and a
+  // grpc-retry-pushback-ms trailer.
+  grpc::ServerUnaryReactor *_onWorker(grpc::CallbackServerContext *context,
+                                      std::function<grpc::Status()> work) {
+    grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+    try {
+      _solver.executor().submit([context, reactor, work = std::move(work)](
+                                    std::chrono::milliseconds queue_wait) {
+        context->AddInitialMetadata("x-queue-wait-ms",
+                                    std::to_string(queue_wait.count()));
+        grpc::Status status;
+        try {
+          status = work();
+        } catch (const OrtoolsLib::InvalidConfiguration &e) {
+          // e.g. locked routes that turn out to be infeasible
+          status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        } catch (const std::exception &e) {
+          status = grpc::Status(grpc::StatusCode::INTERNAL, e.what());
+        }
+        reactor->Finish(std::move(status));
+      });
+    } catch (const OrtoolsLib::ExecutorSaturated &e) {
+      reactor->Finish(saturated(context, e));
+    }
+    return reactor;
+  }
+
+  static OrtoolsLib::Routing _build(RoutingDTO::RoutingModel routing_model) {
+    return OrtoolsLib::Routing::builder()
+        .setDurationMatrix(std::move(routing_model.duration_matrix))
+        .setDepotConfig(std::move(routing_model.depot_config))
+        .setNumVehicles(routing_model.num_vehicles)
+        .setTimeLimit(routing_model.time_limit)
+        .withCapacity(std::move(routing_model.with_capacity))
+        .withPickupDelivery(std::move(routing_model.with_pickup_delivery))
+        .withTimeWindow(std::move(routing_model.with_time_window))
+        .withServiceTime(std::move(routing_model.with_service_time))
+        .withDropPenalties(std::move(routing_model.with_drop_penalties))
+        .withVehicleBreakTime(std::move(routing_model.with_vehicle_break_time))
+        .withPortfolio(std::move(routing_model.with_portfolio))
+        .withSearchOptions(std::move(routing_model.search_options))
+        .withInitialRoutes(std::move(routing_model.with_initial_routes))
+        .withLockedRoutes(std::move(routing_model.with_locked_routes))
+        .build();
+  }
+
+  static void
+  _addRoutes(const std::vector<OrtoolsLib::RoutingResponse> &responses,
+             google::protobuf::RepeatedPtrField<routing::vehicleRoute> *out) {
+    for (const auto &r : responses) {
+      auto *routes = out->Add();
       for (const auto &route : r.route) {
         routes->add_route(route);
       }
       routes->set_totalduration(r.total_duration);
     }
+  }
+
+  static void _setJob(const OrtoolsLib::JobRecord &job,
+                      routing::JobResponse *const response, bool with_routes) {
+    response->set_jobid(job.id);
+    response->set_state(OrtoolsLib::jobStateName(job.state));
+    response->set_engine(OrtoolsLib::solverEngineName(job.engine));
+    if (job.best_objective.has_value()) {
+      response->set_bestobjective(job.best_objective.value());
+    }
+    response->set_elapsedms(job.elapsed_ms);
+    response->set_error(job.error);
+    if (with_routes) {
+      _addRoutes(job.responses, response->mutable_routes());
+    }
+  }
 
-    return grpc::Status::OK;
+  // a delta that leaves no feasible solution keeps the session open
+  static void _solveSession(OrtoolsLib::RoutingSession &session,
+                            routing::SessionResponse *const response) {
+    try {
+      _addRoutes(session.solve(), response->mutable_routes());
+      response->set_status("OK");
+    } catch (const std::runtime_error &) {
+      response->set_status("NO_SOLUTION");
+    }
   }
+
+  OrtoolsLib::SolverService &_solver;
+  // gRPC has no allocator hook for streaming calls, which keep heap messages
+  ArenaMessageAllocator<routing::RoutingRequest, routing::RoutingResponse>
+      _routing_messages;
+  ArenaMessageAllocator<routing::RoutingRequest, routing::SessionResponse>
+      _session_messages;
+  ArenaMessageAllocator<routing::SessionDeltaRequest, routing::SessionResponse>
+      _delta_messages;
+  ArenaMessageAllocator<routing::RoutingRequest, routing::JobResponse>
+      _job_messages;
 };
 
-void RunServer() {
+void RunServer(OrtoolsLib::SolverService &solver) {
   std::string server_address("0.0.0.0:50051");
-  OrtoolsImpl service;
+  OrtoolsImpl service(solver);
 
   grpc::ServerBuilder builder;
   builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
@@ -1,15 +1,222 @@
 #include <drogon/HttpTypes.h>
 #include <drogon/drogon.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "dtos/routingDto.h"
+#include "lib/jobStore.h"
 #include "lib/routing.h"
+#include "lib/routingSession.h"
+#include "lib/sessionStore.h"
+#include "lib/solveContext.h"
+#include "lib/solverExecutor.h"
+#include "lib/solverService.h"
 
 namespace v1 {
 namespace routing {
-class route : public drogon::HttpController<route> {
+namespace {
+OrtoolsLib::Routing buildRouting(RoutingDTO::RoutingModel model) {
+  return OrtoolsLib::Routing::builder()
+      .setDurationMatrix(std::move(model.duration_matrix))
+      .setDepotConfig(std::move(model.depot_config))
+      .setNumVehicles(model.num_vehicles)
+      .setTimeLimit(model.time_limit)
+      .withCapacity(std::move(model.with_capacity))
+      .withPickupDelivery(std::move(model.with_pickup_delivery))
+      .withTimeWindow(std::move(model.with_time_window))
+      .withServiceTime(std::move(model.with_service_time))
+      .withDropPenalties(std::move(model.with_drop_penalties))
+      .withVehicleBreakTime(std::move(model.with_vehicle_break_time))
+      .withPortfolio(std::move(model.with_portfolio))
+      .withSearchOptions(std::move(model.search_options))
+      .withInitialRoutes(std::move(model.with_initial_routes))
+      .withLockedRoutes(std::move(model.with_locked_routes))
+      .build();
+}
+
+Json::Value
+routesToJson(const std::vector<OrtoolsLib::RoutingResponse> &responses) {
+  Json::Value routes;
+  for (const auto &r : responses) {
+    Json::Value route;
+    for (const auto &rout : r.route) {
+      route.append(rout);
+    }
+
+    Json::Value route_duration(r.total_duration);
+
+    Json::Value ret;
+    ret["routes"] = route;
+    ret["total_duration"] = route_duration;
+    routes.append(ret);
+  }
+  return routes;
+}
+
+drogon::HttpResponsePtr errorResponse(drogon::HttpStatusCode status,
+                                      const std::string &code,
+                                      const std::string &errors) {
+  Json::Value json;
+  json["code"] = code;
+  json["errors"] = errors;
+  auto resp = drogon::HttpResponse::newHttpJsonResponse(json);
+  resp->setStatusCode(status);
+  return resp;
+}
+
+Json::Value jobToJson(const OrtoolsLib::JobRecord &job, bool with_routes) {
+  Json::Value json;
+  json["jobId"] = job.id;
+  json["state"] = OrtoolsLib::jobStateName(job.state);
+  json["engine"] = OrtoolsLib::solverEngineName(job.engine);
+  json["bestObjective"] = job.best_objective.has_value()
+                              ? Json::Value(Json::Int64(*job.best_objective))
+                              : Json::Value(Json::nullValue);
+  json["elapsedMs"] = Json::Int64(job.elapsed_ms);
+  if (!job.error.empty()) {
+    json["error"] = job.error;
+  }
+  if (with_routes) {
+    json["routes"] = routesToJson(job.responses);
+  }
+  return json;
+}
+
+drogon::HttpResponsePtr jobResponse(const OrtoolsLib::JobRecord &job,
+                                    bool with_routes,
+                                    drogon::HttpStatusCode status) {
+  Json::Value jsonResp;
+  jsonResp["status"] = "success";
+  jsonResp["data"] = jobToJson(job, with_routes);
+
+  auto resp = drogon::HttpResponse::newHttpJsonResponse(jsonResp);
+  resp->setStatusCode(status);
+  return resp;
+}
+
+using Callback = std::function<void(const drogon::HttpResponsePtr &)>;
+
+drogon::HttpResponsePtr busyResponse(const OrtoolsLib::ExecutorSaturated &e) {
+  auto resp =
+      errorResponse(drogon::k429TooManyRequests, "SOLVER_BUSY", e.what());
+  // Retry-After counts whole seconds
+  resp->addHeader(
+      "Retry-After",
+      std::to_string(
+          std::chrono::ceil<std::chrono::seconds>(e.retry_after).count()));
+  return resp;
+}
+
+// Runs `respond` on a solver worker so solves never hold an IO thread, and
+// reports the time spent queued as X-Queue-Wait-Ms. InvalidConfiguration
+// thrown there is answered with 400, a full queue with 429 right away.
+void respondFromWorker(OrtoolsLib::SolverService &solver,
+                       const Callback &callback,
+                       std::function<drogon::HttpResponsePtr()> respond) {
+  try {
+    solver.executor().submit(
+        [callback, respond](std::chrono::milliseconds queue_wait) {
+          drogon::HttpResponsePtr resp;
+          try {
+            resp = respond();
+          } catch (const OrtoolsLib::InvalidConfiguration &e) {
+            // e.g. locked routes that turn out to be infeasible
+            resp = errorResponse(drogon::k400BadRequest,
+                                 "INVALID_CONFIGURATION", e.what());
+          } catch (const std::exception &e) {
+            resp = errorResponse(drogon::k500InternalServerError,
+                                 "INTERNAL_ERROR", e.what());
+          }
+          resp->addHeader("X-Queue-Wait-Ms",
+                          std::to_string(queue_wait.count()));
+          callback(resp);
+        });
+  } catch (const OrtoolsLib::ExecutorSaturated &e) {
+    callback(busyResponse(e));
+  }
+}
+
+// Newline-delimited JSON produced on a solver worker. Lines pushed before
+// drogon hands over the response stream are kept until it does.
+class NdjsonStream {
+public:
+  void attach(drogon::ResponseStreamPtr stream) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stream = std::move(stream);
+    if (!_pending.empty()) {
+      _send(_pending);
+      _pending.clear();
+    }
+    if (_done) {
+      _stream->close();
+    }
+  }
+
+  void push(const Json::Value &json) {
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    std::string line = Json::writeString(writer, json);
+    line += '\n';
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stream) {
+      _send(line);
+    } else {
+      _pending += line;
+    }
+  }
+
+  void finish() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _done = true;
+    if (_stream) {
+      _stream->close();
+    }
+  }
+
+  // a send failed, the client is gone
+  bool closed() const noexcept {
+    return _closed.load(std::memory_order_acquire);
+  }
+
+private:
+  void _send(const std::string &data) {
+    if (!_stream->send(data)) {
+      _closed.store(true, std::memory_order_release);
+    }
+  }
+
+  std::mutex _mutex;
+  drogon::ResponseStreamPtr _stream;
+  std::string _pending;
+  bool _done = false;
+  std::atomic<bool> _closed{false};
+};
+} // namespace
+
+// registered by hand so every handler shares the process-wide SolverService
+class route : public drogon::HttpController<route, false> {
 public:
+  explicit route(std::shared_ptr<OrtoolsLib::SolverService> solver)
+      : _solver(std::move(solver)) {}
+
   METHOD_LIST_BEGIN
   METHOD_ADD(route::routing, "", drogon::Post);
+  METHOD_ADD(route::stream, "/stream", drogon::Post);
+  METHOD_ADD(route::batch, "/batch", drogon::Post);
+  METHOD_ADD(route::stats, "/stats", drogon::Get);
   METHOD_LIST_END
 
   void
@@ -18,7 +225,7 @@ public:
 
     RoutingDTO::RoutingModel model;
     try {
-      model = RoutingDTO::parseJSON(req->getJsonObject());
+      model = RoutingDTO::parseJSONBody(req->body());
     } catch (const RoutingDTO::ParseErrorElement &e) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(e.toJson());
         resp->setStatusCode(drogon::k400BadRequest);
@@ -26,44 +233,494 @@ public:
         return;
     }
 
-    std::vector<OrtoolsLib::RoutingResponse> response =
-        OrtoolsLib::Routing::builder()
-            .setDurationMatrix(std::move(model.duration_matrix))
-            .setDepotConfig(std::move(model.depot_config))
-            .setNumVehicles(model.num_vehicles)
-            .setTimeLimit(model.time_limit)
-            .withCapacity(std::move(model.with_capacity))
-            .withPickupDelivery(std::move(model.with_pickup_delivery))
-            .withTimeWindow(std::move(model.with_time_window))
-            .withServiceTime(std::move(model.with_service_time))
-            .withDropPenalties(std::move(model.with_drop_penalties))
-            .withVehicleBreakTime(std::move(model.with_vehicle_break_time))
-            .build()
-            .solve();
-
-    Json::Value routes;
-    for (const auto &r : response) {
-      Json::Value route;
-      for (const auto &rout : r.route) {
-        route.append(rout);
+    std::shared_ptr<const OrtoolsLib::Routing> routing;
+    try {
+      routing = std::make_shared<const OrtoolsLib::Routing>(
+          buildRouting(std::move(model)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      callback(errorResponse(drogon::k400BadRequest, "INVALID_CONFIGURATION",
+                             e.what()));
+      return;
+    }
+
+    respondFromWorker(*_solver, callback, [req, solver = _solver, routing]() {
+      const OrtoolsLib::CancellationToken token(
+          [&req]() { return !req->connected(); });
+      Json::Value jsonResp;
+      try {
+        jsonResp["data"] = routesToJson(*solver->solve(
+            *routing, OrtoolsLib::SolveContext{.cancellation = &token}));
+        jsonResp["status"] = "success";
+      } catch (const std::runtime_error &e) {
+        // an answer like the stream, batch and session ones, not a failure
+        jsonResp["status"] = "no_solution";
+        jsonResp["data"] = Json::Value(Json::arrayValue);
+        jsonResp["errors"] = e.what();
       }
+      jsonResp["engine"] =
+          OrtoolsLib::solverEngineName(routing->enginePlan().engine);
 
-      Json::Value route_duration(r.total_duration);
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(jsonResp);
+      resp->setStatusCode(drogon::k200OK);
+      return resp;
+    });
+  }
 
-      Json::Value ret;
-      ret["routes"] = route;
-      ret["total_duration"] = route_duration;
-      routes.append(ret);
+  // one line per improving solution ("status": "improved", with "objective",
+  // "elapsedMs" and "engine"), then a final line as the routing endpoint
+  // would answer plus "queueWaitMs"
+  void
+  stream(const drogon::HttpRequestPtr &req,
+         std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    RoutingDTO::RoutingModel model;
+    try {
+      model = RoutingDTO::parseJSONBody(req->body());
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(e.toJson());
+      resp->setStatusCode(drogon::k400BadRequest);
+      callback(resp);
+      return;
     }
 
+    std::shared_ptr<const OrtoolsLib::Routing> routing;
+    try {
+      routing = std::make_shared<const OrtoolsLib::Routing>(
+          buildRouting(std::move(model)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      callback(errorResponse(drogon::k400BadRequest, "INVALID_CONFIGURATION",
+                             e.what()));
+      return;
+    }
+
+    auto lines = std::make_shared<NdjsonStream>();
+    try {
+      _solver->executor().submit([lines, req, solver = _solver, routing](
+                                     std::chrono::milliseconds queue_wait) {
+        _stream(*solver, *routing, req, *lines, queue_wait);
+      });
+    } catch (const OrtoolsLib::ExecutorSaturated &e) {
+      callback(busyResponse(e));
+      return;
+    }
+
+    auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+        [lines](drogon::ResponseStreamPtr stream) {
+          lines->attach(std::move(stream));
+        });
+    resp->setContentTypeCodeAndCustomString(drogon::CT_CUSTOM,
+                                            "application/x-ndjson");
+    resp->setStatusCode(drogon::k200OK);
+    callback(resp);
+  }
+
+  // {"requests": [...], "itemTimeLimitMs": n}, answered with one line per
+  // request as it finishes: {"index", "status", "engine", "data"}, where
+  // status is "success", "no_solution" (with "errors" saying why instead of
+  // "data") or "invalid" (with "errors" instead of "data" and no "engine")
+  void
+  batch(const drogon::HttpRequestPtr &req,
+        std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    const auto json = req->getJsonObject();
+    if (!json || !(*json)["requests"].isArray()) {
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(
+          RoutingDTO::ParseErrorElement("requests").toJson());
+      resp->setStatusCode(drogon::k400BadRequest);
+      callback(resp);
+      return;
+    }
+    if ((*json)["requests"].size() >
+        OrtoolsLib::SolverService::kMaxBatchItems) {
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(
+          RoutingDTO::ParseErrorElement("requests", {"too many"}).toJson());
+      resp->setStatusCode(drogon::k400BadRequest);
+      callback(resp);
+      return;
+    }
+    std::optional<int64_t> item_time_limit_ms;
+    if (json->isMember("itemTimeLimitMs")) {
+      const Json::Value &limit = (*json)["itemTimeLimitMs"];
+      if (!limit.isInt64() || limit.asInt64() <= 0) {
+        auto resp = drogon::HttpResponse::newHttpJsonResponse(
+            RoutingDTO::ParseErrorElement("itemTimeLimitMs").toJson());
+        resp->setStatusCode(drogon::k400BadRequest);
+        callback(resp);
+        return;
+      }
+      if (limit.asInt64() > OrtoolsLib::Routing::kMaxTimeLimitMs) {
+        auto resp = drogon::HttpResponse::newHttpJsonResponse(
+            RoutingDTO::ParseErrorElement("itemTimeLimitMs", {"too large"})
+                .toJson());
+        resp->setStatusCode(drogon::k400BadRequest);
+        callback(resp);
+        return;
+      }
+      item_time_limit_ms = limit.asInt64();
+    }
+
+    std::vector<OrtoolsLib::Routing> routings;
+    // request index of every routing, the others are invalid
+    std::vector<size_t> indices;
+    std::vector<Json::Value> invalid;
+    const Json::Value &requests = (*json)["requests"];
+    for (Json::ArrayIndex index = 0; index < requests.size(); ++index) {
+      Json::Value line;
+      line["index"] = index;
+      line["status"] = "invalid";
+      try {
+        routings.push_back(buildRouting(RoutingDTO::parseJSON(
+            std::make_shared<Json::Value>(requests[index]))));
+        indices.push_back(index);
+        continue;
+      } catch (const RoutingDTO::ParseErrorElement &e) {
+        line["errors"] = e.toJson();
+      } catch (const OrtoolsLib::InvalidConfiguration &e) {
+        line["errors"] = e.what();
+      }
+      invalid.push_back(std::move(line));
+    }
+
+    auto lines = std::make_shared<NdjsonStream>();
+    for (const auto &line : invalid) {
+      lines->push(line);
+    }
+    const auto token = std::make_shared<OrtoolsLib::CancellationToken>(
+        [lines, req]() { return lines->closed() || !req->connected(); });
+    try {
+      _solver->solveBatch(
+          std::move(routings), item_time_limit_ms,
+          [lines, indices = std::move(indices)](
+              const OrtoolsLib::SolverService::BatchItem &item) {
+            Json::Value line;
+            line["index"] = Json::UInt64(indices[item.index]);
+            line["engine"] = OrtoolsLib::solverEngineName(item.engine);
+            if (item.responses) {
+              line["status"] = "success";
+              line["data"] = routesToJson(*item.responses);
+            } else {
+              line["status"] = "no_solution";
+              line["errors"] = item.error;
+            }
+            lines->push(line);
+          },
+          [lines]() { lines->finish(); }, token);
+    } catch (const OrtoolsLib::ExecutorSaturated &e) {
+      callback(busyResponse(e));
+      return;
+    }
+
+    auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+        [lines](drogon::ResponseStreamPtr stream) {
+          lines->attach(std::move(stream));
+        });
+    resp->setContentTypeCodeAndCustomString(drogon::CT_CUSTOM,
+                                            "application/x-ndjson");
+    resp->setStatusCode(drogon::k200OK);
+    callback(resp);
+  }
+
+  void
+  stats(const drogon::HttpRequestPtr &req,
+        std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    const OrtoolsLib::SolverService::Stats solver_stats = _solver->stats();
+    const OrtoolsLib::SolutionCache::Stats &cache = solver_stats.cache;
+
+    Json::Value cacheJson;
+    cacheJson["hits"] = Json::UInt64(cache.hits);
+    cacheJson["misses"] = Json::UInt64(cache.misses);
+    cacheJson["insertions"] = Json::UInt64(cache.insertions);
+    cacheJson["evictions"] = Json::UInt64(cache.evictions);
+    cacheJson["entries"] = Json::UInt64(cache.entries);
+    cacheJson["bytes"] = Json::UInt64(cache.bytes);
+
+    const OrtoolsLib::SolverExecutor::Stats &executor = solver_stats.executor;
+    Json::Value executorJson;
+    executorJson["workers"] = Json::UInt64(executor.workers);
+    executorJson["queued"] = Json::UInt64(executor.queued);
+    executorJson["running"] = Json::UInt64(executor.running);
+    executorJson["started"] = Json::UInt64(executor.started);
+    executorJson["rejected"] = Json::UInt64(executor.rejected);
+    executorJson["totalWaitMs"] = Json::Int64(executor.total_wait_ms);
+    executorJson["maxWaitMs"] = Json::Int64(executor.max_wait_ms);
+
     Json::Value jsonResp;
     jsonResp["status"] = "success";
-    jsonResp["data"] = routes;
+    jsonResp["data"]["cache"] = cacheJson;
+    jsonResp["data"]["coalesced"] = Json::UInt64(solver_stats.coalesced);
+    jsonResp["data"]["executor"] = executorJson;
+    jsonResp["data"]["sessions"] = Json::UInt64(_solver->sessions().size());
 
     auto resp = drogon::HttpResponse::newHttpJsonResponse(jsonResp);
     resp->setStatusCode(drogon::k200OK);
     callback(resp);
   }
+
+private:
+  static void _stream(OrtoolsLib::SolverService &solver,
+                      const OrtoolsLib::Routing &routing,
+                      const drogon::HttpRequestPtr &req, NdjsonStream &lines,
+                      std::chrono::milliseconds queue_wait) {
+    const OrtoolsLib::CancellationToken token(
+        [&lines, &req]() { return lines.closed() || !req->connected(); });
+    const char *engine =
+        OrtoolsLib::solverEngineName(routing.enginePlan().engine);
+    OrtoolsLib::SolutionStream solutions(
+        [&lines, engine](const OrtoolsLib::SolutionUpdate &update) {
+          Json::Value line;
+          line["status"] = "improved";
+          line["engine"] = engine;
+          line["objective"] = Json::Int64(update.objective);
+          line["elapsedMs"] = Json::Int64(update.elapsed_ms);
+          line["data"] = routesToJson(update.responses);
+          lines.push(line);
+        });
+
+    Json::Value line;
+    try {
+      line["data"] = routesToJson(*solver.solve(
+          routing, OrtoolsLib::SolveContext{
+                       .solutions = &solutions,
+                       .cancellation = &token,
+                   }));
+      line["status"] = "success";
+    } catch (const std::runtime_error &e) {
+      line["status"] = "no_solution";
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      line["status"] = "invalid_configuration";
+    }
+    line["engine"] = engine;
+    line["queueWaitMs"] = Json::Int64(queue_wait.count());
+    lines.push(line);
+    lines.finish();
+  }
+
+  std::shared_ptr<OrtoolsLib::SolverService> _solver;
+};
+
+// Stateful routing: the request is kept on the server after the first solve
+// and later requests only send what changed.
+class session : public drogon::HttpController<session, false> {
+public:
+  explicit session(std::shared_ptr<OrtoolsLib::SolverService> solver)
+      : _solver(std::move(solver)) {}
+
+  METHOD_LIST_BEGIN
+  METHOD_ADD(session::create, "", drogon::Post);
+  METHOD_ADD(session::update, "/{1}/deltas", drogon::Post);
+  METHOD_ADD(session::get, "/{1}", drogon::Get);
+  METHOD_ADD(session::close, "/{1}", drogon::Delete);
+  METHOD_LIST_END
+
+  void create(const drogon::HttpRequestPtr &req,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    RoutingDTO::RoutingModel model;
+    try {
+      model = RoutingDTO::parseJSON(req->getJsonObject());
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(e.toJson());
+      resp->setStatusCode(drogon::k400BadRequest);
+      callback(resp);
+      return;
+    }
+
+    OrtoolsLib::SessionStore::Created created;
+    try {
+      created = _solver->sessions().create(buildRouting(std::move(model)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      callback(errorResponse(drogon::k400BadRequest, "INVALID_CONFIGURATION",
+                             e.what()));
+      return;
+    } catch (const OrtoolsLib::SessionLimitReached &e) {
+      callback(errorResponse(drogon::k429TooManyRequests,
+                             "TOO_MANY_SESSIONS", e.what()));
+      return;
+    }
+
+    // the session stays open when its first solve is turned away, the
+    // client retries with a delta or closes it
+    respondFromWorker(*_solver, callback, [created]() {
+      return _solve(created.id, [&created] { return created.session->solve(); },
+                    drogon::k201Created);
+    });
+  }
+
+  void update(const drogon::HttpRequestPtr &req,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+              const std::string &id) {
+    const auto found = _solver->sessions().find(id);
+    if (!found) {
+      callback(errorResponse(drogon::k404NotFound, "NOT_FOUND",
+                             "no such session"));
+      return;
+    }
+
+    OrtoolsLib::SessionDelta delta;
+    try {
+      delta = RoutingDTO::parseSessionDelta(req->getJsonObject());
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(e.toJson());
+      resp->setStatusCode(drogon::k400BadRequest);
+      callback(resp);
+      return;
+    }
+
+    respondFromWorker(*_solver, callback, [id, found, delta]() {
+      try {
+        return _solve(id, [&found, &delta] { return found->update(delta); },
+                      drogon::k200OK);
+      } catch (const OrtoolsLib::InvalidConfiguration &e) {
+        return errorResponse(drogon::k400BadRequest, "INVALID_CONFIGURATION",
+                             e.what());
+      }
+    });
+  }
+
+  void get(const drogon::HttpRequestPtr &req,
+           std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+           const std::string &id) {
+    const auto found = _solver->sessions().find(id);
+    if (!found) {
+      callback(errorResponse(drogon::k404NotFound, "NOT_FOUND",
+                             "no such session"));
+      return;
+    }
+
+    callback(_solve(id, [&found] { return found->lastSolution(); },
+                    drogon::k200OK));
+  }
+
+  void close(const drogon::HttpRequestPtr &req,
+             std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+             const std::string &id) {
+    if (!_solver->sessions().close(id)) {
+      callback(errorResponse(drogon::k404NotFound, "NOT_FOUND",
+                             "no such session"));
+      return;
+    }
+
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setStatusCode(drogon::k204NoContent);
+    callback(resp);
+  }
+
+private:
+  // a solve that finds nothing keeps the session open, a later delta may make
+  // it feasible again
+  template <class Solve>
+  static drogon::HttpResponsePtr
+  _solve(const std::string &id, Solve &&solve, drogon::HttpStatusCode status) {
+    Json::Value jsonResp;
+    try {
+      jsonResp["data"] = routesToJson(solve());
+      jsonResp["status"] = "success";
+    } catch (const std::runtime_error &e) {
+      jsonResp["status"] = "no_solution";
+      jsonResp["data"] = Json::Value(Json::arrayValue);
+    }
+    jsonResp["sessionId"] = id;
+
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(jsonResp);
+    resp->setStatusCode(status);
+    return resp;
+  }
+
+  std::shared_ptr<OrtoolsLib::SolverService> _solver;
+};
+
+// Background solves for optimizations too long to hold a request open:
+// submit answers at once with a job id to poll, results are kept on disk.
+class job : public drogon::HttpController<job, false> {
+public:
+  explicit job(std::shared_ptr<OrtoolsLib::SolverService> solver)
+      : _solver(std::move(solver)) {}
+
+  METHOD_LIST_BEGIN
+  METHOD_ADD(job::submit, "", drogon::Post);
+  METHOD_ADD(job::status, "/{1}", drogon::Get);
+  METHOD_ADD(job::result, "/{1}/result", drogon::Get);
+  METHOD_ADD(job::cancel, "/{1}/cancel", drogon::Post);
+  METHOD_LIST_END
+
+  void submit(const drogon::HttpRequestPtr &req,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    RoutingDTO::RoutingModel model;
+    try {
+      model = RoutingDTO::parseJSON(req->getJsonObject());
+    } catch (const RoutingDTO::ParseErrorElement &e) {
+      auto resp = drogon::HttpResponse::newHttpJsonResponse(e.toJson());
+      resp->setStatusCode(drogon::k400BadRequest);
+      callback(resp);
+      return;
+    }
+
+    std::string id;
+    try {
+      id = _solver->submitJob(buildRouting(std::move(model)));
+    } catch (const OrtoolsLib::InvalidConfiguration &e) {
+      callback(errorResponse(drogon::k400BadRequest, "INVALID_CONFIGURATION",
+                             e.what()));
+      return;
+    } catch (const OrtoolsLib::ExecutorSaturated &e) {
+      callback(busyResponse(e));
+      return;
+    }
+
+    callback(
+        jobResponse(*_solver->jobs().find(id), false, drogon::k202Accepted));
+  }
+
+  void status(const drogon::HttpRequestPtr &req,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+              const std::string &id) {
+    const auto found = _solver->jobs().find(id);
+    if (!found) {
+      callback(
+          errorResponse(drogon::k404NotFound, "NOT_FOUND", "no such job"));
+      return;
+    }
+
+    callback(jobResponse(*found, false, drogon::k200OK));
+  }
+
+  void result(const drogon::HttpRequestPtr &req,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+              const std::string &id) {
+    const auto found = _solver->jobs().find(id);
+    if (!found) {
+      callback(
+          errorResponse(drogon::k404NotFound, "NOT_FOUND", "no such job"));
+      return;
+    }
+    if (!found->finished()) {
+      callback(errorResponse(drogon::k409Conflict, "NOT_FINISHED",
+                             "job has not finished"));
+      return;
+    }
+
+    callback(jobResponse(*found, true, drogon::k200OK));
+  }
+
+  void cancel(const drogon::HttpRequestPtr &req,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+              const std::string &id) {
+    const bool cancelled = _solver->jobs().cancel(id);
+    const auto found = _solver->jobs().find(id);
+    if (!found) {
+      callback(
+          errorResponse(drogon::k404NotFound, "NOT_FOUND", "no such job"));
+      return;
+    }
+    if (!cancelled) {
+      callback(errorResponse(drogon::k409Conflict, "ALREADY_FINISHED",
+                             "job has already finished"));
+      return;
+    }
+
+    // a running job stays RUNNING until the solve notices
+    callback(jobResponse(*found, false, drogon::k202Accepted));
+  }
+
+private:
+  std::shared_ptr<OrtoolsLib::SolverService> _solver;
 };
 } // namespace routing
 } // namespace v1
@@ -0,0 +1,117 @@
+#include "cooperativeSearch.h"
+#include "earlyStop.h"
+#include "incumbent.h"
+#include "portfolio.h"
+#include "searchParameters.h"
+#include "threadPool.h"
+#include "transitMatrix.h"
+
+#include <ortools/constraint_solver/constraint_solver.h>
+#include <ortools/constraint_solver/routing.h>
+
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+std::optional<RoutingSolution>
+cooperate(const Routing &routing, const SearchStrategy &strategy,
+          Incumbent &incumbent, EarlyStop &early_stop, const Deadline &deadline,
+          const SolveContext &context, SharedTransitMatrix &transit) {
+  RoutingInstance instance(routing, &transit);
+  instance.attach(context);
+  instance.attach(early_stop);
+  operations_research::RoutingModel &model = instance.model();
+
+  // best objective this worker found or restarted from
+  int64_t own_objective = std::numeric_limits<int64_t>::max();
+  model.AddAtSolutionCallback([&]() {
+    const int64_t objective = model.CostVar()->Value();
+    if (objective < own_objective) {
+      own_objective = objective;
+    }
+    if (objective < incumbent.objective()) {
+      incumbent.publish(objective, instance.currentRoutes());
+    }
+  });
+  model.AddSearchMonitor(model.solver()->MakeCustomLimit(
+      [&]() { return incumbent.objective() < own_objective; }));
+
+  std::optional<RoutingSolution> best;
+  std::shared_ptr<const Incumbent::Snapshot> restart;
+  while (true) {
+    const std::optional<int64_t> remaining_ms = remainingMs(deadline);
+    if ((remaining_ms.has_value() && remaining_ms.value() <= 0) ||
+        context.cancelled() || early_stop.reached()) {
+      break;
+    }
+
+    const auto parameters = makeSearchParameters(
+        strategy, routing.searchOptions(), remaining_ms);
+    std::optional<RoutingSolution> solution =
+        restart ? instance.solveFrom(restart->routes, parameters)
+                : instance.solve(parameters);
+    if (solution && (!best || solution->objective < best->objective)) {
+      best = std::move(solution);
+    }
+
+    // a search that ended on its own with nothing better published would
+    // only replay itself
+    restart = incumbent.snapshot();
+    if (!restart || restart->objective >= own_objective) {
+      break;
+    }
+    own_objective = restart->objective;
+  }
+
+  return best;
+}
+} // namespace
+
+std::optional<RoutingSolution>
+solveCooperative(const Routing &routing,
+                 const RoutingOptionWithPortfolio &portfolio,
+                 std::optional<int64_t> time_limit_ms,
+                 const SolveContext &context) {
+  const std::vector<SearchStrategy> &strategies =
+      portfolio.strategies.empty() ? defaultPortfolio() : portfolio.strategies;
+  const size_t num_workers = portfolioWorkers(portfolio, strategies.size());
+
+  const Deadline deadline = deadlineAfter(time_limit_ms);
+  Incumbent incumbent;
+  SharedTransitMatrix transit;
+  // judged on the best objective of all workers
+  EarlyStop early_stop(routing.searchOptions());
+
+  std::vector<std::future<std::optional<RoutingSolution>>> results;
+  results.reserve(num_workers);
+  {
+    // every worker runs until the deadline, they all need a thread
+    ThreadPool pool(num_workers);
+    for (size_t worker = 0; worker < num_workers; ++worker) {
+      const SearchStrategy &strategy = strategies[worker % strategies.size()];
+      results.push_back(pool.submit([&routing, strategy, &incumbent,
+                                     &early_stop, deadline, &context,
+                                     &transit]() {
+        return cooperate(routing, strategy, incumbent, early_stop, deadline,
+                         context, transit);
+      }));
+    }
+  }
+
+  std::optional<RoutingSolution> best;
+  for (auto &result : results) {
+    std::optional<RoutingSolution> solution = result.get();
+    if (solution && (!best || solution->objective < best->objective)) {
+      best = std::move(solution);
+    }
+  }
+
+  return best;
+}
+} // namespace OrtoolsLib
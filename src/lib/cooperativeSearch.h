@@ -0,0 +1,25 @@
+#ifndef COOPERATIVE_SEARCH_H
+#define COOPERATIVE_SEARCH_H
+
+#include "routing.h"
+#include "routingInstance.h"
+#include "solveContext.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace OrtoolsLib {
+// Like solvePortfolio, but the workers share an Incumbent. Every solution a
+// worker finds that beats the incumbent is published to it; a worker whose
+// own best falls behind the incumbent stops its current search and restarts
+// local search from the incumbent routes. Workers beyond the number of
+// strategies cycle through them again; there is one worker per thread, so
+// strategies beyond the hardware threads are left out.
+std::optional<RoutingSolution>
+solveCooperative(const Routing &routing,
+                 const RoutingOptionWithPortfolio &portfolio,
+                 std::optional<int64_t> time_limit_ms,
+                 const SolveContext &context);
+} // namespace OrtoolsLib
+
+#endif // COOPERATIVE_SEARCH_H
@@ -0,0 +1,170 @@
+#include "durationMatrix.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+DurationMatrix::DurationMatrix(size_t n)
+    : _n(n), _stride(_strideFor(n)), _rows(n),
+      _data(_allocate(n * _strideFor(n))), _values(_data.get()) {}
+
+DurationMatrix::DurationMatrix(const DurationMatrix &other)
+    : _n(other._n), _stride(other._stride), _rows(other._n) {
+  if (other.isView()) {
+    _values = other._values;
+    _owner = other._owner;
+    return;
+  }
+
+  _data = _allocate(_n * _stride);
+  _values = _data.get();
+  if (_data) {
+    std::memcpy(_data.get(), other._data.get(),
+                _n * _stride * sizeof(int64_t));
+  }
+}
+
+DurationMatrix &DurationMatrix::operator=(const DurationMatrix &other) {
+  if (this != &other) {
+    *this = DurationMatrix(other);
+  }
+  return *this;
+}
+
+DurationMatrix::DurationMatrix(DurationMatrix &&other) noexcept
+    : _n(std::exchange(other._n, 0)), _stride(std::exchange(other._stride, 0)),
+      _rows(std::exchange(other._rows, 0)), _data(std::move(other._data)),
+      _values(std::exchange(other._values, nullptr)),
+      _owner(std::move(other._owner)) {}
+
+DurationMatrix &DurationMatrix::operator=(DurationMatrix &&other) noexcept {
+  _n = std::exchange(other._n, 0);
+  _stride = std::exchange(other._stride, 0);
+  _rows = std::exchange(other._rows, 0);
+  _data = std::move(other._data);
+  _values = std::exchange(other._values, nullptr);
+  _owner = std::move(other._owner);
+  return *this;
+}
+
+void DurationMatrix::reserve(size_t capacity) {
+  if (capacity > this->capacity()) {
+    _reallocate(capacity);
+  }
+}
+
+void DurationMatrix::appendNode(std::span<const int64_t> to,
+                                std::span<const int64_t> from) {
+  if (to.size() != _n || from.size() != _n) {
+    throw std::invalid_argument("appended node does not match the matrix");
+  }
+  if (_n + 1 > capacity()) {
+    _reallocate(std::max(_n + 1, 2 * _n));
+  }
+
+  for (size_t i = 0; i < _n; ++i) {
+    (*this)[i][_n] = from[i];
+  }
+  std::copy(to.begin(), to.end(), (*this)[_n]);
+  (*this)[_n][_n] = 0;
+  ++_n;
+}
+
+DurationMatrix
+DurationMatrix::fromRows(const std::vector<std::vector<int64_t>> &rows) {
+  DurationMatrix matrix(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (rows[i].size() != rows.size()) {
+      throw std::invalid_argument("durationMatrix is not square");
+    }
+    std::copy(rows[i].begin(), rows[i].end(), matrix[i]);
+  }
+
+  return matrix;
+}
+
+DurationMatrix DurationMatrix::view(std::span<const int64_t> values, size_t n,
+                                    std::shared_ptr<const void> owner) {
+  if (values.size() != n * n) {
+    throw std::invalid_argument("durationMatrix is not square");
+  }
+
+  DurationMatrix matrix;
+  matrix._n = n;
+  matrix._stride = n;
+  matrix._rows = n;
+  // an empty view is just an empty matrix
+  matrix._values = n > 0 ? values.data() : nullptr;
+  matrix._owner = std::move(owner);
+  return matrix;
+}
+
+bool DurationMatrix::isZeroRow(size_t from) const noexcept {
+  const auto values = row(from);
+  return std::all_of(values.begin(), values.end(),
+                     [](int64_t value) { return value == 0; });
+}
+
+bool DurationMatrix::isBoundedBy(int64_t bound) const noexcept {
+  for (size_t i = 0; i < _n; ++i) {
+    // min and max of a whole row vectorize, an early exit would not
+    int64_t low = 0;
+    int64_t high = 0;
+    for (const int64_t value : row(i)) {
+      low = std::min(low, value);
+      high = std::max(high, value);
+    }
+    if (low < -bound || high > bound) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DurationMatrix::operator==(const DurationMatrix &other) const noexcept {
+  if (_n != other._n) {
+    return false;
+  }
+
+  for (size_t i = 0; i < _n; ++i) {
+    const auto lhs = row(i);
+    const auto rhs = other.row(i);
+    if (!std::equal(lhs.begin(), lhs.end(), rhs.begin())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void DurationMatrix::_reallocate(size_t capacity) {
+  const size_t stride = _strideFor(capacity);
+  Buffer data = _allocate(capacity * stride);
+  for (size_t i = 0; i < _n; ++i) {
+    std::copy_n(_values + i * _stride, _n, data.get() + i * stride);
+  }
+
+  _stride = stride;
+  _rows = capacity;
+  _data = std::move(data);
+  _values = _data.get();
+  _owner.reset();
+}
+
+DurationMatrix::Buffer DurationMatrix::_allocate(size_t count) {
+  if (count == 0) {
+    return nullptr;
+  }
+
+  auto *ptr = static_cast<int64_t *>(::operator new[](
+      count * sizeof(int64_t), std::align_val_t{kAlignment}));
+  std::fill_n(ptr, count, int64_t{0});
+  return Buffer(ptr);
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,110 @@
+#ifndef DURATION_MATRIX_H
+#define DURATION_MATRIX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace OrtoolsLib {
+// Square matrix of int64 stored row-major in a single cache-line aligned
+// allocation. Every row is padded to a whole number of cache lines, so
+// `m[from][to]` is one multiply-add away from the base pointer and a row never
+// straddles a line it does not own.
+//
+// A matrix can also be a view over values owned elsewhere (see view()), e.g.
+// the packed field of a request: reading it copies nothing, and neither does
+// copying the view. The first write through a view copies it into a buffer of
+// its own.
+class DurationMatrix {
+public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kLaneCount = kAlignment / sizeof(int64_t);
+
+  DurationMatrix() = default;
+  // zero-filled n x n matrix
+  explicit DurationMatrix(size_t n);
+
+  DurationMatrix(const DurationMatrix &other);
+  DurationMatrix &operator=(const DurationMatrix &other);
+  DurationMatrix(DurationMatrix &&other) noexcept;
+  DurationMatrix &operator=(DurationMatrix &&other) noexcept;
+  ~DurationMatrix() = default;
+
+  // throws std::invalid_argument when the rows do not form a square matrix
+  static DurationMatrix fromRows(const std::vector<std::vector<int64_t>> &rows);
+  // n x n matrix read in place from the n * n `values`, row by row. The values
+  // must outlive the view and all its copies, `owner` (if any) is kept alive
+  // with them. Throws std::invalid_argument when the size does not match.
+  static DurationMatrix view(std::span<const int64_t> values, size_t n,
+                             std::shared_ptr<const void> owner = nullptr);
+
+  size_t size() const noexcept { return _n; }
+  bool empty() const noexcept { return _n == 0; }
+  size_t stride() const noexcept { return _stride; }
+  bool isView() const noexcept { return _values != _data.get(); }
+  // nodes that fit before appendNode has to reallocate
+  size_t capacity() const noexcept { return std::min(_rows, _stride); }
+
+  // makes room for `capacity` nodes, never shrinks
+  void reserve(size_t capacity);
+  // adds node `size()`; `to[i]` is its duration to node i and `from[i]` the
+  // duration from node i to it, both of length size(). Reallocates (doubling)
+  // only when capacity() is exhausted.
+  void appendNode(std::span<const int64_t> to, std::span<const int64_t> from);
+
+  int64_t *operator[](size_t from) {
+    if (isView()) {
+      _reallocate(_n);
+    }
+    return _data.get() + from * _stride;
+  }
+  const int64_t *operator[](size_t from) const noexcept {
+    return _values + from * _stride;
+  }
+  int64_t operator()(size_t from, size_t to) const noexcept {
+    return _values[from * _stride + to];
+  }
+
+  std::span<int64_t> row(size_t from) { return {(*this)[from], _n}; }
+  std::span<const int64_t> row(size_t from) const noexcept {
+    return {(*this)[from], _n};
+  }
+
+  const int64_t *data() const noexcept { return _values; }
+
+  bool isZeroRow(size_t from) const noexcept;
+  // whether every duration lies within [-bound, bound]
+  bool isBoundedBy(int64_t bound) const noexcept;
+  bool operator==(const DurationMatrix &other) const noexcept;
+
+private:
+  struct AlignedDelete {
+    void operator()(int64_t *ptr) const noexcept {
+      ::operator delete[](ptr, std::align_val_t{kAlignment});
+    }
+  };
+  using Buffer = std::unique_ptr<int64_t[], AlignedDelete>;
+
+  static size_t _strideFor(size_t n) noexcept {
+    return (n + kLaneCount - 1) / kLaneCount * kLaneCount;
+  }
+  static Buffer _allocate(size_t count);
+  // into a buffer of its own, which ends a view
+  void _reallocate(size_t capacity);
+
+  size_t _n = 0;
+  size_t _stride = 0;
+  // rows the buffer holds, at least _n
+  size_t _rows = 0;
+  Buffer _data;
+  // what reads go through: _data.get(), or the viewed values
+  const int64_t *_values = nullptr;
+  std::shared_ptr<const void> _owner;
+};
+} // namespace OrtoolsLib
+
+#endif // DURATION_MATRIX_H
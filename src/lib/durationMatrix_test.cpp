@@ -0,0 +1,130 @@
+#include "durationMatrix.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+TEST(DurationMatrixTest, RowsAreCacheLineAligned) {
+  OrtoolsLib::DurationMatrix matrix(13);
+
+  EXPECT_EQ(matrix.size(), 13);
+  EXPECT_EQ(matrix.stride() % OrtoolsLib::DurationMatrix::kLaneCount, 0);
+  for (size_t i = 0; i < matrix.size(); ++i) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(matrix[i]) %
+                  OrtoolsLib::DurationMatrix::kAlignment,
+              0);
+    EXPECT_TRUE(matrix.isZeroRow(i));
+  }
+}
+
+TEST(DurationMatrixTest, FromRows) {
+  const auto matrix = OrtoolsLib::DurationMatrix::fromRows({
+      {0, 1, 2},
+      {3, 0, 4},
+      {5, 6, 0},
+  });
+
+  EXPECT_EQ(matrix.size(), 3);
+  EXPECT_EQ(matrix(0, 2), 2);
+  EXPECT_EQ(matrix(1, 0), 3);
+  EXPECT_EQ(matrix[2][1], 6);
+
+  EXPECT_THROW(OrtoolsLib::DurationMatrix::fromRows({{0, 1}, {1}}),
+               std::invalid_argument);
+}
+
+TEST(DurationMatrixTest, CopyAndMove) {
+  auto matrix = OrtoolsLib::DurationMatrix::fromRows({{0, 1}, {2, 0}});
+
+  OrtoolsLib::DurationMatrix copied(matrix);
+  EXPECT_EQ(copied, matrix);
+  EXPECT_NE(copied.data(), matrix.data());
+
+  OrtoolsLib::DurationMatrix moved(std::move(matrix));
+  EXPECT_EQ(moved, copied);
+  EXPECT_TRUE(matrix.empty());
+}
+
+
+TEST(DurationMatrixTest, AppendNode) {
+  auto matrix = OrtoolsLib::DurationMatrix::fromRows({
+      {0, 1},
+      {2, 0},
+  });
+  matrix.reserve(3);
+  const int64_t *base = matrix.data();
+
+  const std::vector<int64_t> to{5, 6};
+  const std::vector<int64_t> from{7, 8};
+  matrix.appendNode(to, from);
+
+  // reserved, so the rows did not move
+  EXPECT_EQ(matrix.data(), base);
+  EXPECT_EQ(matrix, OrtoolsLib::DurationMatrix::fromRows({
+                        {0, 1, 7},
+                        {2, 0, 8},
+                        {5, 6, 0},
+                    }));
+
+  for (int64_t i = 0; i < 20; ++i) {
+    const std::vector<int64_t> row(matrix.size(), i);
+    matrix.appendNode(row, row);
+  }
+  EXPECT_EQ(matrix.size(), 23);
+  EXPECT_EQ(matrix(0, 2), 7);
+  EXPECT_EQ(matrix(22, 0), 19);
+  EXPECT_EQ(matrix(0, 22), 19);
+  EXPECT_EQ(matrix(22, 22), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(matrix[22]) %
+                OrtoolsLib::DurationMatrix::kAlignment,
+            0);
+}
+
+TEST(DurationMatrixTest, ViewReadsInPlace) {
+  const std::vector<int64_t> values{0, 1, 2, 3, 0, 5, 6, 7, 0};
+  const auto view = OrtoolsLib::DurationMatrix::view(values, 3);
+  EXPECT_TRUE(view.isView());
+  EXPECT_EQ(view.data(), values.data());
+  EXPECT_EQ(view(1, 2), 5);
+  EXPECT_EQ(view, OrtoolsLib::DurationMatrix::fromRows({
+                      {0, 1, 2},
+                      {3, 0, 5},
+                      {6, 7, 0},
+                  }));
+
+  // copies share the values too
+  const OrtoolsLib::DurationMatrix copied(view);
+  EXPECT_EQ(copied.data(), values.data());
+
+  EXPECT_THROW(OrtoolsLib::DurationMatrix::view(values, 2),
+               std::invalid_argument);
+}
+
+TEST(DurationMatrixTest, WritingViewCopiesIt) {
+  const std::vector<int64_t> values{0, 1, 2, 0};
+  auto matrix = OrtoolsLib::DurationMatrix::view(values, 2);
+  matrix[0][1] = 9;
+  EXPECT_FALSE(matrix.isView());
+  EXPECT_EQ(matrix(0, 1), 9);
+  EXPECT_EQ(values[1], 1);
+
+  auto grown = OrtoolsLib::DurationMatrix::view(values, 2);
+  const std::vector<int64_t> row{3, 4};
+  grown.appendNode(row, row);
+  EXPECT_FALSE(grown.isView());
+  EXPECT_EQ(grown, OrtoolsLib::DurationMatrix::fromRows({
+                       {0, 1, 3},
+                       {2, 0, 4},
+                       {3, 4, 0},
+                   }));
+}
+
+TEST(DurationMatrixTest, IsBoundedBy) {
+  auto matrix = OrtoolsLib::DurationMatrix::fromRows({{0, 5}, {-7, 0}});
+  EXPECT_TRUE(matrix.isBoundedBy(7));
+  EXPECT_FALSE(matrix.isBoundedBy(6));
+  matrix[0][1] = 8;
+  EXPECT_FALSE(matrix.isBoundedBy(7));
+}
@@ -0,0 +1,74 @@
+#include "earlyStop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+namespace OrtoolsLib {
+namespace {
+// `ms` after `from`, saturating instead of overflowing the clock
+EarlyStop::Clock::time_point after(EarlyStop::Clock::time_point from,
+                                   int64_t ms) {
+  const auto left = EarlyStop::Clock::time_point::max() - from;
+  const auto duration = std::chrono::milliseconds(ms);
+  if (duration >= std::chrono::duration_cast<std::chrono::milliseconds>(left)) {
+    return EarlyStop::Clock::time_point::max();
+  }
+  return from + duration;
+}
+} // namespace
+
+EarlyStop::EarlyStop(const SearchOptions &options)
+    : _stagnation_ms(options.stagnation_ms),
+      _window_ms(options.improvement_window_ms),
+      _min_improvement(options.min_relative_improvement.value_or(0)),
+      _target_objective(options.target_objective) {}
+
+bool EarlyStop::enabled() const noexcept {
+  return _stagnation_ms.has_value() || _window_ms.has_value() ||
+         _target_objective.has_value();
+}
+
+void EarlyStop::observe(int64_t objective, Clock::time_point now) {
+  if (!enabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (objective >= _best) {
+    // the stagnation clock keeps running
+    return;
+  }
+  _best = objective;
+
+  Clock::time_point stop_at = Clock::time_point::max();
+  if (_target_objective.has_value() && objective <= _target_objective.value()) {
+    stop_at = now;
+  }
+  if (_stagnation_ms.has_value()) {
+    stop_at = std::min(stop_at, after(now, _stagnation_ms.value()));
+  }
+  if (_window_ms.has_value()) {
+    // A window ending at t compares against the best objective at t - window.
+    // Improvements the current objective beats by at least the fraction never
+    // end a window again, as the objective only gets better; the oldest one
+    // left is where the earliest window that falls short starts.
+    _improvements.emplace_back(now, objective);
+    while (true) {
+      const int64_t before = _improvements.front().second;
+      if (static_cast<double>(before - objective) <=
+          _min_improvement * std::abs(static_cast<double>(before))) {
+        break;
+      }
+      _improvements.pop_front();
+    }
+    stop_at = std::min(stop_at,
+                       after(_improvements.front().first, _window_ms.value()));
+  }
+
+  _stop_at.store(stop_at.time_since_epoch().count(),
+                 std::memory_order_release);
+}
+} // namespace OrtoolsLib
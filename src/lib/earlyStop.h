@@ -0,0 +1,56 @@
+#ifndef EARLY_STOP_H
+#define EARLY_STOP_H
+
+#include "routing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace OrtoolsLib {
+// Stopping criteria beyond wall time, from the stagnation_ms,
+// improvement_window_ms/min_relative_improvement and target_objective search
+// options. Shared by every worker of a portfolio, so the criteria apply to the
+// best objective any of them found. observe() takes a lock, reached() is one
+// atomic load since searches poll it constantly.
+class EarlyStop {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit EarlyStop(const SearchOptions &options);
+  EarlyStop(const EarlyStop &) = delete;
+  EarlyStop &operator=(const EarlyStop &) = delete;
+
+  // whether any criterion is set; reached() never fires otherwise
+  bool enabled() const noexcept;
+
+  // a solution of `objective` found at `now`
+  void observe(int64_t objective, Clock::time_point now = Clock::now());
+  // every criterion counts from the first solution, so this is false until
+  // one was observed
+  bool reached(Clock::time_point now = Clock::now()) const noexcept {
+    return now.time_since_epoch().count() >=
+           _stop_at.load(std::memory_order_acquire);
+  }
+
+private:
+  const std::optional<int64_t> _stagnation_ms;
+  const std::optional<int64_t> _window_ms;
+  const double _min_improvement;
+  const std::optional<int64_t> _target_objective;
+
+  std::mutex _mutex;
+  int64_t _best = std::numeric_limits<int64_t>::max();
+  // (time, objective) of the improvements the window criterion may still
+  // compare against, oldest first
+  std::deque<std::pair<Clock::time_point, int64_t>> _improvements;
+  std::atomic<Clock::rep> _stop_at{std::numeric_limits<Clock::rep>::max()};
+};
+} // namespace OrtoolsLib
+
+#endif // EARLY_STOP_H
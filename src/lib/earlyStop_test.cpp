@@ -0,0 +1,67 @@
+#include "earlyStop.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using std::chrono::milliseconds;
+
+namespace {
+const OrtoolsLib::EarlyStop::Clock::time_point g_start =
+    OrtoolsLib::EarlyStop::Clock::now();
+} // namespace
+
+TEST(EarlyStopTest, NeverStopsWithoutCriterion) {
+  OrtoolsLib::EarlyStop early_stop(OrtoolsLib::SearchOptions{});
+  early_stop.observe(10, g_start);
+
+  EXPECT_FALSE(early_stop.enabled());
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(100000)));
+}
+
+TEST(EarlyStopTest, StopsAfterStagnation) {
+  OrtoolsLib::EarlyStop early_stop(
+      OrtoolsLib::SearchOptions{.stagnation_ms = 100});
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(1000)));
+
+  early_stop.observe(100, g_start);
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(99)));
+  EXPECT_TRUE(early_stop.reached(g_start + milliseconds(100)));
+
+  // only an improvement restarts the clock
+  early_stop.observe(100, g_start + milliseconds(60));
+  EXPECT_TRUE(early_stop.reached(g_start + milliseconds(100)));
+  early_stop.observe(90, g_start + milliseconds(60));
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(100)));
+  EXPECT_TRUE(early_stop.reached(g_start + milliseconds(160)));
+}
+
+TEST(EarlyStopTest, StopsWhenWindowImprovesTooLittle) {
+  OrtoolsLib::EarlyStop early_stop(OrtoolsLib::SearchOptions{
+      .improvement_window_ms = 100,
+      .min_relative_improvement = 0.1,
+  });
+
+  early_stop.observe(1000, g_start);
+  early_stop.observe(800, g_start + milliseconds(50));
+  early_stop.observe(790, g_start + milliseconds(120));
+  // the window ending at 130 ms starts from 1000, 21% better since
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(130)));
+  // the one ending at 150 ms starts from 800, barely 1% better since
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(149)));
+  EXPECT_TRUE(early_stop.reached(g_start + milliseconds(150)));
+
+  early_stop.observe(600, g_start + milliseconds(140));
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(150)));
+  EXPECT_TRUE(early_stop.reached(g_start + milliseconds(240)));
+}
+
+TEST(EarlyStopTest, StopsAtTargetObjective) {
+  OrtoolsLib::EarlyStop early_stop(
+      OrtoolsLib::SearchOptions{.target_objective = 500});
+
+  early_stop.observe(600, g_start);
+  EXPECT_FALSE(early_stop.reached(g_start + milliseconds(100000)));
+  early_stop.observe(500, g_start + milliseconds(10));
+  EXPECT_TRUE(early_stop.reached(g_start + milliseconds(10)));
+}
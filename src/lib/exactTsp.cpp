@@ -0,0 +1,193 @@
+#include "exactTsp.h"
+#include "nodeMap.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+// unreached states; adding an arc to it cannot overflow
+constexpr int64_t kUnreached = std::numeric_limits<int64_t>::max() / 2;
+} // namespace
+
+ExactPath cheapestPath(const DurationMatrix &cost) {
+  const size_t last = cost.size() - 1;
+  const size_t k = cost.size() - 2;
+  if (k == 0) {
+    return ExactPath{.order = {}, .cost = cost(0, last)};
+  }
+
+  // incoming[to * k + from] is the arc between inner nodes from and to, so the
+  // minimum below runs over two contiguous rows
+  std::vector<int64_t> incoming(k * k);
+  for (size_t to = 0; to < k; ++to) {
+    for (size_t from = 0; from < k; ++from) {
+      incoming[to * k + from] = cost(from + 1, to + 1);
+    }
+  }
+
+  // best[subset * k + node]: cheapest path from node 0 through exactly the
+  // inner nodes of `subset`, ending at `node`; kUnreached unless node is in it
+  const size_t subsets = size_t{1} << k;
+  std::vector<int64_t> best(subsets * k, kUnreached);
+  for (size_t node = 0; node < k; ++node) {
+    best[(size_t{1} << node) * k + node] = cost(0, node + 1);
+  }
+
+  // a subset is only ever extended from smaller ones
+  for (size_t subset = 1; subset < subsets; ++subset) {
+    if ((subset & (subset - 1)) == 0) {
+      continue;
+    }
+    for (size_t node = 0; node < k; ++node) {
+      if (!(subset & (size_t{1} << node))) {
+        continue;
+      }
+
+      // branchless over every predecessor so the loop vectorizes; the ones
+      // outside the subset read kUnreached
+      const int64_t *before = &best[(subset ^ (size_t{1} << node)) * k];
+      const int64_t *arcs = &incoming[node * k];
+      int64_t cheapest = kUnreached;
+      for (size_t from = 0; from < k; ++from) {
+        cheapest = std::min(cheapest, before[from] + arcs[from]);
+      }
+      best[subset * k + node] = cheapest;
+    }
+  }
+
+  const size_t all = subsets - 1;
+  ExactPath path{.order = {}, .cost = kUnreached};
+  size_t node = 0;
+  for (size_t candidate = 0; candidate < k; ++candidate) {
+    const int64_t total = best[all * k + candidate] + cost(candidate + 1, last);
+    if (total < path.cost) {
+      path.cost = total;
+      node = candidate;
+    }
+  }
+
+  // walk back along predecessors whose cost adds up
+  path.order.reserve(k);
+  for (size_t subset = all;;) {
+    path.order.push_back(static_cast<int32_t>(node + 1));
+    const size_t before = subset ^ (size_t{1} << node);
+    if (before == 0) {
+      break;
+    }
+    for (size_t from = 0; from < k; ++from) {
+      if ((before & (size_t{1} << from)) &&
+          best[before * k + from] + incoming[node * k + from] ==
+              best[subset * k + node]) {
+        node = from;
+        break;
+      }
+    }
+    subset = before;
+  }
+  std::reverse(path.order.begin(), path.order.end());
+
+  return path;
+}
+
+bool ExactTsp::qualifies(const Routing &routing) {
+  if (routing._num_vehicles != 1 || routing._with_capacity.has_value() ||
+      routing._with_pickup_delivery.has_value() ||
+      routing._with_time_window.has_value() ||
+      routing._with_drop_penalties.has_value() ||
+      routing._with_vehicle_break_time.has_value() ||
+      routing._with_portfolio.has_value() ||
+      routing._with_locked_routes.has_value() ||
+      routing._with_unavailable_vehicles.has_value()) {
+    return false;
+  }
+
+  return ExactTsp(routing)._visits.size() <= kMaxVisits;
+}
+
+ExactTsp::ExactTsp(const Routing &routing) : _routing(routing) {
+  const auto &depot_config = _routing._depot_config;
+  if (const auto *depot = std::get_if<SingleDepot>(&depot_config); depot) {
+    _start = depot->depot;
+    _end = depot->depot;
+  } else {
+    const auto &start_end = std::get<startEndPair>(depot_config);
+    _start = start_end.starts.at(0);
+    _end = start_end.ends.at(0);
+  }
+
+  std::unordered_set<int32_t> cancelled;
+  if (_routing._with_cancelled_orders.has_value()) {
+    const auto &nodes = _routing._with_cancelled_orders.value().nodes;
+    cancelled.insert(nodes.begin(), nodes.end());
+  }
+
+  const auto node_count =
+      static_cast<int32_t>(_routing._duration_matrix.size());
+  for (int32_t node = 0; node < node_count; ++node) {
+    if (node != _start && node != _end && !cancelled.count(node)) {
+      _visits.push_back(node);
+    }
+  }
+}
+
+RoutingSolution ExactTsp::solve(const SolveContext &context) const {
+  // the start, every visit, then the end
+  std::vector<int32_t> nodes;
+  nodes.reserve(_visits.size() + 2);
+  nodes.push_back(_start);
+  nodes.insert(nodes.end(), _visits.begin(), _visits.end());
+  nodes.push_back(_end);
+
+  DurationMatrix cost(nodes.size());
+  for (size_t from = 0; from < nodes.size(); ++from) {
+    for (size_t to = 0; to < nodes.size(); ++to) {
+      cost[from][to] = _transit(nodes[from], nodes[to]);
+    }
+  }
+
+  RoutingSolution solution{.responses = std::vector<RoutingResponse>(1),
+                           .objective = 0};
+  // an idle vehicle costs nothing and has an empty route
+  if (!_visits.empty()) {
+    const ExactPath path = cheapestPath(cost);
+    std::vector<int> &route = solution.responses[0].route;
+    if (_start != NodeMap::kVirtual) {
+      route.push_back(_start);
+    }
+    for (const int32_t index : path.order) {
+      route.push_back(nodes[index]);
+    }
+    if (_end != NodeMap::kVirtual) {
+      route.push_back(_end);
+    }
+    solution.responses[0].total_duration = path.cost;
+    solution.objective = path.cost;
+  }
+
+  if (context.solutions) {
+    context.solutions->offer(solution.objective,
+                             [&solution]() { return solution.responses; });
+  }
+  return solution;
+}
+
+int64_t ExactTsp::_transit(int32_t from, int32_t to) const {
+  // same arcs as the transit matrix of RoutingInstance
+  if (from == NodeMap::kVirtual) {
+    return 0;
+  }
+
+  int64_t transit =
+      to == NodeMap::kVirtual ? 0 : _routing._duration_matrix(from, to);
+  if (_routing._with_service_time.has_value()) {
+    transit += _routing._with_service_time.value().service_time[from];
+  }
+  return transit;
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,53 @@
+#ifndef EXACT_TSP_H
+#define EXACT_TSP_H
+
+#include "durationMatrix.h"
+#include "routing.h"
+#include "routingInstance.h"
+#include "solveContext.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace OrtoolsLib {
+struct ExactPath {
+  // the nodes between the first and the last one, in visiting order
+  std::vector<int32_t> order;
+  int64_t cost;
+};
+
+// Cheapest path from node 0 to node size() - 1 of `cost` through every other
+// node, by the Held-Karp dynamic program: O(2^k * k^2) time and O(2^k * k)
+// memory for k inner nodes. Arc costs must be non-negative and far below
+// INT64_MAX, and at least two nodes given.
+ExactPath cheapestPath(const DurationMatrix &cost);
+
+// Solves a single vehicle tour exactly instead of searching it, in
+// microseconds to a few milliseconds where the local search would spend its
+// whole time limit. Only plain tours qualify: one vehicle, at most kMaxVisits
+// nodes to visit, service times and cancelled orders but no other constraint
+// and no portfolio. Routes and durations read exactly like RoutingInstance's.
+class ExactTsp {
+public:
+  static constexpr int32_t kMaxVisits = 15;
+
+  static bool qualifies(const Routing &routing);
+
+  // `routing` must qualify
+  explicit ExactTsp(const Routing &routing);
+
+  // offers the optimum to `context.solutions`; always finds one
+  RoutingSolution solve(const SolveContext &context) const;
+
+private:
+  const Routing &_routing;
+  // physical node, or NodeMap::kVirtual for a dummy start or end
+  int32_t _start;
+  int32_t _end;
+  std::vector<int32_t> _visits;
+
+  int64_t _transit(int32_t from, int32_t to) const;
+};
+} // namespace OrtoolsLib
+
+#endif // EXACT_TSP_H
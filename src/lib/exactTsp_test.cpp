@@ -0,0 +1,152 @@
+#include "exactTsp.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+const std::vector<std::vector<int64_t>> g_matrix = {
+    {0, 10, 15, 20, 25},
+    {10, 0, 35, 25, 30},
+    {15, 35, 0, 30, 10},
+    {20, 25, 30, 0, 15},
+    {25, 30, 10, 15, 0},
+};
+
+// tries every order of the inner nodes
+int64_t bruteForce(const OrtoolsLib::DurationMatrix &cost) {
+  std::vector<size_t> order(cost.size() - 2);
+  std::iota(order.begin(), order.end(), 1);
+  int64_t cheapest = INT64_MAX;
+  do {
+    int64_t total = 0;
+    size_t from = 0;
+    for (const size_t to : order) {
+      total += cost(from, to);
+      from = to;
+    }
+    cheapest = std::min(cheapest, total + cost(from, cost.size() - 1));
+  } while (std::next_permutation(order.begin(), order.end()));
+
+  return cheapest;
+}
+
+int64_t pathCost(const OrtoolsLib::DurationMatrix &cost,
+                 const std::vector<int32_t> &order) {
+  int64_t total = 0;
+  size_t from = 0;
+  for (const int32_t to : order) {
+    total += cost(from, to);
+    from = to;
+  }
+  return total + cost(from, cost.size() - 1);
+}
+} // namespace
+
+TEST(ExactTspTest, CheapestPathMatchesBruteForce) {
+  std::mt19937_64 random(7);
+  std::uniform_int_distribution<int64_t> duration(0, 1000);
+  for (size_t size = 2; size <= 9; ++size) {
+    OrtoolsLib::DurationMatrix cost(size);
+    for (size_t from = 0; from < size; ++from) {
+      for (size_t to = 0; to < size; ++to) {
+        cost[from][to] = from == to ? 0 : duration(random);
+      }
+    }
+
+    const OrtoolsLib::ExactPath path = OrtoolsLib::cheapestPath(cost);
+    EXPECT_EQ(path.cost, bruteForce(cost)) << "size " << size;
+    EXPECT_EQ(path.order.size(), size - 2);
+    EXPECT_EQ(pathCost(cost, path.order), path.cost);
+  }
+}
+
+TEST(ExactTspTest, SolvesRoundTripFromDepot) {
+  const auto routing = OrtoolsLib::Routing::builder()
+                           .setDurationMatrix(g_matrix)
+                           .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                           .build();
+  ASSERT_TRUE(OrtoolsLib::ExactTsp::qualifies(routing));
+
+  const auto solution =
+      OrtoolsLib::ExactTsp(routing).solve(OrtoolsLib::SolveContext{});
+  ASSERT_EQ(solution.responses.size(), 1);
+  const auto &route = solution.responses[0].route;
+  EXPECT_EQ(route.front(), 0);
+  EXPECT_EQ(route.back(), 0);
+  EXPECT_EQ(route.size(), 6);
+  EXPECT_EQ(solution.responses[0].total_duration, 75);
+  EXPECT_EQ(solution.objective, 75);
+}
+
+TEST(ExactTspTest, StripsDummyEndAndAddsServiceTime) {
+  const auto routing =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_matrix)
+          .setDepotConfig(
+              OrtoolsLib::startEndPair{.starts = {0}, .ends = {-1}})
+          .withServiceTime(OrtoolsLib::RoutingOptionWithServiceTime{
+              .service_time = {1, 2, 2, 2, 2}})
+          .withCancelledOrders(
+              OrtoolsLib::RoutingOptionWithCancelledOrders{.nodes = {1}})
+          .build();
+  ASSERT_TRUE(OrtoolsLib::ExactTsp::qualifies(routing));
+
+  const auto solution =
+      OrtoolsLib::ExactTsp(routing).solve(OrtoolsLib::SolveContext{});
+  // 0 -> 2 -> 4 -> 3, leaving the end is free of travel but not of service
+  EXPECT_EQ(solution.responses[0].route, (std::vector<int>{0, 2, 4, 3}));
+  EXPECT_EQ(solution.responses[0].total_duration,
+            (15 + 1) + (10 + 2) + (15 + 2) + 2);
+}
+
+TEST(ExactTspTest, IdleVehicleHasEmptyRoute) {
+  const auto routing =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(
+              std::vector<std::vector<int64_t>>{{0, 5}, {5, 0}})
+          .setDepotConfig(
+              OrtoolsLib::startEndPair{.starts = {0}, .ends = {1}})
+          .build();
+
+  const auto solution =
+      OrtoolsLib::ExactTsp(routing).solve(OrtoolsLib::SolveContext{});
+  EXPECT_TRUE(solution.responses[0].route.empty());
+  EXPECT_EQ(solution.responses[0].total_duration, 0);
+}
+
+TEST(ExactTspTest, LeavesLargerOrConstrainedInstancesToTheSearch) {
+  const std::vector<std::vector<int64_t>> large(
+      OrtoolsLib::ExactTsp::kMaxVisits + 2,
+      std::vector<int64_t>(OrtoolsLib::ExactTsp::kMaxVisits + 2, 1));
+  EXPECT_FALSE(OrtoolsLib::ExactTsp::qualifies(
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(large)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .build()));
+  EXPECT_TRUE(OrtoolsLib::ExactTsp::qualifies(
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(large)
+          .setDepotConfig(
+              OrtoolsLib::startEndPair{.starts = {0}, .ends = {1}})
+          .build()));
+
+  EXPECT_FALSE(OrtoolsLib::ExactTsp::qualifies(
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .setNumVehicles(2)
+          .build()));
+  EXPECT_FALSE(OrtoolsLib::ExactTsp::qualifies(
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .withTimeWindow(OrtoolsLib::RoutingOptionWithTimeWindow{
+              .time_windows = {{{0, 100}}, {{0, 100}}, {{0, 100}}, {{0, 100}},
+                               {{0, 100}}}})
+          .build()));
+}
@@ -0,0 +1,20 @@
+#include "fingerprint.h"
+
+#include <cstdint>
+#include <random>
+
+namespace OrtoolsLib {
+namespace {
+uint64_t randomWord(std::random_device &random) {
+  return (static_cast<uint64_t>(random()) << 32) | random();
+}
+} // namespace
+
+const FingerprintKey &FingerprintKey::process() {
+  static const FingerprintKey key = []() {
+    std::random_device random;
+    return FingerprintKey{.k0 = randomWord(random), .k1 = randomWord(random)};
+  }();
+  return key;
+}
+} // namespace OrtoolsLib
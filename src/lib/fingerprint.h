@@ -0,0 +1,132 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace OrtoolsLib {
+struct Fingerprint {
+  uint64_t high = 0;
+  uint64_t low = 0;
+
+  bool operator==(const Fingerprint &b) const {
+    return high == b.high && low == b.low;
+  }
+};
+
+struct FingerprintHash {
+  size_t operator()(const Fingerprint &fingerprint) const noexcept {
+    // both halves are already well mixed
+    return static_cast<size_t>(fingerprint.low ^ fingerprint.high);
+  }
+};
+
+// SipHash key of a FingerprintBuilder
+struct FingerprintKey {
+  uint64_t k0 = 0;
+  uint64_t k1 = 0;
+
+  // drawn from std::random_device once per process, so clients cannot craft
+  // two configurations that collide
+  static const FingerprintKey &process();
+};
+
+// Streaming SipHash-2-4 with a 128-bit output over 64-bit words, keyed so
+// that fingerprints can safely stand in for whole configurations. Sequences
+// are written with their length first, so two different inputs never produce
+// the same word stream.
+class FingerprintBuilder {
+public:
+  FingerprintBuilder() : FingerprintBuilder(FingerprintKey::process()) {}
+  explicit FingerprintBuilder(const FingerprintKey &key)
+      : _v0(key.k0 ^ 0x736f6d6570736575ULL),
+        _v1(key.k1 ^ 0x646f72616e646f6dULL ^ 0xee),
+        _v2(key.k0 ^ 0x6c7967656e657261ULL),
+        _v3(key.k1 ^ 0x7465646279746573ULL) {}
+
+  FingerprintBuilder &add(uint64_t word) {
+    _compress(word);
+    ++_words;
+    return *this;
+  }
+  FingerprintBuilder &add(int64_t value) {
+    return add(static_cast<uint64_t>(value));
+  }
+  FingerprintBuilder &add(int32_t value) {
+    return add(static_cast<uint64_t>(static_cast<int64_t>(value)));
+  }
+  FingerprintBuilder &add(bool value) {
+    return add(static_cast<uint64_t>(value));
+  }
+  FingerprintBuilder &add(double value) {
+    return add(std::bit_cast<uint64_t>(value));
+  }
+
+  template <class T> FingerprintBuilder &add(const std::optional<T> &value) {
+    add(value.has_value());
+    if (value.has_value()) {
+      add(value.value());
+    }
+    return *this;
+  }
+
+  template <class T> FingerprintBuilder &add(const std::vector<T> &values) {
+    add(static_cast<uint64_t>(values.size()));
+    for (const auto &value : values) {
+      add(value);
+    }
+    return *this;
+  }
+
+  Fingerprint finish() const {
+    FingerprintBuilder last = *this;
+    // the input is whole words, so the final block is only its byte length
+    last._compress((_words * sizeof(uint64_t)) << 56);
+
+    last._v2 ^= 0xee;
+    last._rounds(4);
+    const uint64_t high = last._v0 ^ last._v1 ^ last._v2 ^ last._v3;
+    last._v1 ^= 0xdd;
+    last._rounds(4);
+    const uint64_t low = last._v0 ^ last._v1 ^ last._v2 ^ last._v3;
+    return Fingerprint{.high = high, .low = low};
+  }
+
+private:
+  void _compress(uint64_t word) {
+    _v3 ^= word;
+    _rounds(2);
+    _v0 ^= word;
+  }
+
+  void _rounds(int count) {
+    for (int i = 0; i < count; ++i) {
+      _v0 += _v1;
+      _v1 = std::rotl(_v1, 13);
+      _v1 ^= _v0;
+      _v0 = std::rotl(_v0, 32);
+      _v2 += _v3;
+      _v3 = std::rotl(_v3, 16);
+      _v3 ^= _v2;
+      _v0 += _v3;
+      _v3 = std::rotl(_v3, 21);
+      _v3 ^= _v0;
+      _v2 += _v1;
+      _v1 = std::rotl(_v1, 17);
+      _v1 ^= _v2;
+      _v2 = std::rotl(_v2, 32);
+    }
+  }
+
+  uint64_t _v0;
+  uint64_t _v1;
+  uint64_t _v2;
+  uint64_t _v3;
+  uint64_t _words = 0;
+};
+} // namespace OrtoolsLib
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,89 @@
+#include "fingerprint.h"
+#include "routing.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+OrtoolsLib::RoutingBuilder baseBuilder() {
+  return OrtoolsLib::Routing::builder()
+      .setDurationMatrix({
+          {0, 1, 2},
+          {1, 0, 3},
+          {2, 3, 0},
+      })
+      .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+      .withServiceTime(
+          OrtoolsLib::RoutingOptionWithServiceTime{.service_time = {0, 1, 1}});
+}
+} // namespace
+
+TEST(FingerprintTest, MatchesSipHashReference) {
+  // SipHash-2-4-128 of the bytes 00..0f under the key 00..0f
+  OrtoolsLib::FingerprintBuilder builder(OrtoolsLib::FingerprintKey{
+      .k0 = 0x0706050403020100ULL, .k1 = 0x0f0e0d0c0b0a0908ULL});
+  builder.add(uint64_t{0x0706050403020100ULL})
+      .add(uint64_t{0x0f0e0d0c0b0a0908ULL});
+
+  const OrtoolsLib::Fingerprint fingerprint = builder.finish();
+  EXPECT_EQ(fingerprint.high, 0xbb54b067caa4e26eULL);
+  EXPECT_EQ(fingerprint.low, 0x77052385bf1533fdULL);
+}
+
+TEST(FingerprintTest, DependsOnTheKey) {
+  OrtoolsLib::FingerprintBuilder first(OrtoolsLib::FingerprintKey{.k0 = 1});
+  OrtoolsLib::FingerprintBuilder second(OrtoolsLib::FingerprintKey{.k0 = 2});
+  first.add(int64_t{42});
+  second.add(int64_t{42});
+
+  EXPECT_FALSE(first.finish() == second.finish());
+}
+
+TEST(FingerprintTest, StreamsAreLengthPrefixed) {
+  OrtoolsLib::FingerprintBuilder split;
+  split.add(std::vector<int64_t>{1}).add(std::vector<int64_t>{2, 3});
+  OrtoolsLib::FingerprintBuilder merged;
+  merged.add(std::vector<int64_t>{1, 2}).add(std::vector<int64_t>{3});
+
+  EXPECT_FALSE(split.finish() == merged.finish());
+}
+
+TEST(FingerprintTest, EqualConfigurationsHashEqual) {
+  EXPECT_EQ(baseBuilder().build().fingerprint(),
+            baseBuilder().build().fingerprint());
+}
+
+TEST(FingerprintTest, EveryPartOfTheConfigurationCounts) {
+  const OrtoolsLib::Fingerprint base = baseBuilder().build().fingerprint();
+
+  EXPECT_FALSE(base == baseBuilder()
+                           .setDurationMatrix({
+                               {0, 1, 2},
+                               {1, 0, 4},
+                               {2, 3, 0},
+                           })
+                           .build()
+                           .fingerprint());
+  EXPECT_FALSE(base == baseBuilder().setNumVehicles(2).build().fingerprint());
+  EXPECT_FALSE(base == baseBuilder().setTimeLimit(2).build().fingerprint());
+  EXPECT_FALSE(base == baseBuilder()
+                           .withSearchOptions(OrtoolsLib::SearchOptions{
+                               .time_limit_ms = 150,
+                           })
+                           .build()
+                           .fingerprint());
+  EXPECT_FALSE(base == baseBuilder()
+                           .withDropPenalties(
+                               OrtoolsLib::RoutingOptionWithPenalties{
+                                   .penalties = int64_t{10}})
+                           .build()
+                           .fingerprint());
+  EXPECT_TRUE(base == baseBuilder()
+                          .withSearchOptions(OrtoolsLib::SearchOptions{
+                              .log_search = true,
+                          })
+                          .build()
+                          .fingerprint());
+}
@@ -0,0 +1,65 @@
+#ifndef INCUMBENT_H
+#define INCUMBENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+// Best solution found so far by the workers of a cooperative search.
+// objective() is a plain atomic load, so search limits can poll it without
+// ever blocking. Publishing copies the routes before taking the lock, which
+// then only guards swapping the snapshot pointer.
+class Incumbent {
+public:
+  struct Snapshot {
+    int64_t objective;
+    // per-vehicle variable indices, start and end excluded
+    std::vector<std::vector<int64_t>> routes;
+  };
+
+  Incumbent() = default;
+  Incumbent(const Incumbent &) = delete;
+  Incumbent &operator=(const Incumbent &) = delete;
+
+  // std::numeric_limits<int64_t>::max() until something is published
+  int64_t objective() const noexcept {
+    return _objective.load(std::memory_order_acquire);
+  }
+
+  std::shared_ptr<const Snapshot> snapshot() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _snapshot;
+  }
+
+  // replaces the incumbent when `objective` is strictly better, returns
+  // whether it did
+  bool publish(int64_t objective, std::vector<std::vector<int64_t>> routes) {
+    if (objective >= this->objective()) {
+      return false;
+    }
+
+    auto next = std::make_shared<const Snapshot>(
+        Snapshot{.objective = objective, .routes = std::move(routes)});
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_snapshot && _snapshot->objective <= objective) {
+      return false;
+    }
+
+    _snapshot = std::move(next);
+    _objective.store(objective, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::atomic<int64_t> _objective{std::numeric_limits<int64_t>::max()};
+  mutable std::mutex _mutex;
+  std::shared_ptr<const Snapshot> _snapshot;
+};
+} // namespace OrtoolsLib
+
+#endif // INCUMBENT_H
@@ -0,0 +1,47 @@
+#include "incumbent.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+TEST(IncumbentTest, KeepsStrictlyBetterSolutions) {
+  OrtoolsLib::Incumbent incumbent;
+  EXPECT_EQ(incumbent.objective(), std::numeric_limits<int64_t>::max());
+  EXPECT_EQ(incumbent.snapshot(), nullptr);
+
+  EXPECT_TRUE(incumbent.publish(10, {{1, 2}}));
+  EXPECT_FALSE(incumbent.publish(10, {{2, 1}}));
+  EXPECT_FALSE(incumbent.publish(12, {{2, 1}}));
+  EXPECT_TRUE(incumbent.publish(7, {{2}, {1}}));
+
+  const auto snapshot = incumbent.snapshot();
+  ASSERT_NE(snapshot, nullptr);
+  EXPECT_EQ(incumbent.objective(), 7);
+  EXPECT_EQ(snapshot->objective, 7);
+  const std::vector<std::vector<int64_t>> expected_routes{{2}, {1}};
+  EXPECT_EQ(snapshot->routes, expected_routes);
+}
+
+TEST(IncumbentTest, ConcurrentPublishersKeepTheMinimum) {
+  OrtoolsLib::Incumbent incumbent;
+  std::vector<std::thread> publishers;
+  for (int worker = 0; worker < 4; ++worker) {
+    publishers.emplace_back([&incumbent, worker]() {
+      for (int64_t objective = 1000 + worker; objective > worker;
+           objective -= 4) {
+        incumbent.publish(objective, {{objective}});
+      }
+    });
+  }
+  for (auto &publisher : publishers) {
+    publisher.join();
+  }
+
+  const auto snapshot = incumbent.snapshot();
+  ASSERT_NE(snapshot, nullptr);
+  EXPECT_EQ(incumbent.objective(), snapshot->objective);
+  EXPECT_EQ(snapshot->routes.at(0).at(0), snapshot->objective);
+  EXPECT_EQ(snapshot->objective, 4);
+}
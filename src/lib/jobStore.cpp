@@ -0,0 +1,344 @@
+#include "jobStore.h"
+#include "randomId.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <system_error>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+constexpr char kExtension[] = ".job";
+constexpr JobState kStates[] = {
+    JobState::Queued,     JobState::Running,   JobState::Succeeded,
+    JobState::NoSolution, JobState::Cancelled, JobState::Failed,
+};
+
+constexpr SolverEngine kEngines[] = {
+    SolverEngine::EXACT,
+    SolverEngine::GREEDY_DESCENT,
+    SolverEngine::LOCAL_SEARCH,
+    SolverEngine::PORTFOLIO,
+    SolverEngine::COOPERATIVE_PORTFOLIO,
+};
+
+std::optional<JobState> jobStateFromName(const std::string &name) {
+  for (const JobState state : kStates) {
+    if (name == jobStateName(state)) {
+      return state;
+    }
+  }
+  return std::nullopt;
+}
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::optional<SolverEngine> solverEngineFromName(const std::string &name) {
+  for (const SolverEngine engine : kEngines) {
+    if (name == solverEngineName(engine)) {
+      return engine;
+    }
+  }
+  return std::nullopt;
+}
+} // namespace
+
+const char *jobStateName(JobState state) {
+  switch (state) {
+  case JobState::Queued:
+    return "QUEUED";
+  case JobState::Running:
+    return "RUNNING";
+  case JobState::Succeeded:
+    return "SUCCEEDED";
+  case JobState::NoSolution:
+    return "NO_SOLUTION";
+  case JobState::Cancelled:
+    return "CANCELLED";
+  case JobState::Failed:
+    return "FAILED";
+  }
+  return "FAILED";
+}
+
+JobStore::JobStore(Options options) : _options(std::move(options)) {
+  std::filesystem::create_directories(_options.directory);
+  for (const auto &file :
+       std::filesystem::directory_iterator(_options.directory)) {
+    if (file.path().extension() != kExtension) {
+      continue;
+    }
+
+    std::optional<JobRecord> record = _load(file.path());
+    if (!record) {
+      continue;
+    }
+    if (!record->finished()) {
+      record->state = JobState::Failed;
+      record->error = "interrupted by a restart";
+    }
+    // files written before finishing times were recorded have none
+    if (record->finished_at_ms == 0) {
+      record->finished_at_ms = nowMs();
+      _write(*record);
+    }
+
+    const std::string id = record->id;
+    _finished_order.emplace(record->finished_at_ms, id);
+    _jobs.emplace(id, Entry{.record = std::move(*record)});
+  }
+  _forgetExpired();
+}
+
+std::string JobStore::create(SolverEngine engine) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _forgetExpired();
+  std::string id = _newId();
+  Entry entry{
+      .record = JobRecord{.id = id, .engine = engine},
+      .token = std::make_unique<CancellationToken>(),
+  };
+  _persist(entry.record);
+  _jobs.emplace(id, std::move(entry));
+  return id;
+}
+
+void JobStore::discard(const std::string &id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_jobs.erase(id) > 0) {
+    // after the write create() queued
+    _writer.submit([path = _path(id)] {
+      std::error_code ignored;
+      std::filesystem::remove(path, ignored);
+    });
+  }
+}
+
+std::optional<JobRecord> JobStore::find(const std::string &id) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto found = _jobs.find(id);
+  if (found == _jobs.end()) {
+    return std::nullopt;
+  }
+
+  JobRecord record = found->second.record;
+  if (record.state == JobState::Running) {
+    record.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() -
+                            found->second.started)
+                            .count();
+  }
+  return record;
+}
+
+const CancellationToken *JobStore::start(const std::string &id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto found = _jobs.find(id);
+  if (found == _jobs.end() || found->second.record.finished()) {
+    return nullptr;
+  }
+
+  found->second.record.state = JobState::Running;
+  found->second.started = std::chrono::steady_clock::now();
+  return found->second.token.get();
+}
+
+void JobStore::improve(const std::string &id, int64_t objective) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (const auto found = _jobs.find(id); found != _jobs.end()) {
+    found->second.record.best_objective = objective;
+  }
+}
+
+void JobStore::finish(const std::string &id, JobState state,
+                      std::vector<RoutingResponse> responses,
+                      std::string error) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto found = _jobs.find(id);
+  if (found == _jobs.end()) {
+    return;
+  }
+
+  JobRecord &record = found->second.record;
+  record.state = state;
+  record.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() -
+                          found->second.started)
+                          .count();
+  record.responses = std::move(responses);
+  record.error = std::move(error);
+  _markFinished(record);
+  _persist(record);
+  _forgetExpired();
+}
+
+bool JobStore::cancel(const std::string &id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto found = _jobs.find(id);
+  if (found == _jobs.end() || found->second.record.finished()) {
+    return false;
+  }
+
+  // a running job finishes itself once the solve notices the token
+  found->second.token->cancel();
+  if (found->second.record.state == JobState::Queued) {
+    found->second.record.state = JobState::Cancelled;
+    _markFinished(found->second.record);
+    _persist(found->second.record);
+    _forgetExpired();
+  }
+  return true;
+}
+
+std::filesystem::path JobStore::_path(const std::string &id) const {
+  return _options.directory / (id + kExtension);
+}
+
+void JobStore::_markFinished(JobRecord &record) {
+  record.finished_at_ms = nowMs();
+  _finished_order.emplace(record.finished_at_ms, record.id);
+}
+
+void JobStore::_forgetExpired() {
+  const int64_t now = nowMs();
+  while (!_finished_order.empty()) {
+    const auto oldest = _finished_order.begin();
+    const bool expired = _options.finished_ttl_ms > 0 &&
+                         now - oldest->first >= _options.finished_ttl_ms;
+    if (!expired && _finished_order.size() <= _options.max_finished) {
+      break;
+    }
+
+    _jobs.erase(oldest->second);
+    // after any write of the job still queued
+    _writer.submit([path = _path(oldest->second)] {
+      std::error_code ignored;
+      std::filesystem::remove(path, ignored);
+    });
+    _finished_order.erase(oldest);
+  }
+}
+
+void JobStore::_persist(const JobRecord &record) {
+  _writer.submit([this, record] { _write(record); });
+}
+
+void JobStore::_write(const JobRecord &record) const {
+  const std::filesystem::path path = _path(record.id);
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  bool written = false;
+  {
+    std::ofstream out(temporary, std::ios::trunc);
+    out << "state " << jobStateName(record.state) << '\n';
+    out << "engine " << solverEngineName(record.engine) << '\n';
+    if (record.best_objective.has_value()) {
+      out << "objective " << record.best_objective.value() << '\n';
+    }
+    out << "elapsed_ms " << record.elapsed_ms << '\n';
+    if (record.finished_at_ms != 0) {
+      out << "finished_at_ms " << record.finished_at_ms << '\n';
+    }
+    if (!record.error.empty()) {
+      std::string error = record.error;
+      std::replace(error.begin(), error.end(), '\n', ' ');
+      out << "error " << error << '\n';
+    }
+    for (const auto &response : record.responses) {
+      out << "route " << response.total_duration;
+      for (const auto node : response.route) {
+        out << ' ' << node;
+      }
+      out << '\n';
+    }
+    out.close();
+    written = !out.fail();
+  }
+
+  std::error_code error;
+  if (written) {
+    std::filesystem::rename(temporary, path, error);
+  }
+  if (!written || error) {
+    std::cerr << "job " << record.id << ": cannot write " << path << ": "
+              << (written ? error.message() : "write failed") << std::endl;
+    std::filesystem::remove(temporary, error);
+  }
+}
+
+std::optional<JobRecord>
+JobStore::_load(const std::filesystem::path &path) {
+  std::ifstream in(path);
+  if (!in) {
+    return std::nullopt;
+  }
+
+  JobRecord record{.id = path.stem().string()};
+  bool has_state = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+    if (key == "state") {
+      std::string name;
+      fields >> name;
+      const std::optional<JobState> state = jobStateFromName(name);
+      if (!state) {
+        return std::nullopt;
+      }
+      record.state = state.value();
+      has_state = true;
+    } else if (key == "engine") {
+      std::string name;
+      fields >> name;
+      // files written before engines were recorded have none
+      record.engine =
+          solverEngineFromName(name).value_or(SolverEngine::LOCAL_SEARCH);
+    } else if (key == "objective") {
+      int64_t objective = 0;
+      fields >> objective;
+      record.best_objective = objective;
+    } else if (key == "elapsed_ms") {
+      fields >> record.elapsed_ms;
+    } else if (key == "finished_at_ms") {
+      fields >> record.finished_at_ms;
+    } else if (key == "error") {
+      std::getline(fields >> std::ws, record.error);
+    } else if (key == "route") {
+      RoutingResponse response{};
+      fields >> response.total_duration;
+      for (int node; fields >> node;) {
+        response.route.push_back(node);
+      }
+      record.responses.push_back(std::move(response));
+    }
+  }
+
+  return has_state ? std::optional<JobRecord>(std::move(record))
+                   : std::nullopt;
+}
+
+std::string JobStore::_newId() const {
+  std::string id;
+  do {
+    id = randomId();
+  } while (_jobs.count(id));
+
+  return id;
+}
+} // namespace OrtoolsLib
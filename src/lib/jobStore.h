@@ -0,0 +1,116 @@
+#ifndef JOB_STORE_H
+#define JOB_STORE_H
+
+#include "routing.h"
+#include "solveContext.h"
+#include "threadPool.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OrtoolsLib {
+enum class JobState { Queued, Running, Succeeded, NoSolution, Cancelled, Failed };
+
+// "QUEUED", "RUNNING", "SUCCEEDED", "NO_SOLUTION", "CANCELLED" or "FAILED"
+const char *jobStateName(JobState state);
+
+struct JobRecord {
+  std::string id;
+  JobState state = JobState::Queued;
+  SolverEngine engine = SolverEngine::LOCAL_SEARCH;
+  // best objective found so far, updated while the job runs
+  std::optional<int64_t> best_objective;
+  // time spent solving, so far while the job runs
+  int64_t elapsed_ms = 0;
+  std::string error;
+  // set once finished; the best solution so far when cancelled
+  std::vector<RoutingResponse> responses;
+  // wall-clock time it finished, in milliseconds since the epoch
+  int64_t finished_at_ms = 0;
+
+  bool finished() const {
+    return state != JobState::Queued && state != JobState::Running;
+  }
+};
+
+// Routing jobs solved in the background, by id. Every job is written to its
+// own file in `directory` when submitted and again when it finishes, so
+// results survive a restart. Progress is only kept in memory; a job still
+// queued or running when the process stopped comes back Failed, its request
+// is not kept. Files are written by a thread of the store's own, in the
+// order the jobs changed, so no caller waits for the disk; a file that
+// cannot be written is reported on stderr and the job lives on in memory.
+// Finished jobs are forgotten, file and all, once they are too old or too
+// many.
+class JobStore {
+public:
+  struct Options {
+    std::filesystem::path directory = "jobs";
+    // finished jobs kept, the ones that finished first go first
+    size_t max_finished = 10000;
+    // finished jobs are forgotten this long after finishing, 0 keeps them
+    int64_t finished_ttl_ms = int64_t{7} * 24 * 60 * 60 * 1000;
+  };
+
+  // throws std::filesystem::filesystem_error when `options.directory`
+  // cannot be created or read
+  explicit JobStore(Options options);
+  JobStore(const JobStore &) = delete;
+  JobStore &operator=(const JobStore &) = delete;
+
+  // a new Queued job, solved by `engine`
+  std::string create(SolverEngine engine);
+  // forgets a job that never started, e.g. when the solver turned it away
+  void discard(const std::string &id);
+  std::optional<JobRecord> find(const std::string &id) const;
+
+  // marks the job Running and returns the token cancel() fires, nullptr
+  // when it was cancelled while queued
+  const CancellationToken *start(const std::string &id);
+  void improve(const std::string &id, int64_t objective);
+  void finish(const std::string &id, JobState state,
+              std::vector<RoutingResponse> responses, std::string error = "");
+  // whether the job exists and had not finished yet
+  bool cancel(const std::string &id);
+
+private:
+  struct Entry {
+    JobRecord record;
+    std::unique_ptr<CancellationToken> token;
+    std::chrono::steady_clock::time_point started;
+  };
+
+  std::filesystem::path _path(const std::string &id) const;
+  // Stamps a job that just finished, then forgets the finished jobs beyond
+  // the limits. Both are called with _mutex held.
+  void _markFinished(JobRecord &record);
+  void _forgetExpired();
+  // queues _write of a copy of `record`, called with _mutex held
+  void _persist(const JobRecord &record);
+  // written next to the job file and renamed over it, so a crash leaves
+  // either the old or the new record
+  void _write(const JobRecord &record) const;
+  static std::optional<JobRecord> _load(const std::filesystem::path &path);
+  // a randomId() unique among known jobs
+  std::string _newId() const;
+
+  const Options _options;
+  mutable std::mutex _mutex;
+  std::unordered_map<std::string, Entry> _jobs;
+  // ids of the finished jobs by finished_at_ms
+  std::multimap<int64_t, std::string> _finished_order;
+  // last, so its destructor writes what is still queued while the rest lives
+  ThreadPool _writer{1};
+};
+} // namespace OrtoolsLib
+
+#endif // JOB_STORE_H
@@ -0,0 +1,134 @@
+#include "jobStore.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+class JobStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    const auto *test = ::testing::UnitTest::GetInstance()->current_test_info();
+    _directory = std::filesystem::temp_directory_path() /
+                 (std::string("jobStore_test_") + test->name());
+    std::filesystem::remove_all(_directory);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(_directory); }
+
+  std::filesystem::path _directory;
+};
+} // namespace
+
+TEST_F(JobStoreTest, ResultsSurviveRestart) {
+  std::string id;
+  {
+    OrtoolsLib::JobStore store({.directory = _directory});
+    id = store.create(OrtoolsLib::SolverEngine::EXACT);
+    ASSERT_NE(store.start(id), nullptr);
+    store.improve(id, 42);
+    EXPECT_EQ(store.find(id)->state, OrtoolsLib::JobState::Running);
+    EXPECT_EQ(store.find(id)->best_objective, 42);
+    store.finish(id, OrtoolsLib::JobState::Succeeded,
+                 {{.route = {0, 2, 1, 0}, .total_duration = 40},
+                  {.route = {}, .total_duration = 0}});
+  }
+
+  OrtoolsLib::JobStore reopened({.directory = _directory});
+  const auto record = reopened.find(id);
+  ASSERT_TRUE(record.has_value());
+  EXPECT_EQ(record->state, OrtoolsLib::JobState::Succeeded);
+  EXPECT_EQ(record->engine, OrtoolsLib::SolverEngine::EXACT);
+  EXPECT_EQ(record->best_objective, 42);
+  ASSERT_EQ(record->responses.size(), 2);
+  EXPECT_EQ(record->responses[0].route, (std::vector<int>{0, 2, 1, 0}));
+  EXPECT_EQ(record->responses[0].total_duration, 40);
+  EXPECT_TRUE(record->responses[1].route.empty());
+}
+
+TEST_F(JobStoreTest, UnfinishedJobsFailAfterRestart) {
+  std::string id;
+  {
+    OrtoolsLib::JobStore store({.directory = _directory});
+    id = store.create(OrtoolsLib::SolverEngine::LOCAL_SEARCH);
+    store.start(id);
+  }
+
+  OrtoolsLib::JobStore reopened({.directory = _directory});
+  EXPECT_EQ(reopened.find(id)->state, OrtoolsLib::JobState::Failed);
+  EXPECT_FALSE(reopened.find(id)->error.empty());
+  EXPECT_FALSE(reopened.cancel(id));
+}
+
+TEST_F(JobStoreTest, CancelsQueuedAndRunningJobs) {
+  OrtoolsLib::JobStore store({.directory = _directory});
+
+  const std::string queued =
+      store.create(OrtoolsLib::SolverEngine::LOCAL_SEARCH);
+  EXPECT_TRUE(store.cancel(queued));
+  EXPECT_EQ(store.find(queued)->state, OrtoolsLib::JobState::Cancelled);
+  EXPECT_EQ(store.start(queued), nullptr);
+
+  const std::string running =
+      store.create(OrtoolsLib::SolverEngine::LOCAL_SEARCH);
+  const OrtoolsLib::CancellationToken *token = store.start(running);
+  ASSERT_NE(token, nullptr);
+  EXPECT_TRUE(store.cancel(running));
+  EXPECT_TRUE(token->cancelled());
+
+  EXPECT_FALSE(store.cancel("no such job"));
+  EXPECT_FALSE(store.find("no such job").has_value());
+}
+
+TEST_F(JobStoreTest, KeepsJobsWhoseFilesCannotBeWritten) {
+  OrtoolsLib::JobStore store({.directory = _directory});
+  std::filesystem::remove_all(_directory);
+
+  const std::string id = store.create(OrtoolsLib::SolverEngine::EXACT);
+  ASSERT_NE(store.start(id), nullptr);
+  store.finish(id, OrtoolsLib::JobState::Succeeded,
+               {{.route = {0, 1, 0}, .total_duration = 2}});
+
+  EXPECT_EQ(store.find(id)->state, OrtoolsLib::JobState::Succeeded);
+  EXPECT_EQ(store.find(id)->responses.size(), 1);
+}
+
+TEST_F(JobStoreTest, ForgetsTheOldestFinishedJobs) {
+  std::vector<std::string> ids;
+  {
+    OrtoolsLib::JobStore store({.directory = _directory, .max_finished = 2});
+    for (int i = 0; i < 3; ++i) {
+      ids.push_back(store.create(OrtoolsLib::SolverEngine::EXACT));
+      store.start(ids.back());
+      store.finish(ids.back(), OrtoolsLib::JobState::Succeeded, {});
+    }
+    // unfinished jobs do not count
+    ids.push_back(store.create(OrtoolsLib::SolverEngine::EXACT));
+
+    EXPECT_FALSE(store.find(ids[0]).has_value());
+    EXPECT_TRUE(store.find(ids[1]).has_value());
+    EXPECT_TRUE(store.find(ids[2]).has_value());
+    EXPECT_TRUE(store.find(ids[3]).has_value());
+  }
+
+  EXPECT_FALSE(std::filesystem::exists(_directory / (ids[0] + ".job")));
+  EXPECT_TRUE(std::filesystem::exists(_directory / (ids[1] + ".job")));
+}
+
+TEST_F(JobStoreTest, ForgetsExpiredJobs) {
+  OrtoolsLib::JobStore store(
+      {.directory = _directory, .finished_ttl_ms = 100});
+  const std::string finished = store.create(OrtoolsLib::SolverEngine::EXACT);
+  EXPECT_TRUE(store.cancel(finished));
+  const std::string queued = store.create(OrtoolsLib::SolverEngine::EXACT);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  store.create(OrtoolsLib::SolverEngine::EXACT);
+
+  EXPECT_FALSE(store.find(finished).has_value());
+  EXPECT_TRUE(store.find(queued).has_value());
+}
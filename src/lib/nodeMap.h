@@ -0,0 +1,51 @@
+#ifndef NODE_MAP_H
+#define NODE_MAP_H
+
+#include <cstdint>
+#include <vector>
+
+namespace OrtoolsLib {
+// Maps the logical nodes handed to the RoutingIndexManager onto rows of the
+// duration matrix. The first `physicalCount()` logical nodes are the matrix
+// rows themselves; every node added afterwards is either a duplicate viewing an
+// existing row (a pickup/delivery or depot visited more than once) or a
+// virtual node with zero cost to and from everything (a dummy depot). Adding
+// either costs one int, the matrix is never copied.
+class NodeMap {
+public:
+  static constexpr int32_t kVirtual = -1;
+
+  NodeMap() = default;
+  explicit NodeMap(int32_t physical_count) : _physical_count(physical_count) {}
+
+  int32_t size() const noexcept {
+    return _physical_count + static_cast<int32_t>(_extra.size());
+  }
+  int32_t physicalCount() const noexcept { return _physical_count; }
+
+  int32_t physical(int32_t logical) const noexcept {
+    return logical < _physical_count ? logical
+                                     : _extra[logical - _physical_count];
+  }
+  bool isVirtual(int32_t logical) const noexcept {
+    return physical(logical) == kVirtual;
+  }
+
+  // returns the logical node of the new duplicate
+  int32_t addDuplicate(int32_t logical) {
+    _extra.push_back(physical(logical));
+    return size() - 1;
+  }
+  // returns the logical node of the new virtual node
+  int32_t addVirtual() {
+    _extra.push_back(kVirtual);
+    return size() - 1;
+  }
+
+private:
+  int32_t _physical_count = 0;
+  std::vector<int32_t> _extra;
+};
+} // namespace OrtoolsLib
+
+#endif // NODE_MAP_H
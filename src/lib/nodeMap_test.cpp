@@ -0,0 +1,30 @@
+#include "nodeMap.h"
+
+#include <gtest/gtest.h>
+
+TEST(NodeMapTest, IdentityForPhysicalNodes) {
+  OrtoolsLib::NodeMap nodes(4);
+
+  EXPECT_EQ(nodes.size(), 4);
+  for (int32_t i = 0; i < nodes.size(); ++i) {
+    EXPECT_EQ(nodes.physical(i), i);
+    EXPECT_FALSE(nodes.isVirtual(i));
+  }
+}
+
+TEST(NodeMapTest, DuplicatesAndVirtualNodes) {
+  OrtoolsLib::NodeMap nodes(4);
+
+  const int32_t duplicate = nodes.addDuplicate(2);
+  const int32_t dummy = nodes.addVirtual();
+  const int32_t duplicate_of_duplicate = nodes.addDuplicate(duplicate);
+
+  EXPECT_EQ(duplicate, 4);
+  EXPECT_EQ(dummy, 5);
+  EXPECT_EQ(nodes.size(), 7);
+  EXPECT_EQ(nodes.physicalCount(), 4);
+  EXPECT_EQ(nodes.physical(duplicate), 2);
+  EXPECT_EQ(nodes.physical(duplicate_of_duplicate), 2);
+  EXPECT_TRUE(nodes.isVirtual(dummy));
+  EXPECT_FALSE(nodes.isVirtual(duplicate));
+}
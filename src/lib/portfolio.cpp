@@ -0,0 +1,93 @@
+#include "portfolio.h"
+#include "earlyStop.h"
+#include "searchParameters.h"
+#include "threadPool.h"
+#include "transitMatrix.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+const std::vector<SearchStrategy> &defaultPortfolio() {
+  static const std::vector<SearchStrategy> portfolio{
+      {FirstSolutionStrategy::PATH_CHEAPEST_ARC,
+       LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH},
+      {FirstSolutionStrategy::SAVINGS,
+       LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH},
+      {FirstSolutionStrategy::CHRISTOFIDES,
+       LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH},
+      {FirstSolutionStrategy::PARALLEL_CHEAPEST_INSERTION,
+       LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH},
+      {FirstSolutionStrategy::PATH_CHEAPEST_ARC,
+       LocalSearchMetaheuristic::SIMULATED_ANNEALING},
+      {FirstSolutionStrategy::PATH_CHEAPEST_ARC,
+       LocalSearchMetaheuristic::TABU_SEARCH},
+  };
+
+  return portfolio;
+}
+
+size_t portfolioWorkers(const RoutingOptionWithPortfolio &portfolio,
+                        size_t num_strategies) {
+  const size_t requested = portfolio.num_workers > 0
+                               ? static_cast<size_t>(portfolio.num_workers)
+                               : num_strategies;
+  const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  return std::min(requested, static_cast<size_t>(hardware));
+}
+
+std::optional<RoutingSolution>
+solvePortfolio(const Routing &routing,
+               const RoutingOptionWithPortfolio &portfolio,
+               std::optional<int64_t> time_limit_ms,
+               const SolveContext &context) {
+  const std::vector<SearchStrategy> &strategies =
+      portfolio.strategies.empty() ? defaultPortfolio() : portfolio.strategies;
+  const size_t num_workers = portfolioWorkers(portfolio, strategies.size());
+
+  const Deadline deadline = deadlineAfter(time_limit_ms);
+  // judged on the best objective of all workers
+  EarlyStop early_stop(routing.searchOptions());
+
+  SharedTransitMatrix transit;
+
+  std::vector<std::future<std::optional<RoutingSolution>>> results;
+  results.reserve(strategies.size());
+  {
+    ThreadPool pool(std::min(num_workers, strategies.size()));
+    for (const SearchStrategy &strategy : strategies) {
+      results.push_back(pool.submit(
+          [&routing, strategy, deadline, &context, &early_stop,
+           &transit]() -> std::optional<RoutingSolution> {
+            // strategies queued behind a busy worker only get what is left
+            const std::optional<int64_t> remaining_ms = remainingMs(deadline);
+            if ((remaining_ms.has_value() && remaining_ms.value() <= 0) ||
+                context.cancelled() || early_stop.reached()) {
+              return std::nullopt;
+            }
+
+            RoutingInstance instance(routing, &transit);
+            instance.attach(context);
+            instance.attach(early_stop);
+            return instance.solve(makeSearchParameters(
+                strategy, routing.searchOptions(), remaining_ms));
+          }));
+    }
+  }
+
+  std::optional<RoutingSolution> best;
+  for (auto &result : results) {
+    std::optional<RoutingSolution> solution = result.get();
+    if (solution && (!best || solution->objective < best->objective)) {
+      best = std::move(solution);
+    }
+  }
+
+  return best;
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,35 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "routing.h"
+#include "routingInstance.h"
+#include "solveContext.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace OrtoolsLib {
+// SAVINGS, CHRISTOFIDES and PARALLEL_CHEAPEST_INSERTION under guided local
+// search, plus PATH_CHEAPEST_ARC under each metaheuristic
+const std::vector<SearchStrategy> &defaultPortfolio();
+
+// Threads to run `num_strategies` strategies of `portfolio` on: num_workers,
+// or one per strategy when 0, but never more than the hardware threads.
+size_t portfolioWorkers(const RoutingOptionWithPortfolio &portfolio,
+                        size_t num_strategies);
+
+// Builds one independent model per strategy of `portfolio` and races them on
+// a pool of `num_workers` threads. Every model stops at the same deadline,
+// `time_limit_ms` from now (none when std::nullopt); the solution with the
+// lowest objective wins. Improvements of any worker go to
+// `context.solutions`.
+std::optional<RoutingSolution>
+solvePortfolio(const Routing &routing,
+               const RoutingOptionWithPortfolio &portfolio,
+               std::optional<int64_t> time_limit_ms,
+               const SolveContext &context);
+} // namespace OrtoolsLib
+
+#endif // PORTFOLIO_H
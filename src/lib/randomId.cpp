@@ -0,0 +1,23 @@
+#include "randomId.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace OrtoolsLib {
+std::string randomId() {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  // libc++ reads getrandom() / /dev/urandom on every call, never a PRNG
+  thread_local std::random_device random;
+
+  std::string id;
+  id.reserve(32);
+  for (int word = 0; word < 4; ++word) {
+    uint32_t bits = random();
+    for (int i = 0; i < 8; ++i, bits >>= 4) {
+      id.push_back(kDigits[bits & 0xf]);
+    }
+  }
+  return id;
+}
+} // namespace OrtoolsLib
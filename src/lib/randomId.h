@@ -0,0 +1,13 @@
+#ifndef RANDOM_ID_H
+#define RANDOM_ID_H
+
+#include <string>
+
+namespace OrtoolsLib {
+// 128 bits read from std::random_device, i.e. the operating system's CSPRNG,
+// as 32 hex digits. Every call draws fresh bits, so an id says nothing about
+// the ids handed out before or after it.
+std::string randomId();
+} // namespace OrtoolsLib
+
+#endif // RANDOM_ID_H
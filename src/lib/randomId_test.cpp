@@ -0,0 +1,19 @@
+#include "randomId.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unordered_set>
+
+TEST(RandomIdTest, IsThirtyTwoHexDigits) {
+  const std::string id = OrtoolsLib::randomId();
+  EXPECT_EQ(id.size(), 32);
+  EXPECT_EQ(id.find_first_not_of("0123456789abcdef"), std::string::npos);
+}
+
+TEST(RandomIdTest, NeverRepeats) {
+  std::unordered_set<std::string> ids;
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(ids.insert(OrtoolsLib::randomId()).second);
+  }
+}
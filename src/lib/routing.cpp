@@ -1,534 +1,300 @@
 
 
 #include "routing.h"
-
-#include <ortools/constraint_solver/constraint_solver.h>
-#include <ortools/constraint_solver/routing.h>
-#include <ortools/constraint_solver/routing_index_manager.h>
-#include <ortools/constraint_solver/routing_parameters.h>
+#include "cooperativeSearch.h"
+#include "earlyStop.h"
+#include "exactTsp.h"
+#include "portfolio.h"
+#include "routingInstance.h"
+#include "searchParameters.h"
+#include "solveContext.h"
 
 #include <algorithm>
 #include <cstdint>
 #include <optional>
-#include <unordered_map>
-#include <unordered_set>
+#include <stdexcept>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace OrtoolsLib {
-std::vector<RoutingResponse> Routing::solve() {
-  std::unordered_map<int, int> new_index_to_old_index;
-  std::unordered_set<int> pick_drop_set;
-  if (_with_pickup_delivery.has_value()) {
-    for (auto &pair : _with_pickup_delivery.value().pickups_deliveries) {
-      if (pick_drop_set.count(pair.pickup)) {
-        _duplicateNodesToBack(pair.pickup);
-        new_index_to_old_index[_duration_matrix.size() - 1] = pair.pickup;
-        pair.pickup = _duration_matrix.size() - 1;
-      } else {
-        pick_drop_set.insert(pair.pickup);
-      }
+namespace {
+// when the request sets no limit of its own
+constexpr int64_t kDefaultTimeLimitMs = 1000;
+// the default limit is cut to kShortTimeLimitMs up to this many nodes
+constexpr size_t kShortSearchNodeCount = 50;
+constexpr int64_t kShortTimeLimitMs = 250;
+// from this many nodes a plain solve without a time limit runs
+// GREEDY_DESCENT
+constexpr size_t kGreedyNodeCount = 1000;
+} // namespace
+
+std::vector<RoutingResponse> Routing::solve() const {
+  return solve(SolveContext{});
+}
 
-      if (pick_drop_set.count(pair.delivery)) {
-        _duplicateNodesToBack(pair.delivery);
-        new_index_to_old_index[_duration_matrix.size() - 1] = pair.delivery;
-        pair.delivery = _duration_matrix.size() - 1;
-      } else {
-        pick_drop_set.insert(pair.delivery);
-      }
-    }
+std::vector<RoutingResponse>
+Routing::solve(const SolveContext &context) const {
+  const EnginePlan plan = enginePlan();
+  const std::optional<int64_t> time_limit_ms =
+      context.timeLimitMs(plan.time_limit_ms);
+  std::optional<RoutingSolution> solution;
+  switch (plan.engine) {
+  case SolverEngine::EXACT:
+    solution = ExactTsp(*this).solve(context);
+    break;
+  case SolverEngine::COOPERATIVE_PORTFOLIO:
+    solution = solveCooperative(*this, _with_portfolio.value(), time_limit_ms,
+                                context);
+    break;
+  case SolverEngine::PORTFOLIO:
+    solution = solvePortfolio(*this, _with_portfolio.value(), time_limit_ms,
+                              context);
+    break;
+  case SolverEngine::GREEDY_DESCENT:
+  case SolverEngine::LOCAL_SEARCH: {
+    EarlyStop early_stop(_search_options);
+    RoutingInstance instance(*this);
+    instance.attach(context);
+    instance.attach(early_stop);
+    solution = instance.solve(
+        makeSearchParameters(plan.strategy, _search_options, time_limit_ms));
+    break;
+  }
   }
 
-  std::optional<operations_research::RoutingIndexManager> optManager;
-  const SingleDepot *depot = std::get_if<SingleDepot>(&_depot_config);
-  const startEndPair *start_end = std::get_if<startEndPair>(&_depot_config);
-  if (depot) {
-    auto m_depot = depot->depot;
-    if (m_depot == -1) {
-      _addDummyLocAtEnd();
-      m_depot = _duration_matrix.size() - 1;
-    }
-
-    if (pick_drop_set.count(m_depot)) {
-      _duplicateNodesToBack(m_depot);
-      new_index_to_old_index[_duration_matrix.size() - 1] = m_depot;
-      m_depot = _duration_matrix.size() - 1;
-    }
-
-    optManager.emplace(_duration_matrix.size(), _num_vehicles,
-                       operations_research::RoutingNodeIndex{m_depot});
-  } else if (start_end) {
-    std::vector<operations_research::RoutingNodeIndex> m_start_nodes(
-        start_end->starts.begin(), start_end->starts.end());
-    std::vector<operations_research::RoutingNodeIndex> m_end_nodes(
-        start_end->ends.begin(), start_end->ends.end());
-
-    if (find(m_start_nodes.begin(), m_start_nodes.end(), -1) !=
-            m_start_nodes.end() ||
-        find(m_end_nodes.begin(), m_end_nodes.end(), -1) != m_end_nodes.end()) {
-      _addDummyLocAtEnd();
-      for (auto &start : m_start_nodes) {
-        if (start == -1) {
-          start = _duration_matrix.size() - 1;
-        }
-      }
-      for (auto &end : m_end_nodes) {
-        if (end == -1) {
-          end = _duration_matrix.size() - 1;
-        }
-      }
-    }
+  if (!solution) {
+    throw std::runtime_error("No solution found");
+  }
 
-    for (auto &start : m_start_nodes) {
-      if (pick_drop_set.count(start.value())) {
-        _duplicateNodesToBack(start.value());
-        new_index_to_old_index[_duration_matrix.size() - 1] = start.value();
-        start = _duration_matrix.size() - 1;
-      }
-    }
+  return std::move(solution->responses);
+};
 
-    for (auto &end : m_end_nodes) {
-      if (pick_drop_set.count(end.value())) {
-        _duplicateNodesToBack(end.value());
-        new_index_to_old_index[_duration_matrix.size() - 1] = end.value();
-        end = _duration_matrix.size() - 1;
-      }
+namespace {
+void addTimeWindows(FingerprintBuilder &builder,
+                    const std::vector<std::vector<TimeWindow>> &windows) {
+  builder.add(static_cast<uint64_t>(windows.size()));
+  for (const auto &node_windows : windows) {
+    builder.add(static_cast<uint64_t>(node_windows.size()));
+    for (const auto &window : node_windows) {
+      builder.add(window.start).add(window.end);
     }
-
-    optManager.emplace(_duration_matrix.size(), _num_vehicles, m_start_nodes,
-                       m_end_nodes);
-  } else {
-    throw InvalidConfiguration("Invalid depot configuration");
   }
+}
 
-  operations_research::RoutingIndexManager manager = optManager.value();
-
-  operations_research::RoutingModel routing(manager);
-
-  const int transit_callback_index = routing.RegisterTransitCallback(
-      [this, &manager](int64_t from_index, int64_t to_index) -> int64_t {
-        const int from_node = manager.IndexToNode(from_index).value();
-        const int to_node = manager.IndexToNode(to_index).value();
-
-        if (_with_service_time.has_value()) {
-          const int64_t service_time =
-              _with_service_time.value().service_time[from_node];
-          return _duration_matrix[from_node][to_node] + service_time;
-        }
-
-        return _duration_matrix[from_node][to_node];
-      });
-
-  // Define cost of each arc.
-  routing.SetArcCostEvaluatorOfAllVehicles(transit_callback_index);
-  const std::string time = "Time";
+void addStrategy(FingerprintBuilder &builder, const SearchStrategy &strategy) {
+  builder.add(static_cast<int32_t>(strategy.first_solution))
+      .add(static_cast<int32_t>(strategy.metaheuristic));
+}
+} // namespace
 
-  int64_t time_capacity = INT64_MAX;
-  if (_with_time_window.has_value()) {
-    auto &twss = _with_time_window.value().time_windows;
-    int64_t mx = 0;
+Fingerprint Routing::fingerprint() const {
+  FingerprintBuilder builder;
 
-    for (const auto &tws : twss) {
-      for (const auto &tw : tws) {
-        if (tw.start == 0 && tw.end == INT64_MAX) {
-          continue;
-        }
-
-        mx = std::max(mx, tw.start);
-        mx = std::max(mx, tw.end);
-      }
-    }
-    if (mx > 0) {
-      time_capacity = mx;
+  builder.add(static_cast<uint64_t>(_duration_matrix.size()));
+  for (size_t i = 0; i < _duration_matrix.size(); ++i) {
+    for (const int64_t value : _duration_matrix.row(i)) {
+      builder.add(value);
     }
   }
 
-  int64_t slack_time = 0;
-  if (_with_vehicle_break_time.has_value()) {
-    int64_t mx = 0;
-    const auto &break_times = _with_vehicle_break_time.value().break_time;
-    for (const auto &break_time : break_times) {
-      for (const auto &bt : break_time) {
-        mx = std::max(mx, bt.end - bt.start);
-      }
-    }
-
-    slack_time = mx;
+  builder.add(static_cast<uint64_t>(_depot_config.index()));
+  if (const auto *depot = std::get_if<SingleDepot>(&_depot_config)) {
+    builder.add(depot->depot);
+  } else if (const auto *start_end =
+                 std::get_if<startEndPair>(&_depot_config)) {
+    builder.add(start_end->starts).add(start_end->ends);
   }
-  routing.AddDimension(transit_callback_index, slack_time, time_capacity,
-                       !_with_time_window.has_value(), time);
 
-  operations_research::RoutingDimension &time_dimension =
-      *routing.GetMutableDimension(time);
+  builder.add(_num_vehicles).add(_time_limit);
 
+  builder.add(_with_capacity.has_value());
   if (_with_capacity.has_value()) {
-    const std::vector<int64_t> &capacities = _with_capacity.value().capacities;
-    const std::vector<int64_t> &demands = _with_capacity.value().demands;
-    const int demand_callback_index = routing.RegisterUnaryTransitCallback(
-        [&demands, &manager](const int64_t from_index) -> int64_t {
-          const int from_node = manager.IndexToNode(from_index).value();
-          return demands[from_node];
-        });
-    routing.AddDimensionWithVehicleCapacity(
-        demand_callback_index, // transit callback index
-        int64_t{0},            // null capacity slack
-        capacities,            // vehicle maximum capacities
-        true,                  // start cumul to zero
-        "Capacity");
+    builder.add(_with_capacity->capacities).add(_with_capacity->demands);
   }
 
+  builder.add(_with_pickup_delivery.has_value());
   if (_with_pickup_delivery.has_value()) {
-    const auto &pd_config = _with_pickup_delivery.value();
-    const auto &pickups_deliveries = pd_config.pickups_deliveries;
-    const auto &pd_policy = pd_config.policy;
-
-    operations_research::Solver *const solver = routing.solver();
-    for (const PickupDelivery &pair : pickups_deliveries) {
-      const int64_t pickup_index = manager.NodeToIndex(
-          operations_research::RoutingIndexManager::NodeIndex(pair.pickup));
-      const int64_t delivery_index = manager.NodeToIndex(
-          operations_research::RoutingIndexManager::NodeIndex(pair.delivery));
-      routing.AddPickupAndDelivery(pickup_index, delivery_index);
-      solver->AddConstraint(
-          solver->MakeEquality(static_cast<operations_research::IntVar *>(
-                                   routing.VehicleVar(pickup_index)),
-                               static_cast<operations_research::IntVar *>(
-                                   routing.VehicleVar(delivery_index))));
-      solver->AddConstraint(
-          solver->MakeLessOrEqual(time_dimension.CumulVar(pickup_index),
-                                  time_dimension.CumulVar(delivery_index)));
-    }
-
-    if (pd_policy.has_value()) {
-      switch (pd_policy.value()) {
-      case PickupDropOption::FIFO:
-        routing.SetPickupAndDeliveryPolicyOfAllVehicles(
-            operations_research::RoutingModel::PICKUP_AND_DELIVERY_FIFO);
-        break;
-      case PickupDropOption::LIFO:
-        routing.SetPickupAndDeliveryPolicyOfAllVehicles(
-            operations_research::RoutingModel::PICKUP_AND_DELIVERY_LIFO);
-        break;
-      default:
-        throw InvalidConfiguration("Invalid pickup and delivery policy");
-      }
+    const auto &policy = _with_pickup_delivery->policy;
+    builder.add(policy.has_value());
+    if (policy.has_value()) {
+      builder.add(static_cast<int32_t>(policy.value()));
     }
-  }
-
-  if (_with_time_window.has_value()) {
-    std::vector<std::vector<TimeWindow>> &time_windows =
-        _with_time_window.value().time_windows;
-    for (int i = 0; i < time_windows.size(); ++i) {
-      std::sort(time_windows[i].begin(), time_windows[i].end());
 
-      if (depot && depot->depot == i) {
-        continue;
-      }
-
-      if (start_end) {
-        const std::vector<int> &starts = start_end->starts;
-        const std::vector<int> &ends = start_end->ends;
-        if (std::find(starts.begin(), starts.end(), i) != starts.end()) {
-          continue;
-        }
-        if (std::find(ends.begin(), ends.end(), i) != ends.end()) {
-          continue;
-        }
-      }
-
-      _addTimeWindow(
-          time_dimension.CumulVar(manager.NodeToIndex(
-              operations_research::RoutingIndexManager::NodeIndex(i))),
-          time_windows[i]);
-    }
-
-    for (int i = 0; i < _num_vehicles; ++i) {
-      const int64_t route_start_idx = routing.Start(i);
-      const int64_t route_end_idx = routing.End(i);
-      if (depot && depot->depot != -1) {
-        _addTimeWindow(time_dimension.CumulVar(route_start_idx),
-                       time_windows[depot->depot]);
-      }
-
-      if (start_end) {
-        auto start_idx = start_end->starts[i];
-        if (start_idx != -1)
-          _addTimeWindow(time_dimension.CumulVar(route_start_idx),
-                         time_windows[start_idx]);
-
-        auto end_idx = start_end->ends[i];
-        if (end_idx != -1)
-          _addTimeWindow(time_dimension.CumulVar(route_end_idx),
-                         time_windows[end_idx]);
-      }
+    const auto &pairs = _with_pickup_delivery->pickups_deliveries;
+    builder.add(static_cast<uint64_t>(pairs.size()));
+    for (const auto &pair : pairs) {
+      builder.add(pair.pickup).add(pair.delivery);
     }
   }
 
-  if (_with_vehicle_break_time.has_value()) {
-    std::vector<std::vector<TimeWindow>> &break_time =
-        _with_vehicle_break_time.value().break_time;
-
-    operations_research::Solver *const solver = routing.solver();
-    std::vector<int64_t> node_visit_transit(_duration_matrix.size(), 0);
-
-    if (_with_service_time.has_value()) {
-      const auto &service_time = _with_service_time.value().service_time;
-      for (int i = 0; i < service_time.size(); ++i) {
-        node_visit_transit[i] = service_time[i];
-      }
-    }
-
-    for (int i = 0; i < break_time.size(); ++i) {
-      std::sort(break_time[i].begin(), break_time[i].end());
-
-      std::vector<operations_research::IntervalVar *> break_intervals;
-      for (int j = 0; j < break_time[i].size(); ++j) {
-        const auto new_var =
-            solver
-                ->MakeSum(time_dimension.CumulVar(routing.Start(i)),
-                          break_time[i][j].start)
-                ->Var();
-        break_intervals.emplace_back(solver->MakeFixedDurationIntervalVar(
-            new_var, break_time[i][j].end - break_time[i][j].start,
-            "break time on vehicle " + std::to_string(i) + "on i" +
-                std::to_string(j)));
-      }
+  builder.add(_with_time_window.has_value());
+  if (_with_time_window.has_value()) {
+    addTimeWindows(builder, _with_time_window->time_windows);
+  }
 
-      time_dimension.SetBreakIntervalsOfVehicle(break_intervals, i,
-                                                node_visit_transit);
-    }
+  builder.add(_with_service_time.has_value());
+  if (_with_service_time.has_value()) {
+    builder.add(_with_service_time->service_time);
   }
 
+  builder.add(_with_drop_penalties.has_value());
   if (_with_drop_penalties.has_value()) {
-    auto &m_penalties_var = _with_drop_penalties.value().penalties;
-    if (auto *m_global_penalties = std::get_if<int64_t>(&m_penalties_var);
-        m_global_penalties) {
-      const auto M = _duration_matrix.size();
-      for (int i = 0; i < M; ++i) {
-        if (_duration_matrix[i] == std::vector<int64_t>(M, 0)) {
-          continue;
-        }
-
-        if (depot && depot->depot == i) {
-          continue;
-        }
-        if (start_end) {
-          const std::vector<int> &starts = start_end->starts;
-          const std::vector<int> &ends = start_end->ends;
-          if (std::find(starts.begin(), starts.end(), i) != starts.end()) {
-            continue;
-          }
-
-          if (std::find(ends.begin(), ends.end(), i) != ends.end()) {
-            continue;
-          }
-        }
-        routing.AddDisjunction(
-            {manager.NodeToIndex(
-                operations_research::RoutingIndexManager::NodeIndex(i))},
-            *m_global_penalties);
-      }
+    const auto &penalties = _with_drop_penalties->penalties;
+    builder.add(static_cast<uint64_t>(penalties.index()));
+    if (const auto *global = std::get_if<int64_t>(&penalties)) {
+      builder.add(*global);
+    } else {
+      builder.add(std::get<std::vector<int64_t>>(penalties));
     }
-    if (auto *m_penalties = std::get_if<std::vector<int64_t>>(&m_penalties_var);
-        m_penalties) {
-      const auto M = _duration_matrix.size();
-      for (int i = 0; i < M; ++i) {
-        if (_duration_matrix[i] == std::vector<int64_t>(M, 0)) {
-          continue;
-        }
+  }
 
-        if (depot && depot->depot == i) {
-          continue;
-        }
+  builder.add(_with_vehicle_break_time.has_value());
+  if (_with_vehicle_break_time.has_value()) {
+    addTimeWindows(builder, _with_vehicle_break_time->break_time);
+  }
 
-        if (start_end) {
-          const std::vector<int> &starts = start_end->starts;
-          const std::vector<int> &ends = start_end->ends;
-          if (std::find(starts.begin(), starts.end(), i) != starts.end()) {
-            continue;
-          }
-          if (std::find(ends.begin(), ends.end(), i) != ends.end()) {
-            continue;
-          }
-        }
-        routing.AddDisjunction(
-            {manager.NodeToIndex(
-                operations_research::RoutingIndexManager::NodeIndex(i))},
-            m_penalties->at(i));
-      }
+  builder.add(_with_portfolio.has_value());
+  if (_with_portfolio.has_value()) {
+    builder.add(_with_portfolio->num_workers)
+        .add(_with_portfolio->share_incumbent)
+        .add(static_cast<uint64_t>(_with_portfolio->strategies.size()));
+    for (const auto &strategy : _with_portfolio->strategies) {
+      addStrategy(builder, strategy);
     }
   }
 
-  for (int i = 0; i < _num_vehicles; ++i) {
-    routing.AddVariableMinimizedByFinalizer(
-        time_dimension.CumulVar(routing.Start(i)));
-    routing.AddVariableMinimizedByFinalizer(
-        time_dimension.CumulVar(routing.End(i)));
+  // log_search only changes what is printed, not what is found
+  builder.add(_search_options.time_limit_ms)
+      .add(_search_options.lns_time_limit_ms)
+      .add(_search_options.solution_limit)
+      .add(_search_options.first_solution.has_value());
+  if (_search_options.first_solution.has_value()) {
+    builder.add(static_cast<int32_t>(_search_options.first_solution.value()));
   }
-
-  int64_t time_limit_sec = 1;
-  if (_time_limit.has_value()) {
-    time_limit_sec = _time_limit.value();
+  builder.add(_search_options.metaheuristic.has_value());
+  if (_search_options.metaheuristic.has_value()) {
+    builder.add(static_cast<int32_t>(_search_options.metaheuristic.value()));
   }
+  builder.add(_search_options.use_full_propagation)
+      .add(_search_options.stagnation_ms)
+      .add(_search_options.improvement_window_ms)
+      .add(_search_options.min_relative_improvement)
+      .add(_search_options.target_objective);
 
-  // Setting first solution heuristic.
-  operations_research::RoutingSearchParameters searchParameters =
-      operations_research::DefaultRoutingSearchParameters();
-  searchParameters.set_first_solution_strategy(
-      operations_research::FirstSolutionStrategy::PATH_CHEAPEST_ARC);
-  searchParameters.set_local_search_metaheuristic(
-      operations_research::LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH);
-
-  searchParameters.mutable_time_limit()->set_seconds(time_limit_sec);
-
-  // Solve the problem.
-  const operations_research::Assignment *solution =
-      routing.SolveWithParameters(searchParameters);
-  if (!solution) {
-    throw std::runtime_error("No solution found");
+  builder.add(_with_initial_routes.has_value());
+  if (_with_initial_routes.has_value()) {
+    builder.add(_with_initial_routes->routes);
   }
 
-  std::vector<RoutingResponse> responses(_num_vehicles);
-  for (int vehicle_id = 0; vehicle_id < _num_vehicles; ++vehicle_id) {
-    if (!routing.IsVehicleUsed(*solution, vehicle_id)) {
-      continue;
-    }
-    std::vector<int> route;
-    int64_t index = routing.Start(vehicle_id);
-    while (!routing.IsEnd(index)) {
-      auto val = manager.IndexToNode(index).value();
-      if (new_index_to_old_index.count(val)) {
-        val = new_index_to_old_index.at(val);
-      }
-      route.push_back(val);
-      index = solution->Value(routing.NextVar(index));
-    }
-    auto val = manager.IndexToNode(index).value();
-    if (new_index_to_old_index.count(val)) {
-      val = new_index_to_old_index.at(val);
-    }
-    route.push_back(val);
-    auto time_var = time_dimension.CumulVar(index);
-
-    if (depot && depot->depot == -1) {
-      route.pop_back();
-      route.erase(route.begin());
-    }
-
-    if (start_end) {
-      if (start_end->starts.at(vehicle_id) == -1)
-        route.erase(route.begin());
-
-      if (start_end->ends.at(vehicle_id) == -1)
-        route.pop_back();
-    }
-
-    responses[vehicle_id] = RoutingResponse{
-        .route = route,
-        .total_duration = solution->Min(time_var),
-    };
+  builder.add(_with_locked_routes.has_value());
+  if (_with_locked_routes.has_value()) {
+    builder.add(_with_locked_routes->routes);
   }
 
-  return responses;
-};
-
-void Routing::_addTimeWindow(operations_research::IntVar *const time_dimension,
-                             std::vector<TimeWindow> &time_window) {
-  if (!time_dimension) {
-    return;
-  }
-  if (const auto tw_idx = std::find(time_window.begin(), time_window.end(),
-                                    TimeWindow{0, INT64_MAX});
-      tw_idx != time_window.end()) {
-    time_window.erase(tw_idx);
+  builder.add(_with_cancelled_orders.has_value());
+  if (_with_cancelled_orders.has_value()) {
+    builder.add(_with_cancelled_orders->nodes);
   }
 
-  if (time_window.empty()) {
-    return;
+  builder.add(_with_unavailable_vehicles.has_value());
+  if (_with_unavailable_vehicles.has_value()) {
+    builder.add(_with_unavailable_vehicles->vehicles);
   }
 
-  auto earliest_start = time_window[0].start;
-  auto latest_end = time_window[time_window.size() - 1].end;
+  return builder.finish();
+}
 
-  time_dimension->SetRange(earliest_start, latest_end);
-  for (int i = 0; i < time_window.size() - 1; ++i) {
-    auto curr_end = time_window[i].end;
-    auto next_start = time_window[i + 1].start;
+const char *solverEngineName(SolverEngine engine) {
+  switch (engine) {
+  case SolverEngine::EXACT:
+    return "EXACT";
+  case SolverEngine::GREEDY_DESCENT:
+    return "GREEDY_DESCENT";
+  case SolverEngine::LOCAL_SEARCH:
+    return "LOCAL_SEARCH";
+  case SolverEngine::PORTFOLIO:
+    return "PORTFOLIO";
+  case SolverEngine::COOPERATIVE_PORTFOLIO:
+    return "COOPERATIVE_PORTFOLIO";
+  }
+  return "LOCAL_SEARCH";
+}
 
-    if (curr_end < next_start) {
-      time_dimension->RemoveInterval(curr_end, next_start);
-    }
-  }
+EnginePlan Routing::enginePlan() const {
+  EnginePlan plan{
+      .engine = SolverEngine::LOCAL_SEARCH,
+      .strategy =
+          SearchStrategy{
+              .first_solution = _search_options.first_solution.value_or(
+                  kDefaultSearchStrategy.first_solution),
+              .metaheuristic = _search_options.metaheuristic.value_or(
+                  kDefaultSearchStrategy.metaheuristic),
+          },
+      .time_limit_ms = _configuredTimeLimitMs(),
+  };
+
+  if (ExactTsp::qualifies(*this)) {
+    plan.engine = SolverEngine::EXACT;
+    return plan;
+  }
+  if (_with_portfolio.has_value()) {
+    plan.engine = _with_portfolio->share_incumbent
+                      ? SolverEngine::COOPERATIVE_PORTFOLIO
+                      : SolverEngine::PORTFOLIO;
+    return plan;
+  }
+  if (_search_options.first_solution.has_value() ||
+      _search_options.metaheuristic.has_value()) {
+    return plan;
+  }
+
+  const size_t node_count = _duration_matrix.size();
+  const bool explicit_time_limit =
+      _search_options.time_limit_ms.has_value() || _time_limit.has_value();
+  if (node_count >= kGreedyNodeCount && !explicit_time_limit) {
+    // guided local search barely gets past the first solution in a time
+    // limit this size of problem is usually given
+    plan.engine = SolverEngine::GREEDY_DESCENT;
+    plan.strategy.metaheuristic = LocalSearchMetaheuristic::GREEDY_DESCENT;
+  } else if (node_count <= kShortSearchNodeCount && !explicit_time_limit &&
+             !_search_options.solution_limit.has_value()) {
+    // small problems stop improving long before the default limit
+    plan.time_limit_ms = kShortTimeLimitMs;
+  }
+  return plan;
 }
 
-void Routing::_addDummyLocAtEnd() {
-  auto n = _duration_matrix.size();
-  for (int i = 0; i < n; ++i) {
-    _duration_matrix[i].emplace_back(0);
-  }
-  _duration_matrix.emplace_back(std::vector<int64_t>(n + 1, 0));
+std::optional<int64_t> Routing::timeLimitMs() const {
+  return enginePlan().time_limit_ms;
+}
 
-  if (_with_capacity.has_value()) {
-    _with_capacity.value().demands.emplace_back(0);
+std::optional<int64_t> Routing::_configuredTimeLimitMs() const {
+  if (_search_options.time_limit_ms.has_value()) {
+    return _search_options.time_limit_ms;
   }
-
-  if (_with_time_window.has_value()) {
-    _with_time_window.value().time_windows.emplace_back(
-        std::vector<TimeWindow>{{0, INT64_MAX}});
+  if (_time_limit.has_value()) {
+    return _time_limit.value() * 1000;
   }
-
-  if (_with_service_time.has_value()) {
-    _with_service_time.value().service_time.push_back(0);
+  if (_search_options.solution_limit.has_value()) {
+    return std::nullopt;
   }
 
-  if (_with_drop_penalties.has_value()) {
-    std::vector<int64_t> *penalties = std::get_if<std::vector<int64_t>>(
-        &_with_drop_penalties.value().penalties);
-    if (penalties)
-      penalties->emplace_back(0);
-  }
+  return kDefaultTimeLimitMs;
 }
 
-void Routing::_duplicateNodesToBack(int at) {
-  size_t n = _duration_matrix.size();
-  std::vector<int64_t> duplicated = _duration_matrix[at];
-  for (int i = 0; i < n; ++i) {
-    _duration_matrix[i].emplace_back(duplicated[i]);
-  }
-  duplicated.emplace_back(0);
-  _duration_matrix.emplace_back(std::move(duplicated));
-
-  if (_with_capacity.has_value()) {
-    auto &demands = _with_capacity.value().demands;
-    demands.emplace_back(demands[at]);
-    auto &capacties = _with_capacity.value().capacities;
+RoutingBuilder Routing::builder() { return RoutingBuilder(); }
 
-    for (auto &cap : capacties) {
-      cap += demands[at];
+RoutingBuilder &&RoutingBuilder::setDurationMatrix(
+    const std::vector<std::vector<int64_t>> &matrix) && {
+  for (const auto &row : matrix) {
+    if (row.size() != matrix.size()) {
+      throw InvalidConfiguration("durationMatrix", "not square");
     }
   }
 
-  if (_with_time_window.has_value()) {
-    auto &time_windows = _with_time_window.value().time_windows;
-    time_windows.emplace_back(time_windows[at]);
-  }
-
-  if (_with_service_time.has_value()) {
-    auto &service_time = _with_service_time.value().service_time;
-    service_time.emplace_back(service_time[at]);
-  }
-
-  if (_with_drop_penalties.has_value()) {
-    std::vector<int64_t> *penalties = std::get_if<std::vector<int64_t>>(
-        &_with_drop_penalties.value().penalties);
-    if (penalties)
-      penalties->emplace_back(penalties->at(at));
-  }
-}
-
-RoutingBuilder Routing::builder() {
-  Routing r;
-  return RoutingBuilder{r};
+  _routing._duration_matrix = DurationMatrix::fromRows(matrix);
+  return std::move(*this);
 }
 
 void RoutingBuilder::_validate() const {
@@ -538,11 +304,8 @@ void RoutingBuilder::_validate() const {
   }
 
   const auto nodeCount = _routing._duration_matrix.size();
-  for (size_t i = 0; i < nodeCount; ++i) {
-    if (_routing._duration_matrix[i].size() != nodeCount) {
-      // throw InvalidConfiguration("durationMatrix is not square");
-      throw InvalidConfiguration("durationMatrix", "not square");
-    }
+  if (!_routing._duration_matrix.isBoundedBy(Routing::kMaxDuration)) {
+    throw InvalidConfiguration("durationMatrix", "duration out of range");
   }
 
   const auto numVehicle = _routing._num_vehicles;
@@ -551,12 +314,90 @@ void RoutingBuilder::_validate() const {
     throw InvalidConfiguration("numVehicles", "not positive");
   }
 
+  // -1 stands for a virtual node every route may start or end at
+  const auto isDepotNode = [nodeCount](int32_t node) {
+    return node == -1 || (node >= 0 && node < nodeCount);
+  };
+  if (const auto *depot = std::get_if<SingleDepot>(&_routing._depot_config)) {
+    if (!isDepotNode(depot->depot)) {
+      throw InvalidConfiguration("routingMode", "depot out of range");
+    }
+  } else if (const auto *start_end =
+                 std::get_if<startEndPair>(&_routing._depot_config)) {
+    if (start_end->starts.size() != numVehicle ||
+        start_end->ends.size() != numVehicle) {
+      throw InvalidConfiguration("routingMode",
+                                 "starts and ends are not one per vehicle");
+    }
+    if (!std::all_of(start_end->starts.begin(), start_end->starts.end(),
+                     isDepotNode) ||
+        !std::all_of(start_end->ends.begin(), start_end->ends.end(),
+                     isDepotNode)) {
+      throw InvalidConfiguration("routingMode", "node out of range");
+    }
+  }
+
   if (_routing._time_limit.has_value()) {
     const auto time_limit = _routing._time_limit.value();
     if (time_limit <= 0) {
       // throw InvalidConfiguration("time limit is not positive");
       throw InvalidConfiguration("timeLimit", "not positive");
     }
+    if (time_limit > Routing::kMaxTimeLimitMs / 1000) {
+      throw InvalidConfiguration("timeLimit", "too large");
+    }
+  }
+
+  const auto &search_options = _routing._search_options;
+  if (search_options.time_limit_ms.has_value() &&
+      search_options.time_limit_ms.value() <= 0) {
+    throw InvalidConfiguration("searchOptions.timeLimitMs", "not positive");
+  }
+  if (search_options.time_limit_ms.has_value() &&
+      search_options.time_limit_ms.value() > Routing::kMaxTimeLimitMs) {
+    throw InvalidConfiguration("searchOptions.timeLimitMs", "too large");
+  }
+  if (search_options.lns_time_limit_ms.has_value() &&
+      search_options.lns_time_limit_ms.value() <= 0) {
+    throw InvalidConfiguration("searchOptions.lnsTimeLimitMs", "not positive");
+  }
+  if (search_options.lns_time_limit_ms.has_value() &&
+      search_options.lns_time_limit_ms.value() > Routing::kMaxTimeLimitMs) {
+    throw InvalidConfiguration("searchOptions.lnsTimeLimitMs", "too large");
+  }
+  if (search_options.solution_limit.has_value() &&
+      search_options.solution_limit.value() <= 0) {
+    throw InvalidConfiguration("searchOptions.solutionLimit", "not positive");
+  }
+  if (search_options.stagnation_ms.has_value() &&
+      search_options.stagnation_ms.value() <= 0) {
+    throw InvalidConfiguration("searchOptions.stagnationMs", "not positive");
+  }
+  if (search_options.stagnation_ms.has_value() &&
+      search_options.stagnation_ms.value() > Routing::kMaxTimeLimitMs) {
+    throw InvalidConfiguration("searchOptions.stagnationMs", "too large");
+  }
+  if (search_options.improvement_window_ms.has_value() !=
+      search_options.min_relative_improvement.has_value()) {
+    throw InvalidConfiguration(
+        "searchOptions.improvementWindowMs",
+        "must be given together with minRelativeImprovement");
+  }
+  if (search_options.improvement_window_ms.has_value() &&
+      search_options.improvement_window_ms.value() <= 0) {
+    throw InvalidConfiguration("searchOptions.improvementWindowMs",
+                               "not positive");
+  }
+  if (search_options.improvement_window_ms.has_value() &&
+      search_options.improvement_window_ms.value() > Routing::kMaxTimeLimitMs) {
+    throw InvalidConfiguration("searchOptions.improvementWindowMs",
+                               "too large");
+  }
+  if (search_options.min_relative_improvement.has_value() &&
+      !(search_options.min_relative_improvement.value() >= 0 &&
+        search_options.min_relative_improvement.value() <= 1)) {
+    throw InvalidConfiguration("searchOptions.minRelativeImprovement",
+                               "not between 0 and 1");
   }
 
   if (_routing._with_capacity.has_value()) {
@@ -635,6 +476,9 @@ void RoutingBuilder::_validate() const {
       if (st < 0) {
         throw InvalidConfiguration("service_time is negative");
       }
+      if (st > Routing::kMaxDuration) {
+        throw InvalidConfiguration("service_time", "out of range");
+      }
     }
   }
 
@@ -661,6 +505,92 @@ void RoutingBuilder::_validate() const {
     }
   }
 
+  if (_routing._with_initial_routes.has_value()) {
+    const auto &routes = _routing._with_initial_routes.value().routes;
+    if (routes.size() > numVehicle) {
+      throw InvalidConfiguration("initialRoutes", "more routes than vehicles");
+    }
+    for (const auto &route : routes) {
+      for (const auto node : route) {
+        if (node < 0 || node >= nodeCount) {
+          throw InvalidConfiguration("initialRoutes", "node out of range");
+        }
+      }
+    }
+  }
+
+  if (_routing._with_locked_routes.has_value()) {
+    const auto &routes = _routing._with_locked_routes.value().routes;
+    if (routes.size() > numVehicle) {
+      throw InvalidConfiguration("lockedRoutes", "more routes than vehicles");
+    }
+    std::vector<bool> locked(nodeCount, false);
+    for (int32_t vehicle = 0; vehicle < routes.size(); ++vehicle) {
+      const int32_t start =
+          std::holds_alternative<SingleDepot>(_routing._depot_config)
+              ? std::get<SingleDepot>(_routing._depot_config).depot
+              : std::get<startEndPair>(_routing._depot_config)
+                    .starts[vehicle];
+      for (size_t i = 0; i < routes[vehicle].size(); ++i) {
+        const auto node = routes[vehicle][i];
+        if (node < 0 || node >= nodeCount) {
+          throw InvalidConfiguration("lockedRoutes", "node out of range");
+        }
+        if (i == 0 && node == start) {
+          continue;
+        }
+        // duplicated pickup/delivery nodes could repeat, plain visits cannot
+        if (locked[node] && !_routing._with_pickup_delivery.has_value()) {
+          throw InvalidConfiguration("lockedRoutes", "node locked twice");
+        }
+        locked[node] = true;
+      }
+    }
+  }
+
+  if (_routing._with_cancelled_orders.has_value()) {
+    const auto &depot_config = _routing._depot_config;
+    const auto *depot = std::get_if<SingleDepot>(&depot_config);
+    const auto *start_end = std::get_if<startEndPair>(&depot_config);
+    for (const auto node : _routing._with_cancelled_orders.value().nodes) {
+      if (node < 0 || node >= nodeCount) {
+        throw InvalidConfiguration("cancelledOrders", "node out of range");
+      }
+      if ((depot && depot->depot == node) ||
+          (start_end &&
+           (std::find(start_end->starts.begin(), start_end->starts.end(),
+                      node) != start_end->starts.end() ||
+            std::find(start_end->ends.begin(), start_end->ends.end(), node) !=
+                start_end->ends.end()))) {
+        throw InvalidConfiguration("cancelledOrders", "node is a depot");
+      }
+    }
+  }
+
+  if (_routing._with_unavailable_vehicles.has_value()) {
+    for (const auto vehicle :
+         _routing._with_unavailable_vehicles.value().vehicles) {
+      if (vehicle < 0 || vehicle >= numVehicle) {
+        throw InvalidConfiguration("unavailableVehicles",
+                                   "vehicle out of range");
+      }
+    }
+  }
+
+  if (_routing._with_portfolio.has_value()) {
+    const auto &with_portfolio = _routing._with_portfolio.value();
+    if (with_portfolio.num_workers < 0) {
+      throw InvalidConfiguration("withPortfolio.numWorkers", "negative");
+    }
+    if (with_portfolio.num_workers > RoutingOptionWithPortfolio::kMaxWorkers) {
+      throw InvalidConfiguration("withPortfolio.numWorkers", "too large");
+    }
+    if (with_portfolio.strategies.size() >
+        RoutingOptionWithPortfolio::kMaxStrategies) {
+      throw InvalidConfiguration("withPortfolio.strategies", "too many");
+    }
+  }
+
   if (_routing._with_vehicle_break_time.has_value()) {
     const auto &break_time =
         _routing._with_vehicle_break_time.value().break_time;
@@ -686,9 +616,9 @@ void RoutingBuilder::_validate() const {
   }
 };
 
-Routing RoutingBuilder::build() const {
+Routing RoutingBuilder::build() && {
   _validate();
-  return _routing;
+  return std::move(_routing);
 }
 
 } // namespace OrtoolsLib
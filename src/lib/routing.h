@@ -4,6 +4,9 @@
 // Include necessary standard or project-specific headers
 #include <ortools/constraint_solver/constraint_solver.h>
 
+#include "durationMatrix.h"
+#include "fingerprint.h"
+
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -79,15 +82,134 @@ struct RoutingOptionWithVehicleBreakTime {
   std::vector<std::vector<TimeWindow>> break_time;
 };
 
+enum class FirstSolutionStrategy {
+  AUTOMATIC,
+  PATH_CHEAPEST_ARC,
+  PATH_MOST_CONSTRAINED_ARC,
+  SAVINGS,
+  SWEEP,
+  CHRISTOFIDES,
+  PARALLEL_CHEAPEST_INSERTION,
+  LOCAL_CHEAPEST_INSERTION,
+  GLOBAL_CHEAPEST_ARC,
+  LOCAL_CHEAPEST_ARC,
+  FIRST_UNBOUND_MIN_VALUE,
+};
+
+enum class LocalSearchMetaheuristic {
+  AUTOMATIC,
+  GREEDY_DESCENT,
+  GUIDED_LOCAL_SEARCH,
+  SIMULATED_ANNEALING,
+  TABU_SEARCH,
+  GENERIC_TABU_SEARCH,
+};
+
+struct SearchStrategy {
+  FirstSolutionStrategy first_solution;
+  LocalSearchMetaheuristic metaheuristic;
+
+  bool operator==(const SearchStrategy &b) const {
+    return first_solution == b.first_solution &&
+           metaheuristic == b.metaheuristic;
+  }
+};
+
+struct RoutingOptionWithInitialRoutes {
+  // request nodes each vehicle visits, in order; a leading start and trailing
+  // end of the vehicle are skipped so previous responses can be passed back
+  std::vector<std::vector<int32_t>> routes;
+};
+
+struct RoutingOptionWithLockedRoutes {
+  // request nodes each vehicle has already visited, in order, leading start
+  // skipped as in initialRoutes; the search only decides what comes after
+  std::vector<std::vector<int32_t>> routes;
+};
+
+struct RoutingOptionWithCancelledOrders {
+  // request nodes that must not be visited; the other half of a
+  // pickup/delivery pair is dropped with them
+  std::vector<int32_t> nodes;
+};
+
+struct RoutingOptionWithUnavailableVehicles {
+  // vehicles kept at their start, e.g. after a breakdown
+  std::vector<int32_t> vehicles;
+};
+
+struct RoutingOptionWithPortfolio {
+  // Largest num_workers and number of strategies the builder accepts. The
+  // solvers never start more threads than there are hardware threads.
+  static constexpr int32_t kMaxWorkers = 64;
+  static constexpr size_t kMaxStrategies = 64;
+
+  // worker threads, 0 runs one thread per strategy
+  int32_t num_workers = 0;
+  // strategies raced against each other, empty uses the default portfolio
+  std::vector<SearchStrategy> strategies;
+  // workers restart from the best solution any of them found instead of
+  // searching in isolation
+  bool share_incumbent = false;
+};
+
+struct SearchOptions {
+  // wall time of the whole solve, takes precedence over setTimeLimit
+  std::optional<int64_t> time_limit_ms;
+  // wall time of each large neighborhood search sub-problem
+  std::optional<int64_t> lns_time_limit_ms;
+  // stop after this many solutions; unless a time limit is also given the
+  // search is then no longer bounded by wall time
+  std::optional<int64_t> solution_limit;
+  // replace kDefaultSearchStrategy, withPortfolio brings its own strategies
+  std::optional<FirstSolutionStrategy> first_solution;
+  std::optional<LocalSearchMetaheuristic> metaheuristic;
+  bool use_full_propagation = false;
+  bool log_search = false;
+  // stop once no solution improved the objective for this long
+  std::optional<int64_t> stagnation_ms;
+  // stop once the objective improved by less than min_relative_improvement
+  // (a fraction of it) over the last improvement_window_ms; set both or
+  // neither
+  std::optional<int64_t> improvement_window_ms;
+  std::optional<double> min_relative_improvement;
+  // stop as soon as a solution is at least this good
+  std::optional<int64_t> target_objective;
+};
+
 struct RoutingResponse {
   std::vector<int> route;
   int64_t total_duration;
 };
 
+enum class SolverEngine {
+  // every visiting order of a small single vehicle tour, optimal
+  EXACT,
+  // first solution improved until no single move helps, ends on its own
+  GREEDY_DESCENT,
+  // one search strategy until the time limit
+  LOCAL_SEARCH,
+  PORTFOLIO,
+  COOPERATIVE_PORTFOLIO,
+};
+
+// "EXACT", "GREEDY_DESCENT", "LOCAL_SEARCH", "PORTFOLIO" or
+// "COOPERATIVE_PORTFOLIO"
+const char *solverEngineName(SolverEngine engine);
+
+struct EnginePlan {
+  SolverEngine engine;
+  // what GREEDY_DESCENT and LOCAL_SEARCH run
+  SearchStrategy strategy;
+  // std::nullopt when only a solution limit bounds the search
+  std::optional<int64_t> time_limit_ms;
+};
+
 class RoutingBuilder;
+struct SolveContext;
 class Routing {
 private:
-  std::vector<std::vector<int64_t>> _duration_matrix;
+  DurationMatrix _duration_matrix;
   std::variant<SingleDepot, startEndPair> _depot_config;
   int32_t _num_vehicles = 1;
   std::optional<int64_t> _time_limit;
@@ -97,42 +219,53 @@ private:
   std::optional<RoutingOptionWithServiceTime> _with_service_time;
   std::optional<RoutingOptionWithPenalties> _with_drop_penalties;
   std::optional<RoutingOptionWithVehicleBreakTime> _with_vehicle_break_time;
+  std::optional<RoutingOptionWithPortfolio> _with_portfolio;
+  SearchOptions _search_options;
+  std::optional<RoutingOptionWithInitialRoutes> _with_initial_routes;
+  std::optional<RoutingOptionWithLockedRoutes> _with_locked_routes;
+  std::optional<RoutingOptionWithCancelledOrders> _with_cancelled_orders;
+  std::optional<RoutingOptionWithUnavailableVehicles>
+      _with_unavailable_vehicles;
   Routing() {};
-  void _addTimeWindow(operations_research::IntVar *const time_dimension,
-                      std::vector<TimeWindow> &time_window);
-  void _addDummyLocAtEnd();
-  void _duplicateNodesToBack(int at);
+  // what the request asks for, before enginePlan() shortens the default
+  std::optional<int64_t> _configuredTimeLimitMs() const;
 
 public:
-  Routing(const Routing &other)
-      : _duration_matrix(other._duration_matrix),
-        _depot_config(other._depot_config), _num_vehicles(other._num_vehicles),
-        _time_limit(other._time_limit), _with_capacity(other._with_capacity),
-        _with_pickup_delivery(other._with_pickup_delivery),
-        _with_time_window(other._with_time_window),
-        _with_service_time(other._with_service_time),
-        _with_drop_penalties(other._with_drop_penalties),
-        _with_vehicle_break_time(other._with_vehicle_break_time) {}
-
-  Routing &operator=(const Routing &other) { return *this = Routing(other); }
-  Routing(Routing &&other) noexcept
-      : _duration_matrix(std::move(other._duration_matrix)),
-        _depot_config(std::move(other._depot_config)),
-        _num_vehicles(other._num_vehicles), _time_limit(other._time_limit),
-        _with_capacity(std::move(other._with_capacity)),
-        _with_pickup_delivery(std::move(other._with_pickup_delivery)),
-        _with_time_window(std::move(other._with_time_window)),
-        _with_service_time(std::move(other._with_service_time)),
-        _with_drop_penalties(std::move(other._with_drop_penalties)),
-        _with_vehicle_break_time(std::move(other._with_vehicle_break_time)) {}
-
-  Routing &operator=(Routing &&other) noexcept {
-    return *this = Routing(other);
-  }
+  // Largest duration or service time accepted, either way. Sums over routes
+  // of many thousands of nodes stay far from overflowing int64_t, in the
+  // exact solver's search as much as in OR-tools'.
+  static constexpr int64_t kMaxDuration = int64_t{1} << 40;
+  // Longest time limit accepted, of any kind: 30 days, in milliseconds. Keeps
+  // seconds-to-milliseconds conversions and deadlines on the steady clock far
+  // from overflowing.
+  static constexpr int64_t kMaxTimeLimitMs = int64_t{30} * 24 * 60 * 60 * 1000;
+
+  // move-only: a Routing owns its whole configuration, duration matrix
+  // included, and is handed along rather than duplicated
+  Routing(const Routing &) = delete;
+  Routing &operator=(const Routing &) = delete;
+  Routing(Routing &&) noexcept = default;
+  Routing &operator=(Routing &&) noexcept = default;
 
   static RoutingBuilder builder();
   friend class RoutingBuilder;
-  std::vector<RoutingResponse> solve();
+  friend class RoutingInstance;
+  friend class ExactTsp;
+  friend class RoutingSession;
+  std::vector<RoutingResponse> solve() const;
+  std::vector<RoutingResponse> solve(const SolveContext &context) const;
+  // the engine solve() runs, the cheapest one adequate for the size and
+  // options of the problem. Tours ExactTsp qualifies are solved exactly
+  // whatever the search options; otherwise a strategy or portfolio the caller
+  // asked for is honoured. Large problems only fall back to greedy descent
+  // under the default time limit.
+  EnginePlan enginePlan() const;
+  // the time limit of enginePlan()
+  std::optional<int64_t> timeLimitMs() const;
+  const SearchOptions &searchOptions() const { return _search_options; }
+  // canonical hash of the whole configuration, equal for every Routing that
+  // describes the same problem and search
+  Fingerprint fingerprint() const;
 };
 class InvalidConfiguration : public std::exception {
     std::string code = "INVALID_CONFIGURATION";
@@ -140,7 +273,7 @@ class InvalidConfiguration : public std::exception {
     std::string message;
 public:
   InvalidConfiguration(const std::string key) : key(std::move(key)), _message(std::move(key)) {}
-  InvalidConfiguration(const std::string key, const std::string message): key(std::move(key)), message(std::move(message)) {}
+  InvalidConfiguration(const std::string key, const std::string message): key(std::move(key)), message(std::move(message)), _message(this->key + " " + this->message) {}
   const char *what() const noexcept override { return _message.c_str(); }
 
 
@@ -148,67 +281,108 @@ private:
   std::string _message;
 };
 
+// Setters take their argument by value and move it in, and are called on a
+// temporary: `Routing::builder().setX(...).build()`. A builder kept in a
+// variable is passed on with std::move.
 class RoutingBuilder {
 private:
   Routing _routing;
+  RoutingBuilder() = default;
   void _validate() const;
+  friend class Routing;
 
 public:
-  RoutingBuilder(Routing &r) : _routing(r) {}
-  RoutingBuilder &
-  setDurationMatrix(const std::vector<std::vector<int64_t>> matrix) {
-    _routing._duration_matrix = matrix;
-    return *this;
-  }
-  RoutingBuilder &
-  setDepotConfig(const std::variant<SingleDepot, startEndPair> depot) {
-    _routing._depot_config = depot;
-    return *this;
-  }
-  RoutingBuilder &setNumVehicles(const int32_t num_vehicles) {
+  RoutingBuilder(RoutingBuilder &&) noexcept = default;
+  RoutingBuilder &operator=(RoutingBuilder &&) noexcept = default;
+
+  RoutingBuilder &&setDurationMatrix(DurationMatrix matrix) && {
+    _routing._duration_matrix = std::move(matrix);
+    return std::move(*this);
+  }
+  RoutingBuilder &&
+  setDurationMatrix(const std::vector<std::vector<int64_t>> &matrix) &&;
+  RoutingBuilder &&
+  setDepotConfig(std::variant<SingleDepot, startEndPair> depot) && {
+    _routing._depot_config = std::move(depot);
+    return std::move(*this);
+  }
+  RoutingBuilder &&setNumVehicles(const int32_t num_vehicles) && {
     _routing._num_vehicles = num_vehicles;
-    return *this;
+    return std::move(*this);
   }
 
-  RoutingBuilder &setTimeLimit(const int64_t time_limit) {
+  RoutingBuilder &&setTimeLimit(const std::optional<int64_t> time_limit) && {
     _routing._time_limit = time_limit;
-    return *this;
+    return std::move(*this);
   }
-  RoutingBuilder &
-  withCapacity(const std::optional<RoutingOptionWithCapacity> with_capacity) {
-    _routing._with_capacity = with_capacity;
-    return *this;
+  RoutingBuilder &&
+  withCapacity(std::optional<RoutingOptionWithCapacity> with_capacity) && {
+    _routing._with_capacity = std::move(with_capacity);
+    return std::move(*this);
   }
 
-  RoutingBuilder &
-  withPickupDelivery(const std::optional<RoutingOptionWithPickupDelivery>
-                         with_pickup_delivery) {
-    _routing._with_pickup_delivery = with_pickup_delivery;
-    return *this;
+  RoutingBuilder &&withPickupDelivery(
+      std::optional<RoutingOptionWithPickupDelivery> with_pickup_delivery) && {
+    _routing._with_pickup_delivery = std::move(with_pickup_delivery);
+    return std::move(*this);
+  }
+  RoutingBuilder &&withTimeWindow(
+      std::optional<RoutingOptionWithTimeWindow> with_time_window) && {
+    _routing._with_time_window = std::move(with_time_window);
+    return std::move(*this);
+  }
+  RoutingBuilder &&withServiceTime(
+      std::optional<RoutingOptionWithServiceTime> with_service_time) && {
+    _routing._with_service_time = std::move(with_service_time);
+    return std::move(*this);
+  }
+  RoutingBuilder &&withDropPenalties(
+      std::optional<RoutingOptionWithPenalties> with_drop_penalties) && {
+    _routing._with_drop_penalties = std::move(with_drop_penalties);
+    return std::move(*this);
+  }
+  RoutingBuilder &&
+  withVehicleBreakTime(std::optional<RoutingOptionWithVehicleBreakTime>
+                           with_vehicle_break_time) && {
+    _routing._with_vehicle_break_time = std::move(with_vehicle_break_time);
+    return std::move(*this);
+  }
+  RoutingBuilder &&
+  withPortfolio(std::optional<RoutingOptionWithPortfolio> with_portfolio) && {
+    _routing._with_portfolio = std::move(with_portfolio);
+    return std::move(*this);
+  }
+  RoutingBuilder &&
+  withSearchOptions(std::optional<SearchOptions> search_options) && {
+    _routing._search_options =
+        std::move(search_options).value_or(SearchOptions{});
+    return std::move(*this);
   }
-  RoutingBuilder &withTimeWindow(
-      const std::optional<RoutingOptionWithTimeWindow> with_time_window) {
-    _routing._with_time_window = with_time_window;
-    return *this;
+  RoutingBuilder &&withInitialRoutes(
+      std::optional<RoutingOptionWithInitialRoutes> with_initial_routes) && {
+    _routing._with_initial_routes = std::move(with_initial_routes);
+    return std::move(*this);
   }
-  RoutingBuilder &withServiceTime(
-      const std::optional<RoutingOptionWithServiceTime> with_service_time) {
-    _routing._with_service_time = with_service_time;
-    return *this;
+  RoutingBuilder &&withLockedRoutes(
+      std::optional<RoutingOptionWithLockedRoutes> with_locked_routes) && {
+    _routing._with_locked_routes = std::move(with_locked_routes);
+    return std::move(*this);
   }
-  RoutingBuilder &withDropPenalties(
-      const std::optional<RoutingOptionWithPenalties> with_drop_penalties) {
-    _routing._with_drop_penalties = with_drop_penalties;
-    return *this;
+  RoutingBuilder &&withCancelledOrders(
+      std::optional<RoutingOptionWithCancelledOrders>
+          with_cancelled_orders) && {
+    _routing._with_cancelled_orders = std::move(with_cancelled_orders);
+    return std::move(*this);
   }
-  RoutingBuilder &
-  withVehicleBreakTime(const std::optional<RoutingOptionWithVehicleBreakTime>
-                           with_vehicle_break_time) {
-    _routing._with_vehicle_break_time = with_vehicle_break_time;
-    return *this;
+  RoutingBuilder &&withUnavailableVehicles(
+      std::optional<RoutingOptionWithUnavailableVehicles>
+          with_unavailable_vehicles) && {
+    _routing._with_unavailable_vehicles = std::move(with_unavailable_vehicles);
+    return std::move(*this);
   }
 
-  Routing build() const;
+  // validates, then hands over the configuration without copying it
+  Routing build() &&;
 };
 
 } // namespace OrtoolsLib
@@ -0,0 +1,668 @@
+#include "routingInstance.h"
+#include "transitMatrix.h"
+
+#include <ortools/constraint_solver/constraint_solver.h>
+#include <ortools/constraint_solver/routing.h>
+#include <ortools/constraint_solver/routing_index_manager.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+const std::string kTimeDimension = "Time";
+
+void addTimeWindow(operations_research::IntVar *const time_dimension,
+                   std::vector<TimeWindow> time_window) {
+  if (!time_dimension) {
+    return;
+  }
+  std::sort(time_window.begin(), time_window.end());
+  if (const auto tw_idx = std::find(time_window.begin(), time_window.end(),
+                                    TimeWindow{0, INT64_MAX});
+      tw_idx != time_window.end()) {
+    time_window.erase(tw_idx);
+  }
+
+  if (time_window.empty()) {
+    return;
+  }
+
+  auto earliest_start = time_window[0].start;
+  auto latest_end = time_window[time_window.size() - 1].end;
+
+  time_dimension->SetRange(earliest_start, latest_end);
+  for (int i = 0; i < time_window.size() - 1; ++i) {
+    auto curr_end = time_window[i].end;
+    auto next_start = time_window[i + 1].start;
+
+    if (curr_end < next_start) {
+      time_dimension->RemoveInterval(curr_end, next_start);
+    }
+  }
+}
+} // namespace
+
+RoutingInstance::RoutingInstance(const Routing &routing,
+                                 SharedTransitMatrix *transit)
+    : _routing(routing) {
+  _resolveNodes();
+  _resolveCancelledOrders();
+  _model = std::make_unique<operations_research::RoutingModel>(*_manager);
+
+  _addTimeDimension(transit);
+  _addCapacity();
+  _addPickupDelivery();
+  _addTimeWindows();
+  _addVehicleBreakTime();
+  _addDropPenalties();
+  _addCancelledOrders();
+  _addUnavailableVehicles();
+
+  for (int i = 0; i < _routing._num_vehicles; ++i) {
+    _model->AddVariableMinimizedByFinalizer(
+        _time_dimension->CumulVar(_model->Start(i)));
+    _model->AddVariableMinimizedByFinalizer(
+        _time_dimension->CumulVar(_model->End(i)));
+  }
+}
+
+void RoutingInstance::_resolveNodes() {
+  _nodes = NodeMap(static_cast<int32_t>(_routing._duration_matrix.size()));
+
+  // a node can only be visited once, so every pickup/delivery after the first
+  // one at the same node gets its own duplicate
+  std::unordered_set<int64_t> pick_drop_set;
+  if (_routing._with_pickup_delivery.has_value()) {
+    _pickups_deliveries =
+        _routing._with_pickup_delivery.value().pickups_deliveries;
+    for (auto &pair : _pickups_deliveries) {
+      if (pick_drop_set.count(pair.pickup)) {
+        pair.pickup = _duplicate(pair.pickup);
+      } else {
+        pick_drop_set.insert(pair.pickup);
+      }
+
+      if (pick_drop_set.count(pair.delivery)) {
+        pair.delivery = _duplicate(pair.delivery);
+      } else {
+        pick_drop_set.insert(pair.delivery);
+      }
+    }
+  }
+
+  const int32_t num_vehicles = _routing._num_vehicles;
+  const auto &depot_config = _routing._depot_config;
+  if (const auto *depot = std::get_if<SingleDepot>(&depot_config); depot) {
+    auto m_depot = depot->depot;
+    if (m_depot == -1) {
+      m_depot = _nodes.addVirtual();
+    }
+
+    if (pick_drop_set.count(m_depot)) {
+      m_depot = _duplicate(m_depot);
+    }
+
+    _manager = std::make_unique<operations_research::RoutingIndexManager>(
+        _nodes.size(), num_vehicles,
+        operations_research::RoutingNodeIndex{m_depot});
+  } else if (const auto *start_end = std::get_if<startEndPair>(&depot_config);
+             start_end) {
+    std::vector<operations_research::RoutingNodeIndex> m_start_nodes(
+        start_end->starts.begin(), start_end->starts.end());
+    std::vector<operations_research::RoutingNodeIndex> m_end_nodes(
+        start_end->ends.begin(), start_end->ends.end());
+
+    if (find(m_start_nodes.begin(), m_start_nodes.end(), -1) !=
+            m_start_nodes.end() ||
+        find(m_end_nodes.begin(), m_end_nodes.end(), -1) != m_end_nodes.end()) {
+      const int32_t dummy = _nodes.addVirtual();
+      for (auto &start : m_start_nodes) {
+        if (start == -1) {
+          start = dummy;
+        }
+      }
+      for (auto &end : m_end_nodes) {
+        if (end == -1) {
+          end = dummy;
+        }
+      }
+    }
+
+    for (auto &start : m_start_nodes) {
+      if (pick_drop_set.count(start.value())) {
+        start = _duplicate(start.value());
+      }
+    }
+
+    for (auto &end : m_end_nodes) {
+      if (pick_drop_set.count(end.value())) {
+        end = _duplicate(end.value());
+      }
+    }
+
+    _manager = std::make_unique<operations_research::RoutingIndexManager>(
+        _nodes.size(), num_vehicles, m_start_nodes, m_end_nodes);
+  } else {
+    throw InvalidConfiguration("Invalid depot configuration");
+  }
+}
+
+int32_t RoutingInstance::_duplicate(int32_t node) {
+  if (_routing._with_capacity.has_value()) {
+    _duplicated_demand +=
+        _routing._with_capacity.value().demands[_nodes.physical(node)];
+  }
+
+  return _nodes.addDuplicate(node);
+}
+
+void RoutingInstance::_addTimeDimension(SharedTransitMatrix *transit) {
+  // Arc cost and the "Time" dimension share one precombined index-space
+  // matrix, so the evaluator is a plain array read.
+  const auto build = [this]() {
+    return buildTransitMatrix(
+        _routing._duration_matrix,
+        _routing._with_service_time.has_value()
+            ? &_routing._with_service_time.value().service_time
+            : nullptr,
+        _nodes, *_manager);
+  };
+  const int transit_callback_index = registerTransitMatrix(
+      *_model, transit ? transit->get(build)
+                       : std::make_shared<const DurationMatrix>(build()));
+
+  // Define cost of each arc.
+  _model->SetArcCostEvaluatorOfAllVehicles(transit_callback_index);
+
+  int64_t time_capacity = INT64_MAX;
+  if (_routing._with_time_window.has_value()) {
+    const auto &twss = _routing._with_time_window.value().time_windows;
+    int64_t mx = 0;
+
+    for (const auto &tws : twss) {
+      for (const auto &tw : tws) {
+        if (tw.start == 0 && tw.end == INT64_MAX) {
+          continue;
+        }
+
+        mx = std::max(mx, tw.start);
+        mx = std::max(mx, tw.end);
+      }
+    }
+    if (mx > 0) {
+      time_capacity = mx;
+    }
+  }
+
+  int64_t slack_time = 0;
+  if (_routing._with_vehicle_break_time.has_value()) {
+    int64_t mx = 0;
+    const auto &break_times =
+        _routing._with_vehicle_break_time.value().break_time;
+    for (const auto &break_time : break_times) {
+      for (const auto &bt : break_time) {
+        mx = std::max(mx, bt.end - bt.start);
+      }
+    }
+
+    slack_time = mx;
+  }
+  _model->AddDimension(transit_callback_index, slack_time, time_capacity,
+                       !_routing._with_time_window.has_value(),
+                       kTimeDimension);
+
+  _time_dimension = _model->GetMutableDimension(kTimeDimension);
+}
+
+void RoutingInstance::_addCapacity() {
+  if (!_routing._with_capacity.has_value()) {
+    return;
+  }
+
+  const auto &demands = _routing._with_capacity.value().demands;
+  std::vector<int64_t> index_demands(_manager->num_indices(), 0);
+  for (int index = 0; index < _manager->num_indices(); ++index) {
+    const int32_t node = _manager->IndexToNode(index).value();
+    if (!_nodes.isVirtual(node)) {
+      index_demands[index] = demands[_nodes.physical(node)];
+    }
+  }
+  const int demand_callback_index =
+      registerUnaryTransitVector(*_model, std::move(index_demands));
+
+  std::vector<int64_t> capacities = _routing._with_capacity.value().capacities;
+  for (auto &capacity : capacities) {
+    capacity += _duplicated_demand;
+  }
+
+  _model->AddDimensionWithVehicleCapacity(
+      demand_callback_index, // transit callback index
+      int64_t{0},            // null capacity slack
+      capacities,            // vehicle maximum capacities
+      true,                  // start cumul to zero
+      "Capacity");
+}
+
+void RoutingInstance::_addPickupDelivery() {
+  if (!_routing._with_pickup_delivery.has_value()) {
+    return;
+  }
+
+  const auto &pd_policy = _routing._with_pickup_delivery.value().policy;
+
+  operations_research::Solver *const solver = _model->solver();
+  for (const PickupDelivery &pair : _pickups_deliveries) {
+    const int64_t pickup_index = _manager->NodeToIndex(
+        operations_research::RoutingIndexManager::NodeIndex(pair.pickup));
+    const int64_t delivery_index = _manager->NodeToIndex(
+        operations_research::RoutingIndexManager::NodeIndex(pair.delivery));
+    _model->AddPickupAndDelivery(pickup_index, delivery_index);
+    solver->AddConstraint(
+        solver->MakeEquality(static_cast<operations_research::IntVar *>(
+                                 _model->VehicleVar(pickup_index)),
+                             static_cast<operations_research::IntVar *>(
+                                 _model->VehicleVar(delivery_index))));
+    solver->AddConstraint(
+        solver->MakeLessOrEqual(_time_dimension->CumulVar(pickup_index),
+                                _time_dimension->CumulVar(delivery_index)));
+  }
+
+  if (pd_policy.has_value()) {
+    switch (pd_policy.value()) {
+    case PickupDropOption::FIFO:
+      _model->SetPickupAndDeliveryPolicyOfAllVehicles(
+          operations_research::RoutingModel::PICKUP_AND_DELIVERY_FIFO);
+      break;
+    case PickupDropOption::LIFO:
+      _model->SetPickupAndDeliveryPolicyOfAllVehicles(
+          operations_research::RoutingModel::PICKUP_AND_DELIVERY_LIFO);
+      break;
+    default:
+      throw InvalidConfiguration("Invalid pickup and delivery policy");
+    }
+  }
+}
+
+void RoutingInstance::_addTimeWindows() {
+  if (!_routing._with_time_window.has_value()) {
+    return;
+  }
+
+  const auto &time_windows = _routing._with_time_window.value().time_windows;
+  for (int32_t i = 0; i < _nodes.size(); ++i) {
+    if (_nodes.isVirtual(i) || _isConfiguredDepot(i)) {
+      continue;
+    }
+
+    addTimeWindow(_time_dimension->CumulVar(_manager->NodeToIndex(
+                      operations_research::RoutingIndexManager::NodeIndex(i))),
+                  time_windows[_nodes.physical(i)]);
+  }
+
+  const auto &depot_config = _routing._depot_config;
+  const SingleDepot *depot = std::get_if<SingleDepot>(&depot_config);
+  const startEndPair *start_end = std::get_if<startEndPair>(&depot_config);
+  for (int i = 0; i < _routing._num_vehicles; ++i) {
+    const int64_t route_start_idx = _model->Start(i);
+    const int64_t route_end_idx = _model->End(i);
+    if (depot && depot->depot != -1) {
+      addTimeWindow(_time_dimension->CumulVar(route_start_idx),
+                    time_windows[depot->depot]);
+    }
+
+    if (start_end) {
+      auto start_idx = start_end->starts[i];
+      if (start_idx != -1)
+        addTimeWindow(_time_dimension->CumulVar(route_start_idx),
+                      time_windows[start_idx]);
+
+      auto end_idx = start_end->ends[i];
+      if (end_idx != -1)
+        addTimeWindow(_time_dimension->CumulVar(route_end_idx),
+                      time_windows[end_idx]);
+    }
+  }
+}
+
+void RoutingInstance::_addVehicleBreakTime() {
+  if (!_routing._with_vehicle_break_time.has_value()) {
+    return;
+  }
+
+  operations_research::Solver *const solver = _model->solver();
+  std::vector<int64_t> node_visit_transit(_nodes.size(), 0);
+
+  if (_routing._with_service_time.has_value()) {
+    const auto &service_time = _routing._with_service_time.value().service_time;
+    for (int32_t i = 0; i < _nodes.size(); ++i) {
+      if (!_nodes.isVirtual(i)) {
+        node_visit_transit[i] = service_time[_nodes.physical(i)];
+      }
+    }
+  }
+
+  std::vector<std::vector<TimeWindow>> break_time =
+      _routing._with_vehicle_break_time.value().break_time;
+  for (int i = 0; i < break_time.size(); ++i) {
+    std::sort(break_time[i].begin(), break_time[i].end());
+
+    std::vector<operations_research::IntervalVar *> break_intervals;
+    for (int j = 0; j < break_time[i].size(); ++j) {
+      const auto new_var =
+          solver
+              ->MakeSum(_time_dimension->CumulVar(_model->Start(i)),
+                        break_time[i][j].start)
+              ->Var();
+      break_intervals.emplace_back(solver->MakeFixedDurationIntervalVar(
+          new_var, break_time[i][j].end - break_time[i][j].start,
+          "break time on vehicle " + std::to_string(i) + "on i" +
+              std::to_string(j)));
+    }
+
+    _time_dimension->SetBreakIntervalsOfVehicle(break_intervals, i,
+                                                node_visit_transit);
+  }
+}
+
+void RoutingInstance::_resolveCancelledOrders() {
+  if (!_routing._with_cancelled_orders.has_value()) {
+    return;
+  }
+
+  const auto &nodes = _routing._with_cancelled_orders.value().nodes;
+  const std::unordered_set<int32_t> cancelled(nodes.begin(), nodes.end());
+  for (int32_t i = 0; i < _nodes.size(); ++i) {
+    if (!_nodes.isVirtual(i) && cancelled.count(_nodes.physical(i))) {
+      _cancelled.insert(i);
+    }
+  }
+
+  // a pickup without its delivery (or the reverse) cannot be performed
+  for (const auto &pair : _pickups_deliveries) {
+    if (_cancelled.count(pair.pickup) || _cancelled.count(pair.delivery)) {
+      _cancelled.insert(static_cast<int32_t>(pair.pickup));
+      _cancelled.insert(static_cast<int32_t>(pair.delivery));
+    }
+  }
+}
+
+void RoutingInstance::_addDropPenalties() {
+  if (!_routing._with_drop_penalties.has_value()) {
+    return;
+  }
+
+  const auto &m_penalties_var = _routing._with_drop_penalties.value().penalties;
+  const auto *m_global_penalties = std::get_if<int64_t>(&m_penalties_var);
+  const auto *m_penalties = std::get_if<std::vector<int64_t>>(&m_penalties_var);
+
+  for (int32_t i = 0; i < _nodes.size(); ++i) {
+    if (_nodes.isVirtual(i) ||
+        _routing._duration_matrix.isZeroRow(_nodes.physical(i)) ||
+        _isConfiguredDepot(i) || _cancelled.count(i)) {
+      continue;
+    }
+
+    const int64_t penalty = m_global_penalties
+                                ? *m_global_penalties
+                                : m_penalties->at(_nodes.physical(i));
+    _model->AddDisjunction(
+        {_manager->NodeToIndex(
+            operations_research::RoutingIndexManager::NodeIndex(i))},
+        penalty);
+  }
+}
+
+void RoutingInstance::_addCancelledOrders() {
+  for (const int32_t node : _cancelled) {
+    const int64_t index = _manager->NodeToIndex(
+        operations_research::RoutingIndexManager::NodeIndex(node));
+    // only a node in a disjunction may be inactive
+    _model->AddDisjunction({index}, 0);
+    _model->ActiveVar(index)->SetValue(0);
+  }
+}
+
+void RoutingInstance::_addUnavailableVehicles() {
+  if (!_routing._with_unavailable_vehicles.has_value()) {
+    return;
+  }
+
+  for (const int32_t vehicle :
+       _routing._with_unavailable_vehicles.value().vehicles) {
+    _model->NextVar(_model->Start(vehicle))->SetValue(_model->End(vehicle));
+  }
+}
+
+bool RoutingInstance::_isConfiguredDepot(int32_t node) const {
+  const auto &depot_config = _routing._depot_config;
+  if (const auto *depot = std::get_if<SingleDepot>(&depot_config); depot) {
+    return depot->depot == node;
+  }
+
+  if (const auto *start_end = std::get_if<startEndPair>(&depot_config);
+      start_end) {
+    const std::vector<int> &starts = start_end->starts;
+    const std::vector<int> &ends = start_end->ends;
+    return std::find(starts.begin(), starts.end(), node) != starts.end() ||
+           std::find(ends.begin(), ends.end(), node) != ends.end();
+  }
+
+  return false;
+}
+
+int RoutingInstance::_requestNode(int64_t index) const {
+  const int32_t node = _manager->IndexToNode(index).value();
+  // virtual nodes keep their logical id, they are stripped from the route
+  return _nodes.isVirtual(node) ? node : _nodes.physical(node);
+}
+
+std::vector<RoutingResponse> RoutingInstance::responses(
+    const operations_research::Assignment &solution) const {
+  return _responses(
+      [this, &solution](int64_t index) {
+        return solution.Value(_model->NextVar(index));
+      },
+      [this, &solution](int64_t index) {
+        return solution.Min(_time_dimension->CumulVar(index));
+      });
+}
+
+std::vector<RoutingResponse> RoutingInstance::currentResponses() const {
+  return _responses(
+      [this](int64_t index) { return _model->NextVar(index)->Value(); },
+      [this](int64_t index) {
+        return _time_dimension->CumulVar(index)->Min();
+      });
+}
+
+void RoutingInstance::attach(const SolveContext &context) {
+  if (context.solutions) {
+    SolutionStream &stream = *context.solutions;
+    _model->AddAtSolutionCallback([this, &stream]() {
+      stream.offer(_model->CostVar()->Value(),
+                   [this]() { return currentResponses(); });
+    });
+  }
+
+  if (context.cancellation) {
+    const CancellationToken &token = *context.cancellation;
+    _model->AddSearchMonitor(_model->solver()->MakeCustomLimit(
+        [&token]() { return token.cancelled(); }));
+  }
+}
+
+void RoutingInstance::attach(EarlyStop &early_stop) {
+  if (!early_stop.enabled()) {
+    return;
+  }
+
+  _model->AddAtSolutionCallback([this, &early_stop]() {
+    early_stop.observe(_model->CostVar()->Value());
+  });
+  _model->AddSearchMonitor(_model->solver()->MakeCustomLimit(
+      [&early_stop]() { return early_stop.reached(); }));
+}
+
+std::vector<RoutingResponse> RoutingInstance::_responses(
+    const std::function<int64_t(int64_t)> &next_of,
+    const std::function<int64_t(int64_t)> &arrival_of) const {
+  const auto &depot_config = _routing._depot_config;
+  const SingleDepot *depot = std::get_if<SingleDepot>(&depot_config);
+  const startEndPair *start_end = std::get_if<startEndPair>(&depot_config);
+
+  std::vector<RoutingResponse> responses(_routing._num_vehicles);
+  for (int vehicle_id = 0; vehicle_id < _routing._num_vehicles; ++vehicle_id) {
+    if (_model->IsEnd(next_of(_model->Start(vehicle_id)))) {
+      continue;
+    }
+    std::vector<int> route;
+    int64_t index = _model->Start(vehicle_id);
+    while (!_model->IsEnd(index)) {
+      route.push_back(_requestNode(index));
+      index = next_of(index);
+    }
+    route.push_back(_requestNode(index));
+
+    if (depot && depot->depot == -1) {
+      route.pop_back();
+      route.erase(route.begin());
+    }
+
+    if (start_end) {
+      if (start_end->starts.at(vehicle_id) == -1)
+        route.erase(route.begin());
+
+      if (start_end->ends.at(vehicle_id) == -1)
+        route.pop_back();
+    }
+
+    responses[vehicle_id] = RoutingResponse{
+        .route = route,
+        .total_duration = arrival_of(index),
+    };
+  }
+
+  return responses;
+}
+
+std::vector<std::vector<int64_t>> RoutingInstance::currentRoutes() const {
+  std::vector<std::vector<int64_t>> routes(_model->vehicles());
+  for (int vehicle_id = 0; vehicle_id < _model->vehicles(); ++vehicle_id) {
+    int64_t index = _model->NextVar(_model->Start(vehicle_id))->Value();
+    while (!_model->IsEnd(index)) {
+      routes[vehicle_id].push_back(index);
+      index = _model->NextVar(index)->Value();
+    }
+  }
+
+  return routes;
+}
+
+std::vector<std::vector<int64_t>> RoutingInstance::routeIndices(
+    const std::vector<std::vector<int32_t>> &routes) const {
+  // every index a request node can be visited at, nodes duplicated for
+  // several pickups/deliveries own more than one
+  std::unordered_map<int32_t, std::deque<int64_t>> candidates;
+  for (int64_t index = 0; index < _model->Size(); ++index) {
+    if (_model->IsStart(index) ||
+        _nodes.isVirtual(_manager->IndexToNode(index).value())) {
+      continue;
+    }
+    candidates[_requestNode(index)].push_back(index);
+  }
+
+  const auto &depot_config = _routing._depot_config;
+  const SingleDepot *depot = std::get_if<SingleDepot>(&depot_config);
+  const startEndPair *start_end = std::get_if<startEndPair>(&depot_config);
+
+  std::vector<std::vector<int64_t>> indices(_model->vehicles());
+  for (size_t vehicle_id = 0;
+       vehicle_id < routes.size() && vehicle_id < indices.size();
+       ++vehicle_id) {
+    const int32_t start =
+        depot ? depot->depot : start_end->starts.at(vehicle_id);
+    const int32_t end = depot ? depot->depot : start_end->ends.at(vehicle_id);
+
+    auto first = routes[vehicle_id].begin();
+    auto last = routes[vehicle_id].end();
+    if (first != last && start != -1 && *first == start) {
+      ++first;
+    }
+    if (first != last && end != -1 && *(last - 1) == end) {
+      --last;
+    }
+
+    for (; first != last; ++first) {
+      auto candidate = candidates.find(*first);
+      if (candidate == candidates.end() || candidate->second.empty()) {
+        continue;
+      }
+      indices[vehicle_id].push_back(candidate->second.front());
+      candidate->second.pop_front();
+    }
+  }
+
+  return indices;
+}
+
+std::optional<RoutingSolution> RoutingInstance::solve(
+    const operations_research::RoutingSearchParameters &parameters) {
+  if (_routing._with_initial_routes.has_value()) {
+    return solveFrom(routeIndices(_routing._with_initial_routes->routes),
+                     parameters);
+  }
+
+  _model->CloseModelWithParameters(parameters);
+  _applyLocks();
+  return _solution(_model->SolveWithParameters(parameters));
+}
+
+std::optional<RoutingSolution> RoutingInstance::solveFrom(
+    const std::vector<std::vector<int64_t>> &routes,
+    const operations_research::RoutingSearchParameters &parameters) {
+  _model->CloseModelWithParameters(parameters);
+  _applyLocks();
+  const operations_research::Assignment *initial =
+      _model->ReadAssignmentFromRoutes(routes, true);
+  if (!initial) {
+    return _solution(_model->SolveWithParameters(parameters));
+  }
+
+  return _solution(
+      _model->SolveFromAssignmentWithParameters(initial, parameters));
+}
+
+void RoutingInstance::_applyLocks() {
+  if (!_routing._with_locked_routes.has_value()) {
+    return;
+  }
+
+  // the prefixes become part of every solution, so the search only has the
+  // unlocked nodes left to place
+  if (!_model->ApplyLocksToAllVehicles(
+          routeIndices(_routing._with_locked_routes->routes), false)) {
+    throw InvalidConfiguration("lockedRoutes", "infeasible");
+  }
+}
+
+std::optional<RoutingSolution> RoutingInstance::_solution(
+    const operations_research::Assignment *assignment) const {
+  if (!assignment) {
+    return std::nullopt;
+  }
+
+  return RoutingSolution{
+      .responses = responses(*assignment),
+      .objective = assignment->ObjectiveValue(),
+  };
+}
+} // namespace OrtoolsLib
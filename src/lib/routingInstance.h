@@ -0,0 +1,123 @@
+#ifndef ROUTING_INSTANCE_H
+#define ROUTING_INSTANCE_H
+
+#include <ortools/constraint_solver/constraint_solver.h>
+#include <ortools/constraint_solver/routing.h>
+#include <ortools/constraint_solver/routing_index_manager.h>
+#include <ortools/constraint_solver/routing_parameters.h>
+
+#include "earlyStop.h"
+#include "nodeMap.h"
+#include "routing.h"
+#include "solveContext.h"
+#include "transitMatrix.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+namespace OrtoolsLib {
+struct RoutingSolution {
+  std::vector<RoutingResponse> responses;
+  int64_t objective;
+};
+
+// OR-tools model built from a Routing configuration. Construction only reads
+// the configuration, so several instances can be built from (and solved
+// against) the same Routing concurrently; those given the same `transit`
+// share one transit matrix.
+class RoutingInstance {
+public:
+  explicit RoutingInstance(const Routing &routing,
+                           SharedTransitMatrix *transit = nullptr);
+  RoutingInstance(const RoutingInstance &) = delete;
+  RoutingInstance &operator=(const RoutingInstance &) = delete;
+
+  operations_research::RoutingModel &model() const { return *_model; }
+  const operations_research::RoutingIndexManager &manager() const {
+    return *_manager;
+  }
+  operations_research::RoutingDimension &timeDimension() const {
+    return *_time_dimension;
+  }
+  const NodeMap &nodes() const { return _nodes; }
+
+  // per-vehicle routes of `solution`, in the node ids of the request
+  std::vector<RoutingResponse>
+  responses(const operations_research::Assignment &solution) const;
+
+  // responses() of the solution the search currently sits on; only
+  // meaningful from a solution callback
+  std::vector<RoutingResponse> currentResponses() const;
+
+  // routes of the solution the search currently sits on, in the form
+  // ReadAssignmentFromRoutes expects; only meaningful from a solution callback
+  std::vector<std::vector<int64_t>> currentRoutes() const;
+
+  // offers every solution the search finds to `context.solutions` and stops
+  // the search once `context.cancellation` fires; both must outlive the
+  // solves of this instance
+  void attach(const SolveContext &context);
+  // feeds every solution to `early_stop` and stops the search once it is
+  // reached; a no-op when it has no criterion. `early_stop` must outlive the
+  // solves of this instance
+  void attach(EarlyStop &early_stop);
+
+  // variable indices visiting the request nodes of `routes`, each vehicle's
+  // start and end excluded; nodes the model cannot place are dropped
+  std::vector<std::vector<int64_t>>
+  routeIndices(const std::vector<std::vector<int32_t>> &routes) const;
+
+  // runs the search once, std::nullopt when no solution was found. Seeded
+  // from the configured initial routes, if any. Both solves keep the
+  // configured locked routes.
+  std::optional<RoutingSolution>
+  solve(const operations_research::RoutingSearchParameters &parameters);
+  // runs the search from `routes` (see currentRoutes()), or from scratch when
+  // they do not form a feasible assignment of this model
+  std::optional<RoutingSolution>
+  solveFrom(const std::vector<std::vector<int64_t>> &routes,
+            const operations_research::RoutingSearchParameters &parameters);
+
+private:
+  void _resolveNodes();
+  void _resolveCancelledOrders();
+  int32_t _duplicate(int32_t node);
+  void _addTimeDimension(SharedTransitMatrix *transit);
+  void _addCapacity();
+  void _addPickupDelivery();
+  void _addTimeWindows();
+  void _addVehicleBreakTime();
+  void _addDropPenalties();
+  void _addCancelledOrders();
+  void _addUnavailableVehicles();
+  // after the model is closed, pins the configured locked routes
+  void _applyLocks();
+  bool _isConfiguredDepot(int32_t node) const;
+  int _requestNode(int64_t index) const;
+  // per-vehicle responses given the successor and earliest arrival of every
+  // variable index
+  std::vector<RoutingResponse>
+  _responses(const std::function<int64_t(int64_t)> &next_of,
+             const std::function<int64_t(int64_t)> &arrival_of) const;
+  std::optional<RoutingSolution>
+  _solution(const operations_research::Assignment *assignment) const;
+
+  const Routing &_routing;
+  NodeMap _nodes;
+  std::vector<PickupDelivery> _pickups_deliveries;
+  // demand of each duplicated node, added on top of every vehicle capacity
+  int64_t _duplicated_demand = 0;
+  // logical nodes of cancelled orders, pickup/delivery partners included
+  std::unordered_set<int32_t> _cancelled;
+
+  std::unique_ptr<operations_research::RoutingIndexManager> _manager;
+  std::unique_ptr<operations_research::RoutingModel> _model;
+  operations_research::RoutingDimension *_time_dimension = nullptr;
+};
+} // namespace OrtoolsLib
+
+#endif // ROUTING_INSTANCE_H
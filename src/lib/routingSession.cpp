@@ -0,0 +1,332 @@
+#include "routingSession.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+const TimeWindow kUnconstrained{0, INT64_MAX};
+
+void validateTimeWindows(const std::string &key,
+                         const std::vector<TimeWindow> &time_windows) {
+  for (const auto &tw : time_windows) {
+    if (tw.start < 0 || tw.end < 0) {
+      throw InvalidConfiguration(key, "start or end is negative");
+    }
+    if (tw.start > tw.end) {
+      throw InvalidConfiguration(key, "start is greater than end");
+    }
+  }
+}
+
+std::vector<TimeWindow> orUnconstrained(std::vector<TimeWindow> time_windows) {
+  if (time_windows.empty()) {
+    time_windows.push_back(kUnconstrained);
+  }
+  return time_windows;
+}
+} // namespace
+
+RoutingSession::RoutingSession(Routing routing)
+    : _routing(std::move(routing)), _visits(_routing._num_vehicles),
+      _node_count(_routing._duration_matrix.size()) {
+  if (_routing._with_initial_routes.has_value()) {
+    const auto &routes = _routing._with_initial_routes->routes;
+    for (int32_t vehicle = 0; vehicle < routes.size(); ++vehicle) {
+      const auto [start, end] = _endpoints(vehicle);
+      for (const auto node : routes[vehicle]) {
+        if (node != start && node != end) {
+          _visits[vehicle].push_back(node);
+        }
+      }
+    }
+  }
+}
+
+void RoutingSession::apply(const SessionDelta &delta) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::visit([this](const auto &d) { _apply(d); }, delta);
+}
+
+std::vector<RoutingResponse> RoutingSession::solve() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _solve();
+}
+
+std::vector<RoutingResponse> RoutingSession::update(const SessionDelta &delta) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::visit([this](const auto &d) { _apply(d); }, delta);
+  return _solve();
+}
+
+std::vector<RoutingResponse> RoutingSession::lastSolution() const {
+  std::lock_guard<std::mutex> lock(_last_mutex);
+  return _last_solution;
+}
+
+size_t RoutingSession::nodeCount() const { return _node_count; }
+
+size_t RoutingSession::bytes() const {
+  const size_t node_count = _node_count;
+  // the matrix, plus per-node options and visits
+  return sizeof(RoutingSession) + node_count * node_count * sizeof(int64_t) +
+         node_count * 8 * sizeof(int64_t);
+}
+
+std::vector<RoutingResponse> RoutingSession::_solve() {
+  _routing._with_initial_routes = RoutingOptionWithInitialRoutes{
+      .routes = _visits,
+  };
+  auto responses = _routing.solve();
+
+  _visits.assign(_routing._num_vehicles, {});
+  for (int32_t vehicle = 0; vehicle < responses.size(); ++vehicle) {
+    const auto &route = responses[vehicle].route;
+    auto first = route.begin();
+    auto last = route.end();
+    const auto [start, end] = _endpoints(vehicle);
+    if (first != last && start != -1 && *first == start) {
+      ++first;
+    }
+    if (first != last && end != -1 && *(last - 1) == end) {
+      --last;
+    }
+    _visits[vehicle].assign(first, last);
+  }
+
+  std::lock_guard<std::mutex> lock(_last_mutex);
+  _last_solution = responses;
+  return responses;
+}
+
+void RoutingSession::_apply(const AddOrder &delta) {
+  const size_t node_count = _routing._duration_matrix.size();
+  if (delta.durations_to.size() != node_count) {
+    throw InvalidConfiguration("addOrder.durationsTo",
+                               "size is not equal to nodeCount");
+  }
+  if (delta.durations_from.size() != node_count) {
+    throw InvalidConfiguration("addOrder.durationsFrom",
+                               "size is not equal to nodeCount");
+  }
+  const auto outOfRange = [](int64_t duration) {
+    return duration < -Routing::kMaxDuration ||
+           duration > Routing::kMaxDuration;
+  };
+  if (std::any_of(delta.durations_to.begin(), delta.durations_to.end(),
+                  outOfRange)) {
+    throw InvalidConfiguration("addOrder.durationsTo", "out of range");
+  }
+  if (std::any_of(delta.durations_from.begin(), delta.durations_from.end(),
+                  outOfRange)) {
+    throw InvalidConfiguration("addOrder.durationsFrom", "out of range");
+  }
+  if (delta.service_time < 0) {
+    throw InvalidConfiguration("addOrder.serviceTime", "negative");
+  }
+  if (delta.service_time > Routing::kMaxDuration) {
+    throw InvalidConfiguration("addOrder.serviceTime", "out of range");
+  }
+  if (delta.demand < 0) {
+    throw InvalidConfiguration("addOrder.demand", "negative");
+  }
+  if (delta.demand > 0 && !_routing._with_capacity.has_value()) {
+    throw InvalidConfiguration("addOrder.demand", "session has no capacity");
+  }
+  validateTimeWindows("addOrder.timeWindows", delta.time_windows);
+
+  std::vector<int64_t> *penalties = nullptr;
+  if (_routing._with_drop_penalties.has_value()) {
+    penalties = std::get_if<std::vector<int64_t>>(
+        &_routing._with_drop_penalties->penalties);
+  }
+  if (penalties && !delta.penalty.has_value()) {
+    throw InvalidConfiguration("addOrder.penalty",
+                               "required by per-node penalties");
+  }
+  if (delta.penalty.has_value() && delta.penalty.value() < 0) {
+    throw InvalidConfiguration("addOrder.penalty", "negative");
+  }
+
+  _routing._duration_matrix.appendNode(delta.durations_to,
+                                       delta.durations_from);
+  _node_count = _routing._duration_matrix.size();
+
+  if (_routing._with_capacity.has_value()) {
+    _routing._with_capacity->demands.push_back(delta.demand);
+  }
+
+  if (_routing._with_service_time.has_value()) {
+    _routing._with_service_time->service_time.push_back(delta.service_time);
+  } else if (delta.service_time > 0) {
+    std::vector<int64_t> service_time(node_count + 1, 0);
+    service_time.back() = delta.service_time;
+    _routing._with_service_time =
+        RoutingOptionWithServiceTime{.service_time = std::move(service_time)};
+  }
+
+  if (_routing._with_time_window.has_value()) {
+    _routing._with_time_window->time_windows.push_back(
+        orUnconstrained(delta.time_windows));
+  } else if (!delta.time_windows.empty()) {
+    std::vector<std::vector<TimeWindow>> time_windows(node_count + 1,
+                                                      {kUnconstrained});
+    time_windows.back() = delta.time_windows;
+    _routing._with_time_window =
+        RoutingOptionWithTimeWindow{.time_windows = std::move(time_windows)};
+  }
+
+  if (penalties) {
+    penalties->push_back(delta.penalty.value());
+  }
+
+  _insertVisit(static_cast<int32_t>(node_count));
+}
+
+void RoutingSession::_apply(const CancelOrder &delta) {
+  if (delta.node < 0 || delta.node >= _routing._duration_matrix.size()) {
+    throw InvalidConfiguration("cancelOrder.node", "out of range");
+  }
+  if (_isDepot(delta.node)) {
+    throw InvalidConfiguration("cancelOrder.node", "node is a depot");
+  }
+
+  if (!_routing._with_cancelled_orders.has_value()) {
+    _routing._with_cancelled_orders = RoutingOptionWithCancelledOrders{};
+  }
+  auto &nodes = _routing._with_cancelled_orders->nodes;
+  if (std::find(nodes.begin(), nodes.end(), delta.node) != nodes.end()) {
+    return;
+  }
+  nodes.push_back(delta.node);
+
+  // RoutingInstance drops the other half of the pair too
+  _removeVisit(delta.node);
+  if (_routing._with_pickup_delivery.has_value()) {
+    for (const auto &pair :
+         _routing._with_pickup_delivery->pickups_deliveries) {
+      if (pair.pickup == delta.node) {
+        _removeVisit(static_cast<int32_t>(pair.delivery));
+      } else if (pair.delivery == delta.node) {
+        _removeVisit(static_cast<int32_t>(pair.pickup));
+      }
+    }
+  }
+}
+
+void RoutingSession::_apply(const ChangeTimeWindow &delta) {
+  const size_t node_count = _routing._duration_matrix.size();
+  if (delta.node < 0 || delta.node >= node_count) {
+    throw InvalidConfiguration("changeTimeWindow.node", "out of range");
+  }
+  validateTimeWindows("changeTimeWindow.timeWindows", delta.time_windows);
+
+  if (!_routing._with_time_window.has_value()) {
+    _routing._with_time_window = RoutingOptionWithTimeWindow{
+        .time_windows = std::vector<std::vector<TimeWindow>>(
+            node_count, {kUnconstrained}),
+    };
+  }
+  // the previous routes may now be late, the solver then starts from scratch
+  _routing._with_time_window->time_windows[delta.node] =
+      orUnconstrained(delta.time_windows);
+}
+
+void RoutingSession::_apply(const VehicleBreakdown &delta) {
+  if (delta.vehicle < 0 || delta.vehicle >= _routing._num_vehicles) {
+    throw InvalidConfiguration("vehicleBreakdown.vehicle", "out of range");
+  }
+  if (!_isAvailable(delta.vehicle)) {
+    return;
+  }
+
+  if (!_routing._with_unavailable_vehicles.has_value()) {
+    _routing._with_unavailable_vehicles =
+        RoutingOptionWithUnavailableVehicles{};
+  }
+  _routing._with_unavailable_vehicles->vehicles.push_back(delta.vehicle);
+
+  const std::vector<int32_t> stranded = std::move(_visits[delta.vehicle]);
+  _visits[delta.vehicle].clear();
+  for (const auto node : stranded) {
+    _insertVisit(node);
+  }
+}
+
+std::pair<int32_t, int32_t> RoutingSession::_endpoints(int32_t vehicle) const {
+  if (const auto *depot = std::get_if<SingleDepot>(&_routing._depot_config)) {
+    return {depot->depot, depot->depot};
+  }
+
+  const auto &start_end = std::get<startEndPair>(_routing._depot_config);
+  return {start_end.starts.at(vehicle), start_end.ends.at(vehicle)};
+}
+
+bool RoutingSession::_isDepot(int32_t node) const {
+  for (int32_t vehicle = 0; vehicle < _routing._num_vehicles; ++vehicle) {
+    const auto [start, end] = _endpoints(vehicle);
+    if (node == start || node == end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool RoutingSession::_isAvailable(int32_t vehicle) const {
+  if (!_routing._with_unavailable_vehicles.has_value()) {
+    return true;
+  }
+  const auto &vehicles = _routing._with_unavailable_vehicles->vehicles;
+  return std::find(vehicles.begin(), vehicles.end(), vehicle) ==
+         vehicles.end();
+}
+
+void RoutingSession::_removeVisit(int32_t node) {
+  for (auto &visits : _visits) {
+    visits.erase(std::remove(visits.begin(), visits.end(), node),
+                 visits.end());
+  }
+}
+
+void RoutingSession::_insertVisit(int32_t node) {
+  const auto &matrix = _routing._duration_matrix;
+  const auto duration = [&matrix](int32_t from, int32_t to) -> int64_t {
+    return from == -1 || to == -1 ? 0 : matrix(from, to);
+  };
+
+  int64_t best_cost = std::numeric_limits<int64_t>::max();
+  std::vector<int32_t> *best_route = nullptr;
+  size_t best_position = 0;
+  for (int32_t vehicle = 0; vehicle < _routing._num_vehicles; ++vehicle) {
+    if (!_isAvailable(vehicle)) {
+      continue;
+    }
+
+    auto &visits = _visits[vehicle];
+    const auto [start, end] = _endpoints(vehicle);
+    for (size_t position = 0; position <= visits.size(); ++position) {
+      const int32_t previous = position == 0 ? start : visits[position - 1];
+      const int32_t next = position == visits.size() ? end : visits[position];
+      const int64_t cost = duration(previous, node) + duration(node, next) -
+                           duration(previous, next);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_route = &visits;
+        best_position = position;
+      }
+    }
+  }
+
+  // with no vehicle left the solver decides whether the node can be dropped
+  if (best_route) {
+    best_route->insert(best_route->begin() + best_position, node);
+  }
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,97 @@
+#ifndef ROUTING_SESSION_H
+#define ROUTING_SESSION_H
+
+#include "routing.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace OrtoolsLib {
+// a new order at node size(); durations have one entry per existing node
+struct AddOrder {
+  std::vector<int64_t> durations_to;
+  std::vector<int64_t> durations_from;
+  int64_t service_time = 0;
+  int64_t demand = 0;
+  // empty leaves the node unconstrained
+  std::vector<TimeWindow> time_windows;
+  // only used when the session has per-node drop penalties
+  std::optional<int64_t> penalty;
+};
+
+struct CancelOrder {
+  int32_t node;
+};
+
+struct ChangeTimeWindow {
+  int32_t node;
+  std::vector<TimeWindow> time_windows;
+};
+
+struct VehicleBreakdown {
+  int32_t vehicle;
+};
+
+using SessionDelta =
+    std::variant<AddOrder, CancelOrder, ChangeTimeWindow, VehicleBreakdown>;
+
+// A Routing kept on the server between requests. Deltas edit the stored
+// configuration in place, so the duration matrix is never sent or parsed
+// again, and every solve is warm-started from the routes of the previous one
+// after the delta has been patched into them. OR-tools models cannot change
+// once closed, so each solve still builds a fresh RoutingInstance.
+class RoutingSession {
+public:
+  explicit RoutingSession(Routing routing);
+  RoutingSession(const RoutingSession &) = delete;
+  RoutingSession &operator=(const RoutingSession &) = delete;
+
+  // throws InvalidConfiguration and leaves the session untouched when the
+  // delta does not fit it
+  void apply(const SessionDelta &delta);
+  // throws std::runtime_error when no solution is found
+  std::vector<RoutingResponse> solve();
+  // apply() then solve() without another request slipping in between
+  std::vector<RoutingResponse> update(const SessionDelta &delta);
+
+  // Responses of the last solve, empty before the first one. Neither this
+  // nor nodeCount() waits for a solve or delta in progress.
+  std::vector<RoutingResponse> lastSolution() const;
+  size_t nodeCount() const;
+  // estimated memory held, dominated by the duration matrix
+  size_t bytes() const;
+
+private:
+  void _apply(const AddOrder &delta);
+  void _apply(const CancelOrder &delta);
+  void _apply(const ChangeTimeWindow &delta);
+  void _apply(const VehicleBreakdown &delta);
+  std::vector<RoutingResponse> _solve();
+
+  // start and end of the vehicle, -1 when it has none
+  std::pair<int32_t, int32_t> _endpoints(int32_t vehicle) const;
+  bool _isDepot(int32_t node) const;
+  bool _isAvailable(int32_t vehicle) const;
+  void _removeVisit(int32_t node);
+  // cheapest insertion by duration into the routes of available vehicles
+  void _insertVisit(int32_t node);
+
+  // held for whole solves, and for deltas
+  mutable std::mutex _mutex;
+  Routing _routing;
+  // request nodes each vehicle visits, start and end excluded
+  std::vector<std::vector<int32_t>> _visits;
+  // only ever held to copy _last_solution in or out
+  mutable std::mutex _last_mutex;
+  std::vector<RoutingResponse> _last_solution;
+  std::atomic<size_t> _node_count;
+};
+} // namespace OrtoolsLib
+
+#endif // ROUTING_SESSION_H
@@ -0,0 +1,159 @@
+#include "routingSession.h"
+#include "sessionStore.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+const std::vector<std::vector<int64_t>> g_session_matrix = {
+    {0, 10, 20, 30, 40},
+    {10, 0, 10, 20, 30},
+    {20, 10, 0, 10, 20},
+    {30, 20, 10, 0, 10},
+    {40, 30, 20, 10, 0},
+};
+
+OrtoolsLib::Routing sessionRouting(int32_t num_vehicles) {
+  return OrtoolsLib::Routing::builder()
+      .setDurationMatrix(g_session_matrix)
+      .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+      .setNumVehicles(num_vehicles)
+      .withSearchOptions(OrtoolsLib::SearchOptions{.time_limit_ms = 200})
+      .build();
+}
+
+bool visits(const std::vector<OrtoolsLib::RoutingResponse> &responses,
+            int node) {
+  return std::any_of(responses.begin(), responses.end(),
+                     [node](const OrtoolsLib::RoutingResponse &response) {
+                       return std::find(response.route.begin(),
+                                        response.route.end(),
+                                        node) != response.route.end();
+                     });
+}
+} // namespace
+
+TEST(RoutingSessionTest, AddOrder) {
+  OrtoolsLib::RoutingSession session(sessionRouting(1));
+  ASSERT_FALSE(visits(session.solve(), 5));
+
+  const auto responses = session.update(OrtoolsLib::AddOrder{
+      .durations_to = {15, 5, 5, 15, 25},
+      .durations_from = {15, 5, 5, 15, 25},
+  });
+
+  EXPECT_EQ(session.nodeCount(), 6);
+  EXPECT_TRUE(visits(responses, 5));
+}
+
+TEST(RoutingSessionTest, CancelOrder) {
+  OrtoolsLib::RoutingSession session(sessionRouting(1));
+  ASSERT_TRUE(visits(session.solve(), 2));
+
+  const auto responses = session.update(OrtoolsLib::CancelOrder{.node = 2});
+
+  EXPECT_FALSE(visits(responses, 2));
+  EXPECT_TRUE(visits(responses, 3));
+}
+
+TEST(RoutingSessionTest, VehicleBreakdown) {
+  OrtoolsLib::RoutingSession session(sessionRouting(2));
+  session.solve();
+
+  const auto responses =
+      session.update(OrtoolsLib::VehicleBreakdown{.vehicle = 0});
+
+  ASSERT_EQ(responses.size(), 2);
+  EXPECT_TRUE(responses[0].route.empty());
+  for (int node = 1; node < 5; ++node) {
+    EXPECT_TRUE(visits(responses, node));
+  }
+}
+
+TEST(RoutingSessionTest, RejectsInvalidDeltas) {
+  OrtoolsLib::RoutingSession session(sessionRouting(1));
+
+  EXPECT_THROW(session.apply(OrtoolsLib::AddOrder{
+                   .durations_to = {1, 2},
+                   .durations_from = {1, 2, 3, 4, 5},
+               }),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_EQ(session.nodeCount(), 5);
+  EXPECT_THROW(session.apply(OrtoolsLib::CancelOrder{.node = 0}),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(session.apply(OrtoolsLib::ChangeTimeWindow{
+                   .node = 5,
+                   .time_windows = {{.start = 0, .end = 10}},
+               }),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(session.apply(OrtoolsLib::VehicleBreakdown{.vehicle = 1}),
+               OrtoolsLib::InvalidConfiguration);
+}
+
+TEST(RoutingSessionTest, ReadsLastSolutionDuringSolve) {
+  OrtoolsLib::RoutingSession session(
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_session_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          // two vehicles, so guided local search rather than the exact solver
+          .setNumVehicles(2)
+          .withSearchOptions(OrtoolsLib::SearchOptions{.time_limit_ms = 1000})
+          .build());
+  std::thread solving([&session] { session.solve(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  const auto before = std::chrono::steady_clock::now();
+  EXPECT_TRUE(session.lastSolution().empty());
+  EXPECT_EQ(session.nodeCount(), 5);
+  EXPECT_LT(std::chrono::steady_clock::now() - before,
+            std::chrono::milliseconds(500));
+
+  solving.join();
+  EXPECT_TRUE(visits(session.lastSolution(), 2));
+}
+
+TEST(SessionStoreTest, BoundsOpenSessions) {
+  OrtoolsLib::SessionStore store({.max_sessions = 1});
+  const auto created = store.create(sessionRouting(1));
+
+  EXPECT_EQ(created.id.size(), 32);
+  EXPECT_EQ(store.find(created.id), created.session);
+  EXPECT_THROW(store.create(sessionRouting(1)),
+               OrtoolsLib::SessionLimitReached);
+
+  EXPECT_TRUE(store.close(created.id));
+  EXPECT_FALSE(store.close(created.id));
+  EXPECT_EQ(store.find(created.id), nullptr);
+  EXPECT_NO_THROW(store.create(sessionRouting(1)));
+}
+
+TEST(SessionStoreTest, BoundsSessionBytes) {
+  const size_t bytes =
+      OrtoolsLib::RoutingSession(sessionRouting(1)).bytes();
+  OrtoolsLib::SessionStore store({.max_bytes = bytes * 2});
+  store.create(sessionRouting(1));
+  store.create(sessionRouting(1));
+
+  EXPECT_THROW(store.create(sessionRouting(1)),
+               OrtoolsLib::SessionLimitReached);
+  EXPECT_EQ(store.size(), 2);
+}
+
+TEST(SessionStoreTest, ClosesIdleSessions) {
+  OrtoolsLib::SessionStore store({.max_sessions = 2, .idle_timeout_ms = 200});
+  const auto idle = store.create(sessionRouting(1));
+  const auto used = store.create(sessionRouting(1));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  EXPECT_NE(store.find(used.id), nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+
+  // the idle one makes room for a new session, the used one stays open
+  EXPECT_NO_THROW(store.create(sessionRouting(1)));
+  EXPECT_EQ(store.find(idle.id), nullptr);
+  EXPECT_NE(store.find(used.id), nullptr);
+}
@@ -1,8 +1,13 @@
 #include "routing.h"
+#include "solveContext.h"
 
 #include <fmt/ranges.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <stdexcept>
 #include <vector>
 
 const std::vector<std::vector<int64_t>> g_duration_matrix = {
@@ -249,4 +254,411 @@ TEST(RoutingTest, OneVehicleAllConfig) {
   std::vector<int> expected_route{0, 3, 3, 2, 2, 0, 1};
   EXPECT_EQ(expected_route, responses[0].route);
   EXPECT_EQ(responses[0].total_duration, 44);
-}
\ No newline at end of file
+}
+
+TEST(RoutingTest, WithPortfolio) {
+  auto responses =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_duration_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .withPortfolio(OrtoolsLib::RoutingOptionWithPortfolio{
+              .num_workers = 2,
+              .strategies =
+                  {
+                      {OrtoolsLib::FirstSolutionStrategy::PATH_CHEAPEST_ARC,
+                       OrtoolsLib::LocalSearchMetaheuristic::
+                           GUIDED_LOCAL_SEARCH},
+                      {OrtoolsLib::FirstSolutionStrategy::SAVINGS,
+                       OrtoolsLib::LocalSearchMetaheuristic::GREEDY_DESCENT},
+                      {OrtoolsLib::FirstSolutionStrategy::CHRISTOFIDES,
+                       OrtoolsLib::LocalSearchMetaheuristic::
+                           GUIDED_LOCAL_SEARCH},
+                  }})
+          .build()
+          .solve();
+
+  EXPECT_EQ(responses.size(), 1);
+  EXPECT_GE(responses[0].route.size(), g_duration_matrix.size());
+}
+
+
+TEST(RoutingTest, WithCooperativePortfolio) {
+  auto responses =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_duration_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .withPortfolio(OrtoolsLib::RoutingOptionWithPortfolio{
+              .num_workers = 3,
+              .strategies =
+                  {
+                      {OrtoolsLib::FirstSolutionStrategy::PATH_CHEAPEST_ARC,
+                       OrtoolsLib::LocalSearchMetaheuristic::
+                           GUIDED_LOCAL_SEARCH},
+                      {OrtoolsLib::FirstSolutionStrategy::SAVINGS,
+                       OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH},
+                  },
+              .share_incumbent = true,
+          })
+          .build()
+          .solve();
+
+  EXPECT_EQ(responses.size(), 1);
+  EXPECT_GE(responses[0].route.size(), g_duration_matrix.size());
+}
+
+
+TEST(RoutingTest, RejectsOversizedPortfolio) {
+  const auto build = [](OrtoolsLib::RoutingOptionWithPortfolio portfolio) {
+    return OrtoolsLib::Routing::builder()
+        .setDurationMatrix(g_duration_matrix)
+        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+        .withPortfolio(std::move(portfolio))
+        .build();
+  };
+
+  EXPECT_THROW(build({.num_workers =
+                          OrtoolsLib::RoutingOptionWithPortfolio::kMaxWorkers +
+                          1}),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(
+      build({.strategies = std::vector<OrtoolsLib::SearchStrategy>(
+                 OrtoolsLib::RoutingOptionWithPortfolio::kMaxStrategies + 1)}),
+      OrtoolsLib::InvalidConfiguration);
+}
+
+TEST(RoutingTest, WithSubSecondTimeLimit) {
+  auto responses =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_duration_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .withSearchOptions(OrtoolsLib::SearchOptions{
+              .time_limit_ms = 150,
+              .first_solution = OrtoolsLib::FirstSolutionStrategy::SAVINGS,
+              .metaheuristic =
+                  OrtoolsLib::LocalSearchMetaheuristic::GREEDY_DESCENT,
+          })
+          .build()
+          .solve();
+
+  EXPECT_EQ(responses.size(), 1);
+}
+
+TEST(RoutingTest, WithSolutionLimitOnly) {
+  auto responses = OrtoolsLib::Routing::builder()
+                       .setDurationMatrix(g_duration_matrix)
+                       .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                       .withSearchOptions(OrtoolsLib::SearchOptions{
+                           .solution_limit = 5,
+                       })
+                       .build()
+                       .solve();
+
+  EXPECT_EQ(responses.size(), 1);
+}
+
+TEST(RoutingTest, RejectsNonPositiveSearchLimits) {
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                   .withSearchOptions(OrtoolsLib::SearchOptions{
+                       .time_limit_ms = 0,
+                   })
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+}
+
+
+TEST(RoutingTest, WithInitialRoutes) {
+  const auto builder = []() {
+    return OrtoolsLib::Routing::builder()
+        .setDurationMatrix(g_duration_matrix)
+        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+        .setNumVehicles(2);
+  };
+  auto first = builder().build().solve();
+
+  std::vector<std::vector<int32_t>> routes;
+  for (const auto &response : first) {
+    routes.emplace_back(response.route.begin(), response.route.end());
+  }
+  auto warm = builder()
+                  .withInitialRoutes(OrtoolsLib::RoutingOptionWithInitialRoutes{
+                      .routes = routes})
+                  .withSearchOptions(OrtoolsLib::SearchOptions{
+                      .solution_limit = 1,
+                  })
+                  .build()
+                  .solve();
+
+  ASSERT_EQ(warm.size(), first.size());
+  int64_t first_duration = 0;
+  int64_t warm_duration = 0;
+  for (size_t i = 0; i < first.size(); ++i) {
+    first_duration += first[i].total_duration;
+    warm_duration += warm[i].total_duration;
+  }
+  EXPECT_LE(warm_duration, first_duration);
+}
+
+TEST(RoutingTest, RejectsInitialRoutesOutOfRange) {
+  const OrtoolsLib::RoutingOptionWithInitialRoutes initial_routes{
+      .routes = {{1, 2, 13}}};
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                   .withInitialRoutes(initial_routes)
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+}
+
+TEST(RoutingTest, WithLockedRoutes) {
+  const OrtoolsLib::RoutingOptionWithLockedRoutes locked_routes{
+      .routes = {{0, 6, 1}, {}}};
+  auto responses = OrtoolsLib::Routing::builder()
+                       .setDurationMatrix(g_duration_matrix)
+                       .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                       .setNumVehicles(2)
+                       .withLockedRoutes(locked_routes)
+                       .build()
+                       .solve();
+
+  ASSERT_EQ(responses.size(), 2);
+  ASSERT_GE(responses[0].route.size(), 3);
+  const std::vector<int> prefix(responses[0].route.begin(),
+                                responses[0].route.begin() + 3);
+  EXPECT_EQ(prefix, (std::vector<int>{0, 6, 1}));
+}
+
+TEST(RoutingTest, RejectsNodeLockedTwice) {
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                   .setNumVehicles(2)
+                   .withLockedRoutes(OrtoolsLib::RoutingOptionWithLockedRoutes{
+                       .routes = {{0, 3}, {0, 3}}})
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+}
+
+TEST(RoutingTest, RejectsStartsAndEndsNotOnePerVehicle) {
+  // locked routes read each vehicle's start
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::startEndPair{.starts = {0},
+                                                            .ends = {0}})
+                   .setNumVehicles(2)
+                   .withLockedRoutes(OrtoolsLib::RoutingOptionWithLockedRoutes{
+                       .routes = {{0, 3}, {0, 4}}})
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::startEndPair{.starts = {0},
+                                                            .ends = {13}})
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::SingleDepot{.depot = -2})
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+}
+
+TEST(RoutingTest, RejectsDurationsOutOfRange) {
+  auto matrix = g_duration_matrix;
+  matrix[1][2] = std::numeric_limits<int64_t>::max();
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(matrix)
+                   .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+
+  matrix[1][2] = -OrtoolsLib::Routing::kMaxDuration;
+  EXPECT_NO_THROW(OrtoolsLib::Routing::builder()
+                      .setDurationMatrix(matrix)
+                      .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                      .build());
+}
+
+TEST(RoutingTest, RejectsTimeLimitsOutOfRange) {
+  const auto build = [](std::optional<int64_t> time_limit,
+                        OrtoolsLib::SearchOptions options) {
+    return OrtoolsLib::Routing::builder()
+        .setDurationMatrix(g_duration_matrix)
+        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+        .setTimeLimit(time_limit)
+        .withSearchOptions(options)
+        .build();
+  };
+  constexpr int64_t kMax = OrtoolsLib::Routing::kMaxTimeLimitMs;
+
+  EXPECT_THROW(build(std::numeric_limits<int64_t>::max(), {}),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(build(std::nullopt, {.time_limit_ms = kMax + 1}),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_THROW(build(std::nullopt, {.lns_time_limit_ms = kMax + 1}),
+               OrtoolsLib::InvalidConfiguration);
+  EXPECT_NO_THROW(build(kMax / 1000, {.time_limit_ms = kMax}));
+}
+
+TEST(RoutingTest, WithSolutionStream) {
+  std::vector<OrtoolsLib::SolutionUpdate> updates;
+  OrtoolsLib::SolutionStream stream(
+      [&updates](const OrtoolsLib::SolutionUpdate &update) {
+        updates.push_back(update);
+      });
+
+  auto responses = OrtoolsLib::Routing::builder()
+                       .setDurationMatrix(g_duration_matrix)
+                       .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                       .withSearchOptions(OrtoolsLib::SearchOptions{
+                           .time_limit_ms = 200,
+                       })
+                       .build()
+                       .solve(OrtoolsLib::SolveContext{.solutions = &stream});
+
+  ASSERT_FALSE(updates.empty());
+  for (size_t i = 1; i < updates.size(); ++i) {
+    EXPECT_LT(updates[i].objective, updates[i - 1].objective);
+    EXPECT_GE(updates[i].elapsed_ms, updates[i - 1].elapsed_ms);
+  }
+  EXPECT_EQ(updates.back().responses[0].route, responses[0].route);
+}
+
+TEST(RoutingTest, StopsWhenCancelled) {
+  OrtoolsLib::CancellationToken token;
+  token.cancel();
+
+  const auto started = std::chrono::steady_clock::now();
+  try {
+    OrtoolsLib::Routing::builder()
+        .setDurationMatrix(g_duration_matrix)
+        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+        .withSearchOptions(OrtoolsLib::SearchOptions{.time_limit_ms = 5000})
+        .build()
+        .solve(OrtoolsLib::SolveContext{.cancellation = &token});
+  } catch (const std::runtime_error &) {
+    // cancelled before the first solution
+  }
+
+  EXPECT_LT(std::chrono::steady_clock::now() - started,
+            std::chrono::seconds(2));
+}
+
+TEST(RoutingTest, PicksExactEngineForSmallTours) {
+  const auto plan = OrtoolsLib::Routing::builder()
+                        .setDurationMatrix(g_duration_matrix)
+                        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                        .build()
+                        .enginePlan();
+
+  EXPECT_EQ(plan.engine, OrtoolsLib::SolverEngine::EXACT);
+}
+
+TEST(RoutingTest, ShortensDefaultTimeLimitOfSmallProblems) {
+  const auto routing = OrtoolsLib::Routing::builder()
+                           .setDurationMatrix(g_duration_matrix)
+                           .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                           .setNumVehicles(2)
+                           .build();
+
+  EXPECT_EQ(routing.enginePlan().engine,
+            OrtoolsLib::SolverEngine::LOCAL_SEARCH);
+  EXPECT_LT(routing.timeLimitMs().value(), 1000);
+
+  const auto configured =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_duration_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .setNumVehicles(2)
+          .setTimeLimit(2)
+          .build();
+  EXPECT_EQ(configured.timeLimitMs(), 2000);
+}
+
+TEST(RoutingTest, HonoursRequestedStrategyAndPortfolio) {
+  const auto strategy =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_duration_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .setNumVehicles(2)
+          .withSearchOptions(OrtoolsLib::SearchOptions{
+              .metaheuristic =
+                  OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH,
+          })
+          .build()
+          .enginePlan();
+  EXPECT_EQ(strategy.engine, OrtoolsLib::SolverEngine::LOCAL_SEARCH);
+  EXPECT_EQ(strategy.strategy.metaheuristic,
+            OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH);
+  EXPECT_EQ(strategy.time_limit_ms, 1000);
+
+  const auto portfolio =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(g_duration_matrix)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .setNumVehicles(2)
+          .withPortfolio(OrtoolsLib::RoutingOptionWithPortfolio{
+              .share_incumbent = true,
+          })
+          .build()
+          .enginePlan();
+  EXPECT_EQ(portfolio.engine,
+            OrtoolsLib::SolverEngine::COOPERATIVE_PORTFOLIO);
+}
+
+TEST(RoutingTest, RunsGreedyDescentOnLargeProblems) {
+  const std::vector<std::vector<int64_t>> large(
+      2000, std::vector<int64_t>(2000, 1));
+  const auto plan = OrtoolsLib::Routing::builder()
+                        .setDurationMatrix(large)
+                        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                        .setNumVehicles(4)
+                        .build()
+                        .enginePlan();
+
+  EXPECT_EQ(plan.engine, OrtoolsLib::SolverEngine::GREEDY_DESCENT);
+  EXPECT_EQ(plan.strategy.metaheuristic,
+            OrtoolsLib::LocalSearchMetaheuristic::GREEDY_DESCENT);
+
+  // a time limit the caller chose is long enough for the default search
+  const auto limited =
+      OrtoolsLib::Routing::builder()
+          .setDurationMatrix(large)
+          .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+          .setNumVehicles(4)
+          .withSearchOptions(OrtoolsLib::SearchOptions{.time_limit_ms = 60000})
+          .build()
+          .enginePlan();
+  EXPECT_EQ(limited.engine, OrtoolsLib::SolverEngine::LOCAL_SEARCH);
+  EXPECT_EQ(limited.time_limit_ms, 60000);
+}
+
+TEST(RoutingTest, StopsOnceStagnating) {
+  const auto started = std::chrono::steady_clock::now();
+  auto responses = OrtoolsLib::Routing::builder()
+                       .setDurationMatrix(g_duration_matrix)
+                       .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                       .setNumVehicles(2)
+                       .withSearchOptions(OrtoolsLib::SearchOptions{
+                           .time_limit_ms = 5000,
+                           .stagnation_ms = 50,
+                       })
+                       .build()
+                       .solve();
+
+  EXPECT_EQ(responses.size(), 2);
+  EXPECT_LT(std::chrono::steady_clock::now() - started,
+            std::chrono::seconds(2));
+}
+
+TEST(RoutingTest, RejectsIncompleteImprovementWindow) {
+  EXPECT_THROW(OrtoolsLib::Routing::builder()
+                   .setDurationMatrix(g_duration_matrix)
+                   .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+                   .withSearchOptions(OrtoolsLib::SearchOptions{
+                       .improvement_window_ms = 100,
+                   })
+                   .build(),
+               OrtoolsLib::InvalidConfiguration);
+}
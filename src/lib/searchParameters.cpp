@@ -0,0 +1,134 @@
+#include "searchParameters.h"
+
+#include <ortools/constraint_solver/routing_parameters.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace OrtoolsLib {
+operations_research::FirstSolutionStrategy::Value
+toOrtools(FirstSolutionStrategy strategy) {
+  using operations_research::FirstSolutionStrategy;
+  switch (strategy) {
+  case OrtoolsLib::FirstSolutionStrategy::PATH_CHEAPEST_ARC:
+    return FirstSolutionStrategy::PATH_CHEAPEST_ARC;
+  case OrtoolsLib::FirstSolutionStrategy::PATH_MOST_CONSTRAINED_ARC:
+    return FirstSolutionStrategy::PATH_MOST_CONSTRAINED_ARC;
+  case OrtoolsLib::FirstSolutionStrategy::SAVINGS:
+    return FirstSolutionStrategy::SAVINGS;
+  case OrtoolsLib::FirstSolutionStrategy::SWEEP:
+    return FirstSolutionStrategy::SWEEP;
+  case OrtoolsLib::FirstSolutionStrategy::CHRISTOFIDES:
+    return FirstSolutionStrategy::CHRISTOFIDES;
+  case OrtoolsLib::FirstSolutionStrategy::PARALLEL_CHEAPEST_INSERTION:
+    return FirstSolutionStrategy::PARALLEL_CHEAPEST_INSERTION;
+  case OrtoolsLib::FirstSolutionStrategy::LOCAL_CHEAPEST_INSERTION:
+    return FirstSolutionStrategy::LOCAL_CHEAPEST_INSERTION;
+  case OrtoolsLib::FirstSolutionStrategy::GLOBAL_CHEAPEST_ARC:
+    return FirstSolutionStrategy::GLOBAL_CHEAPEST_ARC;
+  case OrtoolsLib::FirstSolutionStrategy::LOCAL_CHEAPEST_ARC:
+    return FirstSolutionStrategy::LOCAL_CHEAPEST_ARC;
+  case OrtoolsLib::FirstSolutionStrategy::FIRST_UNBOUND_MIN_VALUE:
+    return FirstSolutionStrategy::FIRST_UNBOUND_MIN_VALUE;
+  case OrtoolsLib::FirstSolutionStrategy::AUTOMATIC:
+  default:
+    return FirstSolutionStrategy::AUTOMATIC;
+  }
+}
+
+operations_research::LocalSearchMetaheuristic::Value
+toOrtools(LocalSearchMetaheuristic metaheuristic) {
+  using operations_research::LocalSearchMetaheuristic;
+  switch (metaheuristic) {
+  case OrtoolsLib::LocalSearchMetaheuristic::GREEDY_DESCENT:
+    return LocalSearchMetaheuristic::GREEDY_DESCENT;
+  case OrtoolsLib::LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH:
+    return LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH;
+  case OrtoolsLib::LocalSearchMetaheuristic::SIMULATED_ANNEALING:
+    return LocalSearchMetaheuristic::SIMULATED_ANNEALING;
+  case OrtoolsLib::LocalSearchMetaheuristic::TABU_SEARCH:
+    return LocalSearchMetaheuristic::TABU_SEARCH;
+  case OrtoolsLib::LocalSearchMetaheuristic::GENERIC_TABU_SEARCH:
+    return LocalSearchMetaheuristic::GENERIC_TABU_SEARCH;
+  case OrtoolsLib::LocalSearchMetaheuristic::AUTOMATIC:
+  default:
+    return LocalSearchMetaheuristic::AUTOMATIC;
+  }
+}
+
+namespace {
+void setMilliseconds(google::protobuf::Duration *duration, int64_t ms) {
+  duration->set_seconds(ms / 1000);
+  duration->set_nanos(static_cast<int32_t>(ms % 1000 * 1000000));
+}
+} // namespace
+
+operations_research::RoutingSearchParameters
+makeSearchParameters(const SearchStrategy &strategy,
+                     const SearchOptions &options,
+                     std::optional<int64_t> time_limit_ms) {
+  operations_research::RoutingSearchParameters searchParameters =
+      operations_research::DefaultRoutingSearchParameters();
+  searchParameters.set_first_solution_strategy(
+      toOrtools(strategy.first_solution));
+  searchParameters.set_local_search_metaheuristic(
+      toOrtools(strategy.metaheuristic));
+
+  if (time_limit_ms.has_value()) {
+    setMilliseconds(searchParameters.mutable_time_limit(),
+                    time_limit_ms.value());
+  }
+  if (options.lns_time_limit_ms.has_value()) {
+    setMilliseconds(searchParameters.mutable_lns_time_limit(),
+                    options.lns_time_limit_ms.value());
+  }
+  if (options.solution_limit.has_value()) {
+    searchParameters.set_solution_limit(options.solution_limit.value());
+  }
+  searchParameters.set_use_full_propagation(options.use_full_propagation);
+  searchParameters.set_log_search(options.log_search);
+
+  return searchParameters;
+}
+
+Deadline deadlineAfter(std::optional<int64_t> time_limit_ms) {
+  if (!time_limit_ms.has_value()) {
+    return std::nullopt;
+  }
+
+  // saturates like EarlyStop, rather than wrapping into the past
+  const auto now = std::chrono::steady_clock::now();
+  const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::time_point::max() - now);
+  if (time_limit_ms.value() >= left.count()) {
+    return std::chrono::steady_clock::time_point::max();
+  }
+  return now + std::chrono::milliseconds(time_limit_ms.value());
+}
+
+std::optional<int64_t> remainingMs(const Deadline &deadline) {
+  if (!deadline.has_value()) {
+    return std::nullopt;
+  }
+
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             deadline.value() - std::chrono::steady_clock::now())
+      .count();
+}
+
+std::optional<int64_t> boundedTimeLimitMs(std::optional<int64_t> time_limit_ms,
+                                          const Deadline &deadline) {
+  const std::optional<int64_t> remaining_ms = remainingMs(deadline);
+  if (!remaining_ms.has_value()) {
+    return time_limit_ms;
+  }
+
+  const int64_t bounded = std::max<int64_t>(remaining_ms.value(), 1);
+  if (!time_limit_ms.has_value()) {
+    return bounded;
+  }
+  return std::min(time_limit_ms.value(), bounded);
+}
+} // namespace OrtoolsLib
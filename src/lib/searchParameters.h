@@ -0,0 +1,44 @@
+#ifndef SEARCH_PARAMETERS_H
+#define SEARCH_PARAMETERS_H
+
+#include <ortools/constraint_solver/routing_parameters.h>
+
+#include "routing.h"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace OrtoolsLib {
+// PATH_CHEAPEST_ARC + GUIDED_LOCAL_SEARCH, what a plain solve runs
+inline constexpr SearchStrategy kDefaultSearchStrategy{
+    .first_solution = FirstSolutionStrategy::PATH_CHEAPEST_ARC,
+    .metaheuristic = LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH,
+};
+
+operations_research::FirstSolutionStrategy::Value
+toOrtools(FirstSolutionStrategy strategy);
+operations_research::LocalSearchMetaheuristic::Value
+toOrtools(LocalSearchMetaheuristic metaheuristic);
+
+// OR-tools search parameters running `strategy` with the limits and flags of
+// `options`, for at most `time_limit_ms` unless that is std::nullopt
+operations_research::RoutingSearchParameters
+makeSearchParameters(const SearchStrategy &strategy,
+                     const SearchOptions &options,
+                     std::optional<int64_t> time_limit_ms);
+
+// point in time a parallel search stops at, std::nullopt when unbounded
+using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+// `time_limit_ms` from now, saturating at the end of the clock
+Deadline deadlineAfter(std::optional<int64_t> time_limit_ms);
+// milliseconds left before `deadline`: std::nullopt when unbounded, 0 or less
+// once it has passed
+std::optional<int64_t> remainingMs(const Deadline &deadline);
+// the shorter of `time_limit_ms` and what is left before `deadline`, never
+// below 1 ms so the search still returns whatever it finds first
+std::optional<int64_t> boundedTimeLimitMs(std::optional<int64_t> time_limit_ms,
+                                          const Deadline &deadline);
+} // namespace OrtoolsLib
+
+#endif // SEARCH_PARAMETERS_H
@@ -0,0 +1,100 @@
+#include "sessionStore.h"
+#include "randomId.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace OrtoolsLib {
+SessionStore::Created SessionStore::create(Routing routing) {
+  // the session owns its copy of the matrix, built before taking the lock
+  auto session = std::make_shared<RoutingSession>(std::move(routing));
+  const size_t bytes = session->bytes();
+  const Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _closeIdle(now);
+  if (_entries.size() >= _options.max_sessions ||
+      bytes > _options.max_bytes || _bytes > _options.max_bytes - bytes) {
+    throw SessionLimitReached();
+  }
+
+  std::string id = _newId();
+  _entries.push_front(Entry{
+      .id = id,
+      .session = session,
+      .bytes = bytes,
+      .last_used = now,
+  });
+  _index.emplace(id, _entries.begin());
+  _bytes += bytes;
+  return Created{.id = std::move(id), .session = std::move(session)};
+}
+
+std::shared_ptr<RoutingSession> SessionStore::find(const std::string &id) {
+  const Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _closeIdle(now);
+  const auto found = _index.find(id);
+  if (found == _index.end()) {
+    return nullptr;
+  }
+
+  Entry &entry = *found->second;
+  entry.last_used = now;
+  // recharged for what earlier deltas added
+  const size_t bytes = entry.session->bytes();
+  _bytes = _bytes - entry.bytes + bytes;
+  entry.bytes = bytes;
+  _entries.splice(_entries.begin(), _entries, found->second);
+  return entry.session;
+}
+
+bool SessionStore::close(const std::string &id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto found = _index.find(id);
+  if (found == _index.end()) {
+    return false;
+  }
+
+  _erase(found->second);
+  return true;
+}
+
+size_t SessionStore::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+std::string SessionStore::_newId() const {
+  std::string id;
+  do {
+    id = randomId();
+  } while (_index.count(id));
+
+  return id;
+}
+
+void SessionStore::_erase(std::list<Entry>::iterator entry) {
+  _bytes -= entry->bytes;
+  _index.erase(entry->id);
+  _entries.erase(entry);
+}
+
+void SessionStore::_closeIdle(Clock::time_point now) {
+  if (_options.idle_timeout_ms <= 0) {
+    return;
+  }
+
+  const auto timeout = std::chrono::milliseconds(_options.idle_timeout_ms);
+  // least recently used last, so the idle ones are at the back
+  while (!_entries.empty() && now - _entries.back().last_used >= timeout) {
+    _erase(std::prev(_entries.end()));
+  }
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,82 @@
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include "routing.h"
+#include "routingSession.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace OrtoolsLib {
+class SessionLimitReached : public std::exception {
+public:
+  const char *what() const noexcept override {
+    return "too many open sessions";
+  }
+};
+
+// Open RoutingSessions by id. Sessions live until closed or left unused for
+// idle_timeout_ms; the store bounds how many may be open at once and the
+// bytes they hold together.
+class SessionStore {
+public:
+  struct Options {
+    // open sessions at once
+    size_t max_sessions = 1024;
+    // RoutingSession::bytes() of all open sessions
+    size_t max_bytes = size_t{1} << 30;
+    // sessions nobody found for this long are closed, 0 keeps them
+    int64_t idle_timeout_ms = 30 * 60 * 1000;
+  };
+
+  explicit SessionStore(Options options) : _options(options) {}
+  SessionStore(const SessionStore &) = delete;
+  SessionStore &operator=(const SessionStore &) = delete;
+
+  struct Created {
+    std::string id;
+    std::shared_ptr<RoutingSession> session;
+  };
+
+  // throws SessionLimitReached when the session does not fit next to the
+  // ones already open, once idle sessions are closed
+  Created create(Routing routing);
+  // nullptr when there is no such session; counts as using it
+  std::shared_ptr<RoutingSession> find(const std::string &id);
+  // whether the session existed; requests still holding it may finish
+  bool close(const std::string &id);
+  size_t size() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::string id;
+    std::shared_ptr<RoutingSession> session;
+    // what the session was charged when last used; deltas can grow it
+    size_t bytes;
+    Clock::time_point last_used;
+  };
+
+  // a randomId() unique among open sessions
+  std::string _newId() const;
+  void _erase(std::list<Entry>::iterator entry);
+  void _closeIdle(Clock::time_point now);
+
+  const Options _options;
+  mutable std::mutex _mutex;
+  // most recently used first
+  std::list<Entry> _entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+  size_t _bytes = 0;
+};
+} // namespace OrtoolsLib
+
+#endif // SESSION_STORE_H
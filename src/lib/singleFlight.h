@@ -0,0 +1,73 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+namespace OrtoolsLib {
+// Collapses concurrent calls for the same key into one: the first caller
+// runs the work, everyone arriving while it runs waits for and shares its
+// result, exceptions included. Nothing is remembered once the call returns.
+template <class Key, class Value, class Hash = std::hash<Key>>
+class SingleFlight {
+public:
+  SingleFlight() = default;
+  SingleFlight(const SingleFlight &) = delete;
+  SingleFlight &operator=(const SingleFlight &) = delete;
+
+  template <class F> Value run(const Key &key, F &&work) {
+    std::promise<Value> promise;
+    std::shared_future<Value> result;
+    bool leader = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (auto found = _calls.find(key); found != _calls.end()) {
+        result = found->second;
+        ++_coalesced;
+      } else {
+        result = promise.get_future().share();
+        _calls.emplace(key, result);
+        leader = true;
+      }
+    }
+
+    if (!leader) {
+      return result.get();
+    }
+
+    try {
+      promise.set_value(work());
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _calls.erase(key);
+    }
+    return result.get();
+  }
+
+  size_t inFlight() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _calls.size();
+  }
+
+  // calls that attached to another one instead of running their own work
+  uint64_t coalesced() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _coalesced;
+  }
+
+private:
+  mutable std::mutex _mutex;
+  std::unordered_map<Key, std::shared_future<Value>, Hash> _calls;
+  uint64_t _coalesced = 0;
+};
+} // namespace OrtoolsLib
+
+#endif // SINGLE_FLIGHT_H
@@ -0,0 +1,49 @@
+#include "singleFlight.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(SingleFlightTest, ConcurrentCallersShareOneRun) {
+  OrtoolsLib::SingleFlight<int, int> flight;
+  std::atomic<int> runs = 0;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 4; ++i) {
+    results.push_back(std::async(std::launch::async, [&]() {
+      return flight.run(7, [&]() {
+        ++runs;
+        released.wait();
+        return 42;
+      });
+    }));
+  }
+
+  // hold the leader until every other caller attached to it
+  while (flight.coalesced() < 3) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  release.set_value();
+
+  for (auto &result : results) {
+    EXPECT_EQ(result.get(), 42);
+  }
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(flight.inFlight(), 0);
+}
+
+TEST(SingleFlightTest, SharesExceptionsAndForgetsFinishedCalls) {
+  OrtoolsLib::SingleFlight<int, int> flight;
+
+  EXPECT_THROW(flight.run(1, []() -> int { throw std::runtime_error("x"); }),
+               std::runtime_error);
+  EXPECT_EQ(flight.run(1, []() { return 2; }), 2);
+  EXPECT_EQ(flight.coalesced(), 0);
+}
@@ -0,0 +1,79 @@
+#include "solutionCache.h"
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+size_t
+SolutionCache::entryBytes(const std::vector<RoutingResponse> &responses) {
+  // list node, index node and the shared vector's control block, roughly
+  size_t bytes = sizeof(Entry) + sizeof(Fingerprint) + 4 * sizeof(void *) +
+                 sizeof(std::vector<RoutingResponse>);
+  for (const auto &response : responses) {
+    bytes += sizeof(RoutingResponse) + response.route.size() * sizeof(int);
+  }
+
+  return bytes;
+}
+
+SharedResponses SolutionCache::find(const Fingerprint &key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto found = _index.find(key);
+  if (found == _index.end()) {
+    ++_stats.misses;
+    return nullptr;
+  }
+
+  ++_stats.hits;
+  _entries.splice(_entries.begin(), _entries, found->second);
+  return found->second->responses;
+}
+
+void SolutionCache::insert(const Fingerprint &key, SharedResponses responses) {
+  if (!responses) {
+    return;
+  }
+
+  const size_t bytes = entryBytes(*responses);
+  if (bytes > _options.max_entry_bytes || bytes > _options.max_bytes) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (auto found = _index.find(key); found != _index.end()) {
+    _stats.bytes -= found->second->bytes;
+    _entries.erase(found->second);
+    _index.erase(found);
+  }
+
+  _evictTo(_options.max_bytes - bytes);
+  _entries.push_front(Entry{
+      .key = key,
+      .responses = std::move(responses),
+      .bytes = bytes,
+  });
+  _index.emplace(key, _entries.begin());
+  _stats.bytes += bytes;
+  ++_stats.insertions;
+}
+
+SolutionCache::Stats SolutionCache::stats() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Stats stats = _stats;
+  stats.entries = _entries.size();
+  return stats;
+}
+
+void SolutionCache::_evictTo(size_t max_bytes) {
+  while (!_entries.empty() && _stats.bytes > max_bytes) {
+    const Entry &oldest = _entries.back();
+    _stats.bytes -= oldest.bytes;
+    _index.erase(oldest.key);
+    _entries.pop_back();
+    ++_stats.evictions;
+  }
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,71 @@
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include "fingerprint.h"
+#include "routing.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace OrtoolsLib {
+using SharedResponses = std::shared_ptr<const std::vector<RoutingResponse>>;
+
+// Least recently used map from Routing::fingerprint() to the responses of
+// its solve, bounded by the estimated bytes of the stored responses. The
+// fingerprint is keyed with a per-process secret, so a client cannot build a
+// request whose key collides with another client's and plant its routes.
+class SolutionCache {
+public:
+  struct Options {
+    // total budget, 0 disables the cache
+    size_t max_bytes = 64 << 20;
+    // larger solutions are never stored
+    size_t max_entry_bytes = 1 << 20;
+  };
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+  };
+
+  explicit SolutionCache(Options options) : _options(options) {}
+  SolutionCache(const SolutionCache &) = delete;
+  SolutionCache &operator=(const SolutionCache &) = delete;
+
+  // nullptr on a miss
+  SharedResponses find(const Fingerprint &key);
+  void insert(const Fingerprint &key, SharedResponses responses);
+  Stats stats() const;
+
+  // what an entry holding `responses` is charged against the budget
+  static size_t entryBytes(const std::vector<RoutingResponse> &responses);
+
+private:
+  struct Entry {
+    Fingerprint key;
+    SharedResponses responses;
+    size_t bytes;
+  };
+
+  void _evictTo(size_t max_bytes);
+
+  const Options _options;
+  mutable std::mutex _mutex;
+  // most recently used first
+  std::list<Entry> _entries;
+  std::unordered_map<Fingerprint, std::list<Entry>::iterator, FingerprintHash>
+      _index;
+  Stats _stats;
+};
+} // namespace OrtoolsLib
+
+#endif // SOLUTION_CACHE_H
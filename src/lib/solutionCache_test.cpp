@@ -0,0 +1,71 @@
+#include "solutionCache.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+OrtoolsLib::SharedResponses makeResponses(int route_length) {
+  return std::make_shared<const std::vector<OrtoolsLib::RoutingResponse>>(
+      std::vector<OrtoolsLib::RoutingResponse>{{
+          .route = std::vector<int>(route_length, 1),
+          .total_duration = route_length,
+      }});
+}
+} // namespace
+
+TEST(SolutionCacheTest, CountsHitsAndMisses) {
+  OrtoolsLib::SolutionCache cache({});
+  const OrtoolsLib::Fingerprint key{.high = 1, .low = 2};
+
+  EXPECT_EQ(cache.find(key), nullptr);
+  cache.insert(key, makeResponses(3));
+  const auto cached = cache.find(key);
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->at(0).total_duration, 3);
+
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.insertions, 1);
+  EXPECT_EQ(stats.entries, 1);
+  EXPECT_EQ(stats.bytes, OrtoolsLib::SolutionCache::entryBytes(*cached));
+}
+
+TEST(SolutionCacheTest, EvictsLeastRecentlyUsedOverBudget) {
+  const size_t entry_bytes =
+      OrtoolsLib::SolutionCache::entryBytes(*makeResponses(10));
+  OrtoolsLib::SolutionCache cache({
+      .max_bytes = 2 * entry_bytes,
+      .max_entry_bytes = entry_bytes,
+  });
+  const OrtoolsLib::Fingerprint first{.low = 1};
+  const OrtoolsLib::Fingerprint second{.low = 2};
+  const OrtoolsLib::Fingerprint third{.low = 3};
+
+  cache.insert(first, makeResponses(10));
+  cache.insert(second, makeResponses(10));
+  // touching the first entry leaves the second as least recently used
+  ASSERT_NE(cache.find(first), nullptr);
+  cache.insert(third, makeResponses(10));
+
+  EXPECT_NE(cache.find(first), nullptr);
+  EXPECT_EQ(cache.find(second), nullptr);
+  EXPECT_NE(cache.find(third), nullptr);
+  EXPECT_EQ(cache.stats().evictions, 1);
+  EXPECT_EQ(cache.stats().bytes, 2 * entry_bytes);
+}
+
+TEST(SolutionCacheTest, SkipsOversizedEntries) {
+  OrtoolsLib::SolutionCache cache({
+      .max_entry_bytes =
+          OrtoolsLib::SolutionCache::entryBytes(*makeResponses(10)),
+  });
+  const OrtoolsLib::Fingerprint key{.low = 1};
+
+  cache.insert(key, makeResponses(11));
+
+  EXPECT_EQ(cache.find(key), nullptr);
+  EXPECT_EQ(cache.stats().entries, 0);
+}
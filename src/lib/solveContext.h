@@ -0,0 +1,113 @@
+#ifndef SOLVE_CONTEXT_H
+#define SOLVE_CONTEXT_H
+
+#include "routing.h"
+#include "searchParameters.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+struct SolutionUpdate {
+  std::vector<RoutingResponse> responses;
+  int64_t objective;
+  // since the SolutionStream was created
+  int64_t elapsed_ms;
+};
+
+// Receives the solutions of one solve while it runs. Only strictly improving
+// solutions are forwarded, and one at a time, so the callback needs no
+// locking of its own when several portfolio workers report concurrently.
+class SolutionStream {
+public:
+  using Callback = std::function<void(const SolutionUpdate &)>;
+
+  explicit SolutionStream(Callback callback)
+      : _callback(std::move(callback)),
+        _started(std::chrono::steady_clock::now()) {}
+  SolutionStream(const SolutionStream &) = delete;
+  SolutionStream &operator=(const SolutionStream &) = delete;
+
+  // lets workers skip building responses that would be dropped anyway
+  bool improves(int64_t objective) const noexcept {
+    return objective < _best.load(std::memory_order_acquire);
+  }
+
+  // forwards `build()` when `objective` beats everything offered so far
+  template <class Build> void offer(int64_t objective, Build &&build) {
+    if (!improves(objective)) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (objective >= _best.load(std::memory_order_relaxed)) {
+      return;
+    }
+    _best.store(objective, std::memory_order_release);
+    _callback(SolutionUpdate{
+        .responses = build(),
+        .objective = objective,
+        .elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - _started)
+                          .count(),
+    });
+  }
+
+private:
+  const Callback _callback;
+  const std::chrono::steady_clock::time_point _started;
+  std::atomic<int64_t> _best{std::numeric_limits<int64_t>::max()};
+  std::mutex _mutex;
+};
+
+// Asks a running solve to stop and return the best solution found so far.
+// Searches poll cancelled() constantly, so a probe must be cheap.
+class CancellationToken {
+public:
+  CancellationToken() = default;
+  // `probe` is polled as well, e.g. whether the client is still connected
+  explicit CancellationToken(std::function<bool()> probe)
+      : _probe(std::move(probe)) {}
+  CancellationToken(const CancellationToken &) = delete;
+  CancellationToken &operator=(const CancellationToken &) = delete;
+
+  void cancel() noexcept { _cancelled.store(true, std::memory_order_release); }
+
+  bool cancelled() const {
+    if (_cancelled.load(std::memory_order_acquire)) {
+      return true;
+    }
+    if (_probe && _probe()) {
+      _cancelled.store(true, std::memory_order_release);
+      return true;
+    }
+    return false;
+  }
+
+private:
+  mutable std::atomic<bool> _cancelled{false};
+  const std::function<bool()> _probe;
+};
+
+// What a caller can hook into one Routing::solve(), all optional.
+struct SolveContext {
+  SolutionStream *solutions = nullptr;
+  const CancellationToken *cancellation = nullptr;
+  // the solve ends by then even when its own time limit is longer
+  Deadline deadline;
+
+  bool cancelled() const { return cancellation && cancellation->cancelled(); }
+  // the configured time limit, shortened to the deadline
+  std::optional<int64_t> timeLimitMs(std::optional<int64_t> configured) const {
+    return boundedTimeLimitMs(configured, deadline);
+  }
+};
+} // namespace OrtoolsLib
+
+#endif // SOLVE_CONTEXT_H
@@ -0,0 +1,107 @@
+#include "solveContext.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
+
+TEST(SolutionStreamTest, ForwardsOnlyImprovements) {
+  std::vector<int64_t> objectives;
+  OrtoolsLib::SolutionStream stream(
+      [&objectives](const OrtoolsLib::SolutionUpdate &update) {
+        objectives.push_back(update.objective);
+        EXPECT_EQ(update.responses.size(), 1);
+        EXPECT_GE(update.elapsed_ms, 0);
+      });
+
+  int built = 0;
+  const auto build = [&built]() {
+    ++built;
+    return std::vector<OrtoolsLib::RoutingResponse>{
+        {.route = {0, 1, 0}, .total_duration = 2}};
+  };
+  stream.offer(10, build);
+  stream.offer(12, build);
+  stream.offer(10, build);
+  stream.offer(7, build);
+
+  EXPECT_EQ(objectives, (std::vector<int64_t>{10, 7}));
+  EXPECT_EQ(built, 2);
+  EXPECT_FALSE(stream.improves(7));
+  EXPECT_TRUE(stream.improves(6));
+}
+
+TEST(SolutionStreamTest, SerializesConcurrentOffers) {
+  int inside = 0;
+  bool overlapped = false;
+  std::vector<int64_t> objectives;
+  OrtoolsLib::SolutionStream stream(
+      [&](const OrtoolsLib::SolutionUpdate &update) {
+        overlapped |= ++inside > 1;
+        objectives.push_back(update.objective);
+        --inside;
+      });
+
+  const auto build = []() {
+    return std::vector<OrtoolsLib::RoutingResponse>{};
+  };
+  std::vector<std::thread> workers;
+  for (int worker = 0; worker < 4; ++worker) {
+    workers.emplace_back([&stream, &build, worker]() {
+      for (int64_t objective = 1000; objective > 0; --objective) {
+        stream.offer(objective * 4 + worker, build);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  EXPECT_FALSE(overlapped);
+  ASSERT_FALSE(objectives.empty());
+  for (size_t i = 1; i < objectives.size(); ++i) {
+    EXPECT_LT(objectives[i], objectives[i - 1]);
+  }
+  EXPECT_EQ(objectives.back(), 4);
+}
+
+TEST(CancellationTokenTest, LatchesProbe) {
+  bool disconnected = false;
+  const OrtoolsLib::CancellationToken token(
+      [&disconnected]() { return disconnected; });
+  EXPECT_FALSE(token.cancelled());
+
+  disconnected = true;
+  EXPECT_TRUE(token.cancelled());
+  disconnected = false;
+  EXPECT_TRUE(token.cancelled());
+}
+
+TEST(SolveContextTest, ShortensTimeLimitToDeadline) {
+  const OrtoolsLib::SolveContext unbounded;
+  EXPECT_EQ(unbounded.timeLimitMs(5000), 5000);
+  EXPECT_EQ(unbounded.timeLimitMs(std::nullopt), std::nullopt);
+
+  const OrtoolsLib::SolveContext bounded{
+      .deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1),
+  };
+  EXPECT_LE(bounded.timeLimitMs(5000), 1000);
+  EXPECT_LE(bounded.timeLimitMs(std::nullopt), 1000);
+  EXPECT_EQ(bounded.timeLimitMs(10), 10);
+
+  const OrtoolsLib::SolveContext expired{
+      .deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1),
+  };
+  EXPECT_EQ(expired.timeLimitMs(5000), 1);
+}
+
+TEST(SolveContextTest, DeadlineSaturates) {
+  const OrtoolsLib::Deadline deadline =
+      OrtoolsLib::deadlineAfter(std::numeric_limits<int64_t>::max());
+  EXPECT_EQ(deadline, std::chrono::steady_clock::time_point::max());
+  EXPECT_GT(OrtoolsLib::remainingMs(deadline), 0);
+}
@@ -0,0 +1,111 @@
+#include "solverExecutor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace OrtoolsLib {
+namespace {
+constexpr std::chrono::milliseconds kMinRetryAfter{1000};
+} // namespace
+
+SolverExecutor::SolverExecutor(Options options)
+    : _max_queued(options.max_queued) {
+  size_t workers = options.workers;
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  _stats.workers = workers;
+  _threads.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    _threads.emplace_back([this]() { _run(); });
+  }
+}
+
+SolverExecutor::~SolverExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _cv.notify_all();
+
+  for (auto &thread : _threads) {
+    thread.join();
+  }
+}
+
+void SolverExecutor::submit(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // idle workers pick a task up at once, it never really waits
+    const size_t idle = _stats.workers - _stats.running;
+    if (_queue.size() >= _max_queued + idle) {
+      ++_stats.rejected;
+      throw ExecutorSaturated(_retryAfter());
+    }
+
+    _queue.push_back(Queued{
+        .task = std::move(task),
+        .since = std::chrono::steady_clock::now(),
+    });
+    _stats.queued = _queue.size();
+  }
+  _cv.notify_one();
+}
+
+SolverExecutor::Stats SolverExecutor::stats() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _stats;
+}
+
+void SolverExecutor::_run() {
+  while (true) {
+    Queued queued;
+    std::chrono::steady_clock::time_point started;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+      if (_queue.empty()) {
+        return;
+      }
+
+      queued = std::move(_queue.front());
+      _queue.pop_front();
+      started = std::chrono::steady_clock::now();
+      const int64_t wait_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(started -
+                                                                queued.since)
+              .count();
+      _stats.queued = _queue.size();
+      ++_stats.running;
+      ++_stats.started;
+      _stats.total_wait_ms += wait_ms;
+      _stats.max_wait_ms = std::max(_stats.max_wait_ms, wait_ms);
+    }
+
+    try {
+      queued.task(std::chrono::duration_cast<std::chrono::milliseconds>(
+          started - queued.since));
+    } catch (...) {
+      // a task answers its own caller, there is nobody to rethrow to
+    }
+
+    const auto run = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started);
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_stats.running;
+    _mean_run = _mean_run.count() == 0 ? run : (_mean_run * 7 + run) / 8;
+  }
+}
+
+std::chrono::milliseconds SolverExecutor::_retryAfter() const {
+  // the queue drains one wave of workers per mean run time
+  const size_t waves = (_queue.size() + _stats.workers) / _stats.workers;
+  return std::max(kMinRetryAfter,
+                  _mean_run * static_cast<int64_t>(waves));
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,88 @@
+#ifndef SOLVER_EXECUTOR_H
+#define SOLVER_EXECUTOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OrtoolsLib {
+class ExecutorSaturated : public std::exception {
+public:
+  explicit ExecutorSaturated(std::chrono::milliseconds retry_after)
+      : retry_after(retry_after) {}
+
+  const char *what() const noexcept override {
+    return "solver queue is full";
+  }
+
+  // when a queue slot is likely free again, from recent run times
+  const std::chrono::milliseconds retry_after;
+};
+
+// Worker threads the gRPC and REST front ends hand their solves to, so a few
+// long solves never hold the network threads. At most max_queued tasks wait
+// for a worker; past that submit() rejects, and the caller answers with a
+// retry hint instead of letting latency grow without bound.
+class SolverExecutor {
+public:
+  struct Options {
+    // 0 picks one per hardware thread
+    size_t workers = 0;
+    // tasks waiting while every worker is busy
+    size_t max_queued = 64;
+  };
+
+  struct Stats {
+    size_t workers = 0;
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t started = 0;
+    uint64_t rejected = 0;
+    // time started tasks waited for a worker
+    int64_t total_wait_ms = 0;
+    int64_t max_wait_ms = 0;
+  };
+
+  // told how long it waited for a worker; exceptions escaping it are dropped
+  using Task = std::function<void(std::chrono::milliseconds queue_wait)>;
+
+  explicit SolverExecutor(Options options);
+  // runs every task already queued, then joins the workers
+  ~SolverExecutor();
+  SolverExecutor(const SolverExecutor &) = delete;
+  SolverExecutor &operator=(const SolverExecutor &) = delete;
+
+  // throws ExecutorSaturated when every worker is busy and max_queued tasks
+  // are already waiting
+  void submit(Task task);
+  Stats stats() const;
+
+private:
+  struct Queued {
+    Task task;
+    std::chrono::steady_clock::time_point since;
+  };
+
+  void _run();
+  std::chrono::milliseconds _retryAfter() const;
+
+  const size_t _max_queued;
+  mutable std::mutex _mutex;
+  std::condition_variable _cv;
+  std::deque<Queued> _queue;
+  bool _stopping = false;
+  Stats _stats;
+  // moving average of how long a task runs
+  std::chrono::milliseconds _mean_run{0};
+  std::vector<std::thread> _threads;
+};
+} // namespace OrtoolsLib
+
+#endif // SOLVER_EXECUTOR_H
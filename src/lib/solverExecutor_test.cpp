@@ -0,0 +1,49 @@
+#include "solverExecutor.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+
+TEST(SolverExecutorTest, RunsEveryTask) {
+  std::atomic<int> counter = 0;
+  {
+    OrtoolsLib::SolverExecutor executor({.workers = 2, .max_queued = 16});
+    for (int i = 0; i < 10; ++i) {
+      executor.submit([&counter](std::chrono::milliseconds queue_wait) {
+        EXPECT_GE(queue_wait.count(), 0);
+        ++counter;
+      });
+    }
+  }
+
+  EXPECT_EQ(counter, 10);
+}
+
+TEST(SolverExecutorTest, RejectsWhenQueueIsFull) {
+  OrtoolsLib::SolverExecutor executor({.workers = 1, .max_queued = 1});
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> running;
+
+  executor.submit([&running, released](std::chrono::milliseconds) {
+    running.set_value();
+    released.wait();
+  });
+  running.get_future().wait();
+  executor.submit([released](std::chrono::milliseconds) { released.wait(); });
+
+  try {
+    executor.submit([](std::chrono::milliseconds) {});
+    ADD_FAILURE() << "the queue should be full";
+  } catch (const OrtoolsLib::ExecutorSaturated &e) {
+    EXPECT_GE(e.retry_after, std::chrono::seconds(1));
+  }
+
+  const auto stats = executor.stats();
+  EXPECT_EQ(stats.running, 1);
+  EXPECT_EQ(stats.queued, 1);
+  EXPECT_EQ(stats.rejected, 1);
+  release.set_value();
+}
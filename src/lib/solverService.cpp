@@ -0,0 +1,274 @@
+#include "solverService.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+size_t countFromEnvironment(const char *name, size_t fallback) {
+  const char *value = std::getenv(name);
+  if (value == nullptr) {
+    return fallback;
+  }
+
+  size_t count = 0;
+  const char *end = value + std::strlen(value);
+  const auto [last, error] = std::from_chars(value, end, count);
+  if (error != std::errc() || last != end) {
+    throw std::invalid_argument(std::string(name) + " is not a count");
+  }
+
+  return count;
+}
+} // namespace
+
+SolverService::Options SolverService::Options::fromEnvironment() {
+  Options options;
+  options.cache.max_bytes =
+      countFromEnvironment("ORTOOLS_CACHE_MAX_BYTES", options.cache.max_bytes);
+  options.cache.max_entry_bytes = countFromEnvironment(
+      "ORTOOLS_CACHE_MAX_ENTRY_BYTES", options.cache.max_entry_bytes);
+  options.sessions.max_sessions = countFromEnvironment(
+      "ORTOOLS_MAX_SESSIONS", options.sessions.max_sessions);
+  options.sessions.max_bytes = countFromEnvironment(
+      "ORTOOLS_SESSION_MAX_BYTES", options.sessions.max_bytes);
+  options.sessions.idle_timeout_ms =
+      static_cast<int64_t>(countFromEnvironment(
+          "ORTOOLS_SESSION_IDLE_MS",
+          static_cast<size_t>(options.sessions.idle_timeout_ms)));
+  options.executor.workers =
+      countFromEnvironment("ORTOOLS_SOLVER_WORKERS", options.executor.workers);
+  options.executor.max_queued = countFromEnvironment(
+      "ORTOOLS_SOLVER_QUEUE", options.executor.max_queued);
+  if (const char *job_directory = std::getenv("ORTOOLS_JOB_DIR")) {
+    options.jobs.directory = job_directory;
+  }
+  options.jobs.max_finished = countFromEnvironment(
+      "ORTOOLS_MAX_FINISHED_JOBS", options.jobs.max_finished);
+  options.jobs.finished_ttl_ms = static_cast<int64_t>(countFromEnvironment(
+      "ORTOOLS_JOB_TTL_MS", static_cast<size_t>(options.jobs.finished_ttl_ms)));
+  return options;
+}
+
+SolverService::SolverService(Options options)
+    : _cache(options.cache), _sessions(options.sessions),
+      _jobs(options.jobs), _executor(options.executor) {}
+
+SharedResponses SolverService::solve(const Routing &routing) {
+  return solve(routing, SolveContext{});
+}
+
+SharedResponses SolverService::solve(const Routing &routing,
+                                     const SolveContext &context) {
+  const Fingerprint key = routing.fingerprint();
+  if (SharedResponses cached = _cache.find(key)) {
+    return cached;
+  }
+
+  const bool full_time_limit =
+      context.timeLimitMs(routing.timeLimitMs()) == routing.timeLimitMs();
+  if (context.solutions || !full_time_limit) {
+    auto responses = std::make_shared<const std::vector<RoutingResponse>>(
+        routing.solve(context));
+    if (full_time_limit && !context.cancelled()) {
+      _cache.insert(key, responses);
+    }
+    return responses;
+  }
+
+  const std::shared_ptr<Callers> callers = _join(key, context.cancellation);
+  struct Leave {
+    SolverService &service;
+    const Fingerprint &key;
+    const std::shared_ptr<Callers> &callers;
+    const CancellationToken *token;
+    ~Leave() { service._leave(key, callers, token); }
+  } leave{*this, key, callers, context.cancellation};
+
+  return _in_flight.run(key, [this, &routing, &key, &callers]() {
+    const CancellationToken token(
+        [&callers]() { return callers->allCancelled(); });
+    auto responses = std::make_shared<const std::vector<RoutingResponse>>(
+        routing.solve(SolveContext{.cancellation = &token}));
+    // cached before the call is forgotten, so a request arriving in between
+    // finds one or the other
+    if (!token.cancelled()) {
+      _cache.insert(key, responses);
+    }
+    return SharedResponses(responses);
+  });
+}
+
+std::string SolverService::submitJob(Routing routing) {
+  auto shared = std::make_shared<const Routing>(std::move(routing));
+  const std::string id = _jobs.create(shared->enginePlan().engine);
+  try {
+    _executor.submit([this, id, shared](std::chrono::milliseconds) {
+      _runJob(id, *shared);
+    });
+  } catch (const ExecutorSaturated &) {
+    _jobs.discard(id);
+    throw;
+  }
+
+  return id;
+}
+
+void SolverService::_runJob(const std::string &id, const Routing &routing) {
+  const CancellationToken *token = _jobs.start(id);
+  if (!token) {
+    return;
+  }
+
+  SolutionStream progress([this, &id](const SolutionUpdate &update) {
+    _jobs.improve(id, update.objective);
+  });
+  try {
+    const SharedResponses responses = solve(
+        routing, SolveContext{.solutions = &progress, .cancellation = token});
+    _jobs.finish(id,
+                 token->cancelled() ? JobState::Cancelled
+                                    : JobState::Succeeded,
+                 *responses);
+  } catch (const std::runtime_error &e) {
+    _jobs.finish(id,
+                 token->cancelled() ? JobState::Cancelled
+                                    : JobState::NoSolution,
+                 {}, e.what());
+  } catch (const std::exception &e) {
+    _jobs.finish(id, JobState::Failed, {}, e.what());
+  }
+}
+
+void SolverService::solveBatch(
+    std::vector<Routing> routings, std::optional<int64_t> item_time_limit_ms,
+    std::function<void(const BatchItem &)> on_item,
+    std::function<void()> on_done,
+    std::shared_ptr<const CancellationToken> cancellation) {
+  if (routings.size() > kMaxBatchItems) {
+    throw InvalidConfiguration("requests", "too many");
+  }
+  if (item_time_limit_ms.has_value() &&
+      item_time_limit_ms.value() > Routing::kMaxTimeLimitMs) {
+    throw InvalidConfiguration("itemTimeLimitMs", "too large");
+  }
+
+  struct Batch {
+    std::vector<Routing> routings;
+    std::optional<int64_t> item_time_limit_ms;
+    std::function<void(const BatchItem &)> on_item;
+    std::function<void()> on_done;
+    std::shared_ptr<const CancellationToken> cancellation;
+    std::atomic<size_t> next{0};
+    // running lanes, plus one held while they are being submitted
+    std::atomic<size_t> lanes{1};
+
+    void release() {
+      if (--lanes == 0) {
+        on_done();
+      }
+    }
+  };
+
+  auto batch = std::make_shared<Batch>();
+  batch->routings = std::move(routings);
+  batch->item_time_limit_ms = item_time_limit_ms;
+  batch->on_item = std::move(on_item);
+  batch->on_done = std::move(on_done);
+  batch->cancellation = std::move(cancellation);
+
+  const auto lane = [this, batch](std::chrono::milliseconds) {
+    // handed back however the lane ends, so on_done always fires
+    struct Held {
+      Batch &batch;
+      ~Held() { batch.release(); }
+    } held{*batch};
+
+    for (size_t index = batch->next++; index < batch->routings.size();
+         index = batch->next++) {
+      const SolveContext context{
+          .cancellation = batch->cancellation.get(),
+          .deadline = deadlineAfter(batch->item_time_limit_ms),
+      };
+      if (context.cancelled()) {
+        break;
+      }
+
+      const Routing &routing = batch->routings[index];
+      BatchItem item{.index = index, .engine = routing.enginePlan().engine};
+      try {
+        item.responses = solve(routing, context);
+      } catch (const std::exception &e) {
+        // InvalidConfiguration, no solution, or anything else the solve
+        // throws: the item fails, the batch goes on
+        item.error = e.what();
+      }
+      batch->on_item(item);
+    }
+  };
+
+  const size_t lanes =
+      std::min(batch->routings.size(), _executor.stats().workers);
+  size_t submitted = 0;
+  for (; submitted < lanes; ++submitted) {
+    ++batch->lanes;
+    try {
+      _executor.submit(lane);
+    } catch (const ExecutorSaturated &) {
+      --batch->lanes;
+      if (submitted == 0) {
+        throw;
+      }
+      break;
+    }
+  }
+  batch->release();
+}
+
+bool SolverService::Callers::allCancelled() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return !tokens.empty() &&
+         std::all_of(tokens.begin(), tokens.end(),
+                     [](const CancellationToken *token) {
+                       return token && token->cancelled();
+                     });
+}
+
+std::shared_ptr<SolverService::Callers>
+SolverService::_join(const Fingerprint &key, const CancellationToken *token) {
+  std::lock_guard<std::mutex> lock(_callers_mutex);
+  std::shared_ptr<Callers> &callers = _callers[key];
+  if (!callers) {
+    callers = std::make_shared<Callers>();
+  }
+
+  std::lock_guard<std::mutex> callers_lock(callers->mutex);
+  callers->tokens.push_back(token);
+  return callers;
+}
+
+void SolverService::_leave(const Fingerprint &key,
+                           const std::shared_ptr<Callers> &callers,
+                           const CancellationToken *token) {
+  std::lock_guard<std::mutex> lock(_callers_mutex);
+  std::lock_guard<std::mutex> callers_lock(callers->mutex);
+  auto &tokens = callers->tokens;
+  tokens.erase(std::find(tokens.begin(), tokens.end(), token));
+  if (tokens.empty()) {
+    _callers.erase(key);
+  }
+}
+} // namespace OrtoolsLib
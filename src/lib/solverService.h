@@ -0,0 +1,138 @@
+#ifndef SOLVER_SERVICE_H
+#define SOLVER_SERVICE_H
+
+#include "fingerprint.h"
+#include "jobStore.h"
+#include "routing.h"
+#include "sessionStore.h"
+#include "singleFlight.h"
+#include "solutionCache.h"
+#include "solveContext.h"
+#include "solverExecutor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OrtoolsLib {
+// What the gRPC and REST handlers solve through. Configurations solved
+// before are answered from the SolutionCache without touching the solver, and
+// identical configurations arriving while one is being solved wait for that
+// solve instead of starting their own.
+class SolverService {
+public:
+  struct Stats {
+    SolutionCache::Stats cache;
+    // solves that attached to an identical one already running
+    uint64_t coalesced = 0;
+    SolverExecutor::Stats executor;
+  };
+
+  struct BatchItem {
+    // position in the batch
+    size_t index = 0;
+    SolverEngine engine = SolverEngine::LOCAL_SEARCH;
+    // nullptr when the item failed, see `error`
+    SharedResponses responses;
+    std::string error;
+  };
+
+  struct Options {
+    SolutionCache::Options cache;
+    SessionStore::Options sessions;
+    SolverExecutor::Options executor;
+    JobStore::Options jobs;
+
+    // ORTOOLS_CACHE_MAX_BYTES, ORTOOLS_CACHE_MAX_ENTRY_BYTES,
+    // ORTOOLS_MAX_SESSIONS, ORTOOLS_SESSION_MAX_BYTES,
+    // ORTOOLS_SESSION_IDLE_MS, ORTOOLS_SOLVER_WORKERS, ORTOOLS_SOLVER_QUEUE,
+    // ORTOOLS_JOB_DIR, ORTOOLS_MAX_FINISHED_JOBS and ORTOOLS_JOB_TTL_MS,
+    // unset variables keep their default; throws
+    // std::invalid_argument when a count variable is not a count
+    static Options fromEnvironment();
+  };
+
+  explicit SolverService(Options options);
+  SolverService(const SolverService &) = delete;
+  SolverService &operator=(const SolverService &) = delete;
+
+  // throws whatever Routing::solve() throws, failures are not cached
+  SharedResponses solve(const Routing &routing);
+  // solve() under `context`. A coalesced solve is cancelled only once every
+  // caller waiting for it is. Solves streaming to their own
+  // `context.solutions`, or cut short by `context.deadline`, run alone, and
+  // like cancelled ones are not cached. A cached configuration streams no
+  // updates, it only returns the result.
+  SharedResponses solve(const Routing &routing, const SolveContext &context);
+
+  // sessions bypass the cache, every delta changes the configuration
+  SessionStore &sessions() { return _sessions; }
+  // where the handlers run solve(), off their network threads
+  SolverExecutor &executor() { return _executor; }
+
+  // Queues `routing` as a background job and returns its id; status and
+  // result are read from jobs(). Throws ExecutorSaturated like executor().
+  std::string submitJob(Routing routing);
+  JobStore &jobs() { return _jobs; }
+
+  // largest batch solveBatch() accepts
+  static constexpr size_t kMaxBatchItems = 256;
+
+  // Solves `routings` concurrently, each within its own time limit capped at
+  // `item_time_limit_ms`, and calls `on_item` from a solver worker as each
+  // one finishes, then `on_done` once. A batch takes at most one executor
+  // slot per worker instead of one per item, so it packs the workers without
+  // filling the queue. Throws ExecutorSaturated when no slot is free, and
+  // InvalidConfiguration for more than kMaxBatchItems routings or an item
+  // time limit above Routing::kMaxTimeLimitMs; items not started by the time
+  // `cancellation` fires are skipped.
+  void solveBatch(std::vector<Routing> routings,
+                  std::optional<int64_t> item_time_limit_ms,
+                  std::function<void(const BatchItem &)> on_item,
+                  std::function<void()> on_done,
+                  std::shared_ptr<const CancellationToken> cancellation = {});
+
+  Stats stats() const {
+    return Stats{
+        .cache = _cache.stats(),
+        .coalesced = _in_flight.coalesced(),
+        .executor = _executor.stats(),
+    };
+  }
+
+private:
+  // cancellation tokens of everyone waiting for one coalesced solve
+  struct Callers {
+    std::mutex mutex;
+    // nullptr for a caller that never cancels
+    std::vector<const CancellationToken *> tokens;
+
+    bool allCancelled();
+  };
+
+  void _runJob(const std::string &id, const Routing &routing);
+
+  std::shared_ptr<Callers> _join(const Fingerprint &key,
+                                 const CancellationToken *token);
+  void _leave(const Fingerprint &key, const std::shared_ptr<Callers> &callers,
+              const CancellationToken *token);
+
+  SolutionCache _cache;
+  SingleFlight<Fingerprint, SharedResponses, FingerprintHash> _in_flight;
+  SessionStore _sessions;
+  JobStore _jobs;
+  std::mutex _callers_mutex;
+  std::unordered_map<Fingerprint, std::shared_ptr<Callers>, FingerprintHash>
+      _callers;
+  // last, so its destructor finishes queued solves while the rest still lives
+  SolverExecutor _executor;
+};
+} // namespace OrtoolsLib
+
+#endif // SOLVER_SERVICE_H
@@ -0,0 +1,135 @@
+#include "solverService.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+const std::vector<std::vector<int64_t>> g_batch_matrix = {
+    {0, 10, 20, 30},
+    {10, 0, 10, 20},
+    {20, 10, 0, 10},
+    {30, 20, 10, 0},
+};
+
+OrtoolsLib::SolverService::Options serviceOptions() {
+  OrtoolsLib::SolverService::Options options;
+  options.executor.workers = 2;
+  options.jobs.directory =
+      std::filesystem::temp_directory_path() / "solverService_test_jobs";
+  return options;
+}
+
+OrtoolsLib::Routing batchRouting(int32_t depot) {
+  return OrtoolsLib::Routing::builder()
+      .setDurationMatrix(g_batch_matrix)
+      .setDepotConfig(OrtoolsLib::SingleDepot{.depot = depot})
+      .withSearchOptions(OrtoolsLib::SearchOptions{.time_limit_ms = 100})
+      .build();
+}
+} // namespace
+
+TEST(SolverServiceTest, SolvesEveryBatchItem) {
+  OrtoolsLib::SolverService service(serviceOptions());
+  std::vector<OrtoolsLib::Routing> routings;
+  for (int32_t depot = 0; depot < 4; ++depot) {
+    routings.push_back(batchRouting(depot));
+  }
+
+  std::mutex mutex;
+  std::vector<size_t> indices;
+  std::promise<void> done;
+  service.solveBatch(
+      std::move(routings), 50,
+      [&mutex, &indices](const OrtoolsLib::SolverService::BatchItem &item) {
+        EXPECT_NE(item.responses, nullptr);
+        std::lock_guard<std::mutex> lock(mutex);
+        indices.push_back(item.index);
+      },
+      [&done]() { done.set_value(); });
+  done.get_future().wait();
+
+  std::sort(indices.begin(), indices.end());
+  EXPECT_EQ(indices, (std::vector<size_t>{0, 1, 2, 3}));
+}
+
+TEST(SolverServiceTest, EmptyBatchIsDoneAtOnce) {
+  OrtoolsLib::SolverService service(serviceOptions());
+  bool done = false;
+  service.solveBatch(
+      {}, std::nullopt,
+      [](const OrtoolsLib::SolverService::BatchItem &) {
+        ADD_FAILURE() << "no item to report";
+      },
+      [&done]() { done = true; });
+
+  EXPECT_TRUE(done);
+}
+
+TEST(SolverServiceTest, BatchIsDoneWhenReportingThrows) {
+  OrtoolsLib::SolverService service(serviceOptions());
+  std::vector<OrtoolsLib::Routing> routings;
+  routings.push_back(batchRouting(0));
+
+  std::promise<void> done;
+  service.solveBatch(
+      std::move(routings), 50,
+      [](const OrtoolsLib::SolverService::BatchItem &) {
+        throw std::runtime_error("client gone");
+      },
+      [&done]() { done.set_value(); });
+
+  EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+}
+
+TEST(SolverServiceTest, ReportsNoSolution) {
+  // node 1 closes before any vehicle can reach it
+  const auto infeasible = []() {
+    return OrtoolsLib::Routing::builder()
+        .setDurationMatrix(g_batch_matrix)
+        .setDepotConfig(OrtoolsLib::SingleDepot{.depot = 0})
+        .withTimeWindow(OrtoolsLib::RoutingOptionWithTimeWindow{
+            .time_windows = {{{0, 100}}, {{0, 1}}, {{0, 100}}, {{0, 100}}}})
+        .withSearchOptions(OrtoolsLib::SearchOptions{.time_limit_ms = 100})
+        .build();
+  };
+  OrtoolsLib::SolverService service(serviceOptions());
+
+  // what both front ends answer as "no solution" rather than as an error
+  EXPECT_THROW(service.solve(infeasible()), std::runtime_error);
+
+  std::vector<OrtoolsLib::Routing> routings;
+  routings.push_back(infeasible());
+  std::promise<OrtoolsLib::SolverService::BatchItem> reported;
+  service.solveBatch(
+      std::move(routings), std::nullopt,
+      [&reported](const OrtoolsLib::SolverService::BatchItem &item) {
+        reported.set_value(item);
+      },
+      []() {});
+  const OrtoolsLib::SolverService::BatchItem item =
+      reported.get_future().get();
+  EXPECT_EQ(item.responses, nullptr);
+  EXPECT_FALSE(item.error.empty());
+}
+
+TEST(SolverServiceTest, RejectsOversizedBatch) {
+  OrtoolsLib::SolverService service(serviceOptions());
+  std::vector<OrtoolsLib::Routing> routings;
+  for (size_t i = 0; i <= OrtoolsLib::SolverService::kMaxBatchItems; ++i) {
+    routings.push_back(batchRouting(0));
+  }
+
+  EXPECT_THROW(service.solveBatch(
+                   std::move(routings), std::nullopt,
+                   [](const OrtoolsLib::SolverService::BatchItem &) {},
+                   []() { ADD_FAILURE() << "never started"; }),
+               OrtoolsLib::InvalidConfiguration);
+}
@@ -0,0 +1,58 @@
+#include "threadPool.h"
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace OrtoolsLib {
+ThreadPool::ThreadPool(size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+
+  _threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    _threads.emplace_back([this]() { _run(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _cv.notify_all();
+
+  for (auto &thread : _threads) {
+    thread.join();
+  }
+}
+
+void ThreadPool::_push(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.push_back(std::move(task));
+  }
+  _cv.notify_one();
+}
+
+void ThreadPool::_run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty()) {
+        return;
+      }
+
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+
+    task();
+  }
+}
+} // namespace OrtoolsLib
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+// Fixed-size pool of worker threads draining a FIFO of tasks. The destructor
+// runs every task already submitted before joining the workers.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t num_threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t size() const noexcept { return _threads.size(); }
+
+  template <class F>
+  std::future<std::invoke_result_t<std::decay_t<F>>> submit(F &&task) {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<F>(task));
+    std::future<Result> result = packaged->get_future();
+    _push([packaged]() { (*packaged)(); });
+    return result;
+  }
+
+private:
+  void _push(std::function<void()> task);
+  void _run();
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::deque<std::function<void()>> _tasks;
+  bool _stopping = false;
+  std::vector<std::thread> _threads;
+};
+} // namespace OrtoolsLib
+
+#endif // THREAD_POOL_H
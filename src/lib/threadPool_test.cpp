@@ -0,0 +1,32 @@
+#include "threadPool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+TEST(ThreadPoolTest, RunsEveryTask) {
+  std::atomic<int> counter = 0;
+  std::vector<std::future<int>> results;
+  {
+    OrtoolsLib::ThreadPool pool(3);
+    for (int i = 0; i < 10; ++i) {
+      results.push_back(pool.submit([&counter, i]() {
+        ++counter;
+        return i * i;
+      }));
+    }
+  }
+
+  EXPECT_EQ(counter, 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(results[i].get(), i * i);
+  }
+}
+
+TEST(ThreadPoolTest, ZeroThreadsStillRuns) {
+  OrtoolsLib::ThreadPool pool(0);
+  EXPECT_EQ(pool.size(), 1);
+  EXPECT_EQ(pool.submit([]() { return 42; }).get(), 42);
+}
@@ -0,0 +1,117 @@
+#include "transitMatrix.h"
+
+#include <ortools/constraint_solver/routing.h>
+#include <ortools/constraint_solver/routing_index_manager.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OrtoolsLib {
+namespace {
+template <bool WithServiceTime>
+void fillTransit(DurationMatrix &transit, const DurationMatrix &durations,
+                 const std::vector<int64_t> *service_time,
+                 const std::vector<int32_t> &index_to_physical) {
+  const size_t n = transit.size();
+  for (size_t from = 0; from < n; ++from) {
+    const int32_t from_node = index_to_physical[from];
+    if (from_node == NodeMap::kVirtual) {
+      // leaving a virtual node is free, the row is already zero
+      continue;
+    }
+
+    const int64_t *durations_from = durations[from_node];
+    int64_t *transit_from = transit[from];
+
+    int64_t extra = 0;
+    if constexpr (WithServiceTime) {
+      extra = (*service_time)[from_node];
+    }
+
+    for (size_t to = 0; to < n; ++to) {
+      const int32_t to_node = index_to_physical[to];
+      transit_from[to] =
+          (to_node == NodeMap::kVirtual ? 0 : durations_from[to_node]) + extra;
+    }
+  }
+}
+
+bool isNonNegative(const DurationMatrix &matrix) {
+  for (size_t i = 0; i < matrix.size(); ++i) {
+    const auto row = matrix.row(i);
+    if (std::any_of(row.begin(), row.end(),
+                    [](int64_t value) { return value < 0; })) {
+      return false;
+    }
+  }
+
+  return true;
+}
+} // namespace
+
+DurationMatrix
+buildTransitMatrix(const DurationMatrix &durations,
+                   const std::vector<int64_t> *service_time,
+                   const NodeMap &nodes,
+                   const operations_research::RoutingIndexManager &manager) {
+  const int num_indices = manager.num_indices();
+  std::vector<int32_t> index_to_physical(num_indices);
+  for (int index = 0; index < num_indices; ++index) {
+    index_to_physical[index] =
+        nodes.physical(manager.IndexToNode(index).value());
+  }
+
+  DurationMatrix transit(num_indices);
+  if (service_time) {
+    fillTransit<true>(transit, durations, service_time, index_to_physical);
+  } else {
+    fillTransit<false>(transit, durations, service_time, index_to_physical);
+  }
+
+  return transit;
+}
+
+std::shared_ptr<const DurationMatrix>
+SharedTransitMatrix::get(const std::function<DurationMatrix()> &build) {
+  std::call_once(_built, [&]() {
+    _matrix = std::make_shared<const DurationMatrix>(build());
+  });
+  return _matrix;
+}
+
+int registerTransitMatrix(operations_research::RoutingModel &routing,
+                          std::shared_ptr<const DurationMatrix> transit) {
+  const auto sign =
+      isNonNegative(*transit)
+          ? operations_research::RoutingModel::kTransitEvaluatorSignPositiveOrZero
+          : operations_research::RoutingModel::kTransitEvaluatorSignUnknown;
+
+  const int64_t *values = transit->data();
+  const int64_t stride = static_cast<int64_t>(transit->stride());
+  return routing.RegisterTransitCallback(
+      [transit = std::move(transit), values,
+       stride](int64_t from_index, int64_t to_index) -> int64_t {
+        return values[from_index * stride + to_index];
+      },
+      sign);
+}
+
+int registerUnaryTransitVector(operations_research::RoutingModel &routing,
+                               std::vector<int64_t> values) {
+  const auto sign =
+      std::all_of(values.begin(), values.end(),
+                  [](int64_t value) { return value >= 0; })
+          ? operations_research::RoutingModel::kTransitEvaluatorSignPositiveOrZero
+          : operations_research::RoutingModel::kTransitEvaluatorSignUnknown;
+
+  return routing.RegisterUnaryTransitCallback(
+      [values = std::move(values)](int64_t from_index) -> int64_t {
+        return values[from_index];
+      },
+      sign);
+}
+} // namespace OrtoolsLib
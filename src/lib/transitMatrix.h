@@ -0,0 +1,53 @@
+#ifndef TRANSIT_MATRIX_H
+#define TRANSIT_MATRIX_H
+
+#include <ortools/constraint_solver/routing.h>
+#include <ortools/constraint_solver/routing_index_manager.h>
+
+#include "durationMatrix.h"
+#include "nodeMap.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace OrtoolsLib {
+// Arc transit of the model (travel duration plus the service time spent at the
+// origin) laid out in OR-tools index space. Built once per model so the
+// evaluators the solver calls millions of times are a plain array read, with no
+// IndexToNode lookups and no branching on the enabled options. Logical nodes
+// are resolved through `nodes`; virtual nodes cost nothing to reach or leave.
+DurationMatrix
+buildTransitMatrix(const DurationMatrix &durations,
+                   const std::vector<int64_t> *service_time,
+                   const NodeMap &nodes,
+                   const operations_research::RoutingIndexManager &manager);
+
+// Transit matrix of every model built from the same Routing, such as the
+// workers of one portfolio or cooperative solve: their index managers lay the
+// nodes out alike, so the first model builds the matrix and the others share
+// it instead of holding a num_indices² copy each.
+class SharedTransitMatrix {
+public:
+  // the shared matrix, built with `build` on the first call
+  std::shared_ptr<const DurationMatrix>
+  get(const std::function<DurationMatrix()> &build);
+
+private:
+  std::once_flag _built;
+  std::shared_ptr<const DurationMatrix> _matrix;
+};
+
+// Registers `transit` as a transit evaluator of `routing` and returns its
+// callback index. The evaluator shares ownership of the matrix.
+int registerTransitMatrix(operations_research::RoutingModel &routing,
+                          std::shared_ptr<const DurationMatrix> transit);
+
+// Registers a per-index unary evaluator (e.g. demands) read from `values`.
+int registerUnaryTransitVector(operations_research::RoutingModel &routing,
+                               std::vector<int64_t> values);
+} // namespace OrtoolsLib
+
+#endif // TRANSIT_MATRIX_H
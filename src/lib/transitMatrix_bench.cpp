@@ -0,0 +1,107 @@
+#include "transitMatrix.h"
+
+#include <benchmark/benchmark.h>
+#include <ortools/constraint_solver/routing_index_manager.h>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int kArcs = 1 << 16;
+
+struct Instance {
+  std::vector<std::vector<int64_t>> rows;
+  OrtoolsLib::DurationMatrix durations;
+  std::vector<int64_t> service_time;
+  operations_research::RoutingIndexManager manager;
+  std::vector<std::pair<int64_t, int64_t>> arcs;
+
+  explicit Instance(int n)
+      : rows(n, std::vector<int64_t>(n)), service_time(n),
+        manager(n, 1, operations_research::RoutingNodeIndex{0}), arcs(kArcs) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> duration(0, 3600);
+    for (auto &row : rows) {
+      for (auto &value : row) {
+        value = duration(rng);
+      }
+    }
+    for (auto &value : service_time) {
+      value = duration(rng) / 10;
+    }
+    durations = OrtoolsLib::DurationMatrix::fromRows(rows);
+
+    std::uniform_int_distribution<int64_t> index(0, manager.num_indices() - 1);
+    for (auto &arc : arcs) {
+      arc = {index(rng), index(rng)};
+    }
+  }
+};
+
+// The evaluator Routing::solve() used to register: node lookups through the
+// manager, nested rows and a branch on the service time option per call.
+void BM_NodeSpaceEvaluator(benchmark::State &state) {
+  Instance instance(static_cast<int>(state.range(0)));
+  const std::optional<std::vector<int64_t>> service_time =
+      instance.service_time;
+  const std::function<int64_t(int64_t, int64_t)> evaluator =
+      [&instance, &service_time](int64_t from_index,
+                                 int64_t to_index) -> int64_t {
+    const int from_node = instance.manager.IndexToNode(from_index).value();
+    const int to_node = instance.manager.IndexToNode(to_index).value();
+    if (service_time.has_value()) {
+      return instance.rows[from_node][to_node] +
+             service_time.value()[from_node];
+    }
+    return instance.rows[from_node][to_node];
+  };
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &[from, to] : instance.arcs) {
+      sum += evaluator(from, to);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kArcs);
+}
+
+void BM_IndexSpaceTransitMatrix(benchmark::State &state) {
+  Instance instance(static_cast<int>(state.range(0)));
+  const OrtoolsLib::NodeMap nodes(static_cast<int32_t>(state.range(0)));
+  const auto transit = OrtoolsLib::buildTransitMatrix(
+      instance.durations, &instance.service_time, nodes, instance.manager);
+  const int64_t *values = transit.data();
+  const int64_t stride = static_cast<int64_t>(transit.stride());
+  const std::function<int64_t(int64_t, int64_t)> evaluator =
+      [values, stride](int64_t from_index, int64_t to_index) -> int64_t {
+    return values[from_index * stride + to_index];
+  };
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &[from, to] : instance.arcs) {
+      sum += evaluator(from, to);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kArcs);
+}
+
+void BM_BuildTransitMatrix(benchmark::State &state) {
+  Instance instance(static_cast<int>(state.range(0)));
+  const OrtoolsLib::NodeMap nodes(static_cast<int32_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(OrtoolsLib::buildTransitMatrix(
+        instance.durations, &instance.service_time, nodes, instance.manager));
+  }
+}
+} // namespace
+
+BENCHMARK(BM_NodeSpaceEvaluator)->Arg(100)->Arg(500)->Arg(2000);
+BENCHMARK(BM_IndexSpaceTransitMatrix)->Arg(100)->Arg(500)->Arg(2000);
+BENCHMARK(BM_BuildTransitMatrix)->Arg(100)->Arg(500)->Arg(2000);
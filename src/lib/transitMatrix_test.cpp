@@ -0,0 +1,102 @@
+#include "transitMatrix.h"
+
+#include <gtest/gtest.h>
+#include <ortools/constraint_solver/routing_index_manager.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(TransitMatrixTest, CombinesServiceTimeInIndexSpace) {
+  const auto durations = OrtoolsLib::DurationMatrix::fromRows({
+      {0, 1, 2},
+      {3, 0, 4},
+      {5, 6, 0},
+  });
+  const std::vector<int64_t> service_time{0, 10, 20};
+  operations_research::RoutingIndexManager manager(
+      3, 2, operations_research::RoutingNodeIndex{0});
+
+  const auto transit = OrtoolsLib::buildTransitMatrix(
+      durations, &service_time, OrtoolsLib::NodeMap(3), manager);
+
+  ASSERT_EQ(transit.size(), manager.num_indices());
+  for (int from = 0; from < manager.num_indices(); ++from) {
+    for (int to = 0; to < manager.num_indices(); ++to) {
+      const int from_node = manager.IndexToNode(from).value();
+      const int to_node = manager.IndexToNode(to).value();
+      EXPECT_EQ(transit(from, to),
+                durations(from_node, to_node) + service_time[from_node]);
+    }
+  }
+}
+
+TEST(TransitMatrixTest, WithoutServiceTime) {
+  const auto durations = OrtoolsLib::DurationMatrix::fromRows({
+      {0, 7},
+      {9, 0},
+  });
+  operations_research::RoutingIndexManager manager(
+      2, 1, operations_research::RoutingNodeIndex{1});
+
+  const auto transit = OrtoolsLib::buildTransitMatrix(
+      durations, nullptr, OrtoolsLib::NodeMap(2), manager);
+
+  const int64_t node0 =
+      manager.NodeToIndex(operations_research::RoutingNodeIndex{0});
+  const int64_t node1 =
+      manager.NodeToIndex(operations_research::RoutingNodeIndex{1});
+  EXPECT_EQ(transit(node0, node1), 7);
+  EXPECT_EQ(transit(node1, node0), 9);
+}
+
+TEST(TransitMatrixTest, DuplicateAndVirtualNodes) {
+  const auto durations = OrtoolsLib::DurationMatrix::fromRows({
+      {0, 1, 2},
+      {3, 0, 4},
+      {5, 6, 0},
+  });
+  const std::vector<int64_t> service_time{0, 10, 20};
+
+  OrtoolsLib::NodeMap nodes(3);
+  const int32_t duplicate = nodes.addDuplicate(2);
+  const int32_t dummy = nodes.addVirtual();
+  operations_research::RoutingIndexManager manager(
+      nodes.size(), 1, operations_research::RoutingNodeIndex{dummy});
+
+  const auto transit = OrtoolsLib::buildTransitMatrix(durations, &service_time,
+                                                      nodes, manager);
+
+  const auto index = [&manager](int32_t node) {
+    return manager.NodeToIndex(operations_research::RoutingNodeIndex{node});
+  };
+  EXPECT_EQ(transit(index(0), index(duplicate)), 2);
+  EXPECT_EQ(transit(index(duplicate), index(1)), 6 + 20);
+  EXPECT_EQ(transit(index(1), manager.GetStartIndex(0)), 10);
+  EXPECT_EQ(transit(manager.GetStartIndex(0), index(2)), 0);
+}
+
+TEST(TransitMatrixTest, SharedMatrixIsBuiltOnce) {
+  OrtoolsLib::SharedTransitMatrix shared;
+  int builds = 0;
+  const auto build = [&builds]() {
+    ++builds;
+    return OrtoolsLib::DurationMatrix::fromRows({{0, 1}, {2, 0}});
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<std::shared_ptr<const OrtoolsLib::DurationMatrix>> seen(4);
+  for (size_t i = 0; i < seen.size(); ++i) {
+    workers.emplace_back([&, i]() { seen[i] = shared.get(build); });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  EXPECT_EQ(builds, 1);
+  for (const auto &matrix : seen) {
+    EXPECT_EQ(matrix, seen.front());
+  }
+  EXPECT_EQ((*seen.front())(1, 0), 2);
+}